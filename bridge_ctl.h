@@ -27,13 +27,42 @@
 
 struct ifdata;
 
+/* Link attributes parsed from a netlink notification.
+   Fields are -1 when the message didn't carry them. */
+struct link_attrs {
+	int is_bridge;		/* IFLA_INFO_KIND is "bridge" */
+	int stp_state;		/* IFLA_BR_STP_STATE of a bridge */
+	int port_no;		/* IFLA_BRPORT_NO of a bridge port */
+	int port_state;		/* IFLA_BRPORT_STATE of a bridge port */
+	const unsigned char *addr;	/* IFLA_ADDRESS, NULL if not present */
+};
+
 int init_bridge_ops(void);
 
 void bridge_get_configuration(void);
 
+void bridge_resync_begin(void);
+
+void bridge_resync_end(void);
+
+void bridge_stp_hold(void);
+
+void bridge_stp_release(void);
+
 int bridge_set_state(int ifindex, int state);
 
-int bridge_notify(int br_index, int if_index, int newlink, int up);
+int bridge_state_pending(int ifindex);
+
+void bridge_state_retry(void);
+
+int init_ethtool_ops(void);
+
+int ethtool_request_link_modes(int ifindex);
+
+void bridge_link_modes_notify(int if_index, int speed, int duplex);
+
+int bridge_notify(int br_index, int if_index, int newlink, int up,
+		  const struct link_attrs *attrs);
 
 void bridge_bpdu_rcv(int ifindex, const unsigned char *data, int len);
 
@@ -30,6 +30,7 @@
 #include <net/if.h>
 #include <stdlib.h>
 #include <linux/if_bridge.h>
+#include <linux/if_ether.h>
 #include <arpa/inet.h>
 #include <sys/types.h>
 
@@ -51,6 +52,7 @@ struct ifdata {
 	struct ifdata *next;
 	int up;
 	char name[IFNAMSIZ];
+	unsigned int sync_gen;	/* Resync generation it was last seen in */
 
 	int is_bridge;
 	/* If bridge */
@@ -58,6 +60,7 @@ struct ifdata {
 	struct ifdata *port_list;
 	int do_stp;
 	int stp_up;
+	int stp_state;		/* Kernel stp_state, from netlink */
 	struct stp_instance *stp;
 	UID_BRIDGE_ID_T bridge_id;
 	/* Bridge config */
@@ -68,12 +71,25 @@ struct ifdata {
 	int forward_delay;
 	int force_version;
 	int hold_time;
+	int flush_window;
+	int rx_fast;
 
 	/* If port */
 	int speed;
 	int duplex;
 	struct ifdata *master;
 	struct ifdata *port_next;
+	/* Kernel port number, from netlink */
+	int port_no;
+	/* MAC address, from netlink */
+	unsigned char macaddr[ETH_ALEN];
+	int have_macaddr;
+	/* Kernel port state: last written by us, last reported (-1 if none) */
+	int programmed_state;
+	int kernel_state;
+	unsigned long state_writes;
+	unsigned long state_suppressed;
+	unsigned long state_repairs;
 	/* STP port index */
 	int port_index;
 	/* STP port config */
@@ -90,6 +106,11 @@ struct ifdata {
 static int stp_up = 0;
 struct ifdata *current_br = NULL;
 
+/* While a netlink dump runs (startup, resync), bridges don't start STP
+   when they are seen: their ports come later in the dump. They start
+   in bridge_stp_release(), with all their ports in one call. */
+static int stp_start_held = 0;
+
 /*! \function void instance_begin(struct ifdata *br)
  *  \brief Start a new instance of STP on a bridge.
  */
@@ -133,6 +154,8 @@ UID_STP_CFG_T default_bridge_stp_cfg = {
 	.hello_time = DEF_BR_HELLOT,
 	.forward_delay = DEF_BR_FWDELAY,
 	.force_version = DEF_FORCE_VERS,	/*NORMAL_RSTP */
+	.flush_window = DEF_FLUSH_WINDOW,
+	.rx_fast = DEF_RX_FAST,
 };
 
 /*! \function void update_bridge_stp_config(struct ifdata *br, UID_STP_CFG_T *cfg)
@@ -150,6 +173,10 @@ void update_bridge_stp_config(struct ifdata *br, UID_STP_CFG_T *cfg)
 		br->forward_delay = cfg->forward_delay;
 	if (cfg->field_mask & BR_CFG_FORCE_VER)
 		br->force_version = cfg->force_version;
+	if (cfg->field_mask & BR_CFG_FLUSH_WINDOW)
+		br->flush_window = cfg->flush_window;
+	if (cfg->field_mask & BR_CFG_RX_FAST)
+		br->rx_fast = cfg->rx_fast;
 }
 
 UID_STP_PORT_CFG_T default_port_stp_cfg = {
@@ -184,7 +211,9 @@ void update_port_stp_config(struct ifdata *ifc, UID_STP_PORT_CFG_T *cfg)
  */
 int add_port_stp(struct ifdata *ifc)
 {				/* Bridge is ifc->master */
-	TST((ifc->port_index = get_bridge_portno(ifc->name)) >= 0, -1);
+	if (ifc->port_no < 0)	/* Kernel didn't report it */
+		ifc->port_no = get_bridge_portno(ifc->name);
+	TST((ifc->port_index = ifc->port_no) >= 0, -1);
 
 	/* Add port to STP */
 	instance_begin(ifc->master);
@@ -199,6 +228,7 @@ int add_port_stp(struct ifdata *ifc)
 		ERROR("Couldn't add port for ifindex %d to STP", ifc->if_index);
 		return -1;
 	}
+	INFO("%s: port %s added to STP", ifc->master->name, ifc->name);
 	return 0;
 }
 
@@ -212,6 +242,7 @@ void remove_port_stp(struct ifdata *ifc)
 	int r = STP_IN_port_delete(0, ifc->port_index);
 	instance_end();
 	ifc->port_index = -1;
+	ifc->programmed_state = -1;	/* Not ours to keep any more */
 	if (r != 0) {
 		ERROR("removing port %s failed for bridge %s: %s",
 		      ifc->name, ifc->master->name,
@@ -274,22 +305,45 @@ int init_bridge_stp(struct ifdata *br)
 	/* Init STP state */
 	TST(init_rstplib_instance(br) == 0, -1);
 
-	struct ifdata *p = br->port_list;
-	while (p) {
-		if (add_port_stp(p) != 0)
+	/* Add all the ports at once: one bridge ID and one start for all */
+	BITMAP_T ports;
+	BitmapClear(&ports);
+	struct ifdata *p;
+	int n = 0;
+	for (p = br->port_list; p; p = p->port_next) {
+		if (p->port_no < 0)	/* Kernel didn't report it */
+			p->port_no = get_bridge_portno(p->name);
+		if (p->port_no <= 0 || p->port_no > UID_PORT_ID_MAX_NUMBER) {
+			ERROR("Bad port number %d for %s", p->port_no, p->name);
 			break;
-		p = p->port_next;
+		}
+		BitmapSetBit(&ports, p->port_no - 1);
+		p->port_index = p->port_no;	/* the create names the ports */
+		n++;
 	}
-	if (p) {
-		struct ifdata *q = br->port_list;
-		while (q != p) {
-			remove_port_stp(q);
-			q = q->port_next;
+
+	int r = -1;
+	if (!p) {
+		instance_begin(br);
+		r = STP_IN_ports_create_bulk(0, &ports);
+		if (r == 0) {	/* Update bridge ID */
+			UID_STP_STATE_T state;
+			STP_IN_stpm_get_state(0, &state);
+			br->bridge_id = state.bridge_id;
 		}
+		instance_end();
+		if (r != 0)
+			ERROR("Couldn't add ports of bridge %s to STP: %s",
+			      br->name, STP_IN_get_error_explanation(r));
+	}
+	if (r != 0) {
 		/* Clear bridge STP state */
+		for (p = br->port_list; p; p = p->port_next)
+			p->port_index = -1;
 		clear_rstplib_instance(br);
 		return -1;
 	}
+	INFO("%s: STP started with %d ports", br->name, n);
 	br->stp_up = 1;
 	return 0;
 }
@@ -375,16 +429,17 @@ struct ifdata *create_if(int if_index, struct ifdata *br)
 	} else {
 		INFO("Add iface %s to bridge %s", p->name, br->name);
 		p->up = 0;
-		p->speed = 0;
+		p->speed = 10;	/* Until we hear otherwise */
 		p->duplex = 0;
 		p->master = br;
+		p->port_no = -1;
+		p->port_index = -1;
+		p->programmed_state = -1;
+		p->kernel_state = -1;
 
 		update_port_stp_config(p, &default_port_stp_cfg);
 		ADD_TO_LIST(br->port_list, port_next, p);	/* Add to bridge port list */
-
-		if (br->stp_up) {
-			add_port_stp(p);
-		}
+		/* Caller adds the port to STP once it knows the port number */
 	}
 
 	/* Add to interface list */
@@ -425,37 +480,12 @@ void delete_if(struct ifdata *ifc)
 	free(ifc);
 }
 
-/*! \function static int stp_enabled(struct ifdata *br)
- *  \brief Check if STP is enabled on a bridge.
- */
-static int stp_enabled(struct ifdata *br)
-{
-	char path[40 + IFNAMSIZ];
-	int ret;
-	sprintf(path, "/sys/class/net/%s/bridge/stp_state", br->name);
-	FILE *f = fopen(path, "r");
-	if (!f) {
-		LOG("Open %s failed", path);
-		return 0;
-	}
-	int enabled = 0;
-	ret = fscanf(f, "%d", &enabled);
-	if (!ret) {
-		LOG("%s, stp_state parsing error", path);
-		return 0;
-	}
-	fclose(f);
-	INFO("STP on %s state %d", br->name, enabled);
-
-	return enabled == 2;	/* ie user mode STP */
-}
-
 /*! \function void set_br_up(struct ifdata *br, int up)
  *  \brief Bring up bridge inteface if it is down.
  */
 void set_br_up(struct ifdata *br, int up)
 {
-	int stp_up = stp_enabled(br);
+	int stp_up = (br->stp_state == 2);	/* ie user mode STP */
 	INFO("%s was %s stp was %s", br->name,up ? "up" : "down", br->stp_up ? "up" : "down");
 	INFO("Set bridge %s %s stp %s" , br->name,
 	     up ? "up" : "down", stp_up ? "up" : "down");
@@ -464,67 +494,194 @@ void set_br_up(struct ifdata *br, int up)
 		br->up = up;
 	
 	if (br->stp_up != stp_up) {
-		if (stp_up)
-			init_bridge_stp(br);
-		else 
+		if (!stp_up)
 			clear_bridge_stp(br);
+		else if (!stp_start_held)
+			init_bridge_stp(br);
 	}
 }
 
+/*! \function void set_port_speed_duplex(struct ifdata *ifc, int speed, int duplex)
+ *  \brief Record port speed and duplex, and tell STP if they changed.
+ */
+static void set_port_speed_duplex(struct ifdata *ifc, int speed, int duplex)
+{
+	int speed_changed = (speed != ifc->speed);
+	int duplex_changed = (duplex != ifc->duplex);
+
+	ifc->speed = speed;
+	ifc->duplex = duplex;
+	if (!ifc->master->stp_up || ifc->port_index < 0)
+		return;
+
+	instance_begin(ifc->master);
+	if (speed_changed)
+		STP_IN_changed_port_speed(ifc->port_index, speed);
+	if (duplex_changed)
+		STP_IN_changed_port_duplex(ifc->port_index);
+	instance_end();
+}
+
+/*! \function void set_port_macaddr(struct ifdata *ifc, const unsigned char *addr)
+ *  \brief Record the MAC address of a port, as reported by the kernel.
+ */
+static void set_port_macaddr(struct ifdata *ifc, const unsigned char *addr)
+{
+	if (!addr)
+		return;
+	memcpy(ifc->macaddr, addr, ETH_ALEN);
+	ifc->have_macaddr = 1;
+}
+
+/*! \function void port_macaddr_changed(struct ifdata *ifc)
+ *  \brief Let STP recompute the bridge ID, if this changes the lowest port MAC.
+ */
+static void port_macaddr_changed(struct ifdata *ifc)
+{
+	UID_STP_STATE_T state;
+
+	instance_begin(ifc->master);
+	STP_IN_changed_port_mac(ifc->port_index);
+	if (STP_IN_stpm_get_state(0, &state) == 0)
+		ifc->master->bridge_id = state.bridge_id;
+	instance_end();
+}
+
 /*! \function void set_if_up(struct ifdata *ifc, int up)
  *  \brief Bring up a port on the bridge if it is down.
  */
 void set_if_up(struct ifdata *ifc, int up)
 {
 	INFO("Port %s : %s", ifc->name, (up ? "up" : "down"));
-	int speed = -1;
-	int duplex = -1;
-	int notify_flags = 0;
-	const int NOTIFY_UP = 1, NOTIFY_SPEED = 2, NOTIFY_DUPLEX = 4;
-	if (!up) {		/* Down */
-		if (ifc->up) {
-			ifc->up = up;
-			notify_flags |= NOTIFY_UP;
-		}
-	} else {		/* Up */
-		int r = ethtool_get_speed_duplex(ifc->name, &speed, &duplex);
-		if (r < 0) {	/* Didn't succeed */
-		}
+	if (up == ifc->up)
+		return;
+
+	if (up && ethtool_request_link_modes(ifc->if_index) < 0) {
+		/* No ethtool netlink, ask the old way */
+		int speed = -1;
+		int duplex = -1;
+		ethtool_get_speed_duplex(ifc->name, &speed, &duplex);
 		if (speed < 0)
 			speed = 10;
 		if (duplex < 0)
 			duplex = 0;	/* Assume half duplex */
-
-		if (speed != ifc->speed) {
-			ifc->speed = speed;
-			notify_flags |= NOTIFY_SPEED;
-		}
-		if (duplex != ifc->duplex) {
-			ifc->duplex = duplex;
-			notify_flags |= NOTIFY_DUPLEX;
-		}
-		if (!ifc->up) {
-			ifc->up = 1;
-			notify_flags |= NOTIFY_UP;
-		}
+		set_port_speed_duplex(ifc, speed, duplex);
 	}
-	if (notify_flags && ifc->master->stp_up) {
-		instance_begin(ifc->master);
-
-		if (notify_flags & NOTIFY_SPEED)
-			STP_IN_changed_port_speed(ifc->port_index, speed);
-		if (notify_flags & NOTIFY_DUPLEX)
-			STP_IN_changed_port_duplex(ifc->port_index);
-		if (notify_flags & NOTIFY_UP)
-			STP_IN_enable_port(ifc->port_index, ifc->up);
+	/* Otherwise speed and duplex arrive in bridge_link_modes_notify() */
 
+	ifc->up = up;
+	if (ifc->master->stp_up && ifc->port_index >= 0) {
+		instance_begin(ifc->master);
+		STP_IN_enable_port(ifc->port_index, ifc->up);
 		instance_end();
 	}
 }
 
+/*! \function void program_port_state(struct ifdata *ifc, int state)
+ *  \brief Write port state to the kernel, unless it is there already.
+ */
+static void program_port_state(struct ifdata *ifc, int state)
+{
+	if (!ifc->up) {		/* Kernel keeps it disabled till it is up */
+		ifc->programmed_state = state;
+		return;
+	}
+	if (state == ifc->programmed_state && state == ifc->kernel_state) {
+		ifc->state_suppressed++;
+		return;
+	}
+	ifc->programmed_state = state;
+	ifc->state_writes++;
+	bridge_set_state(ifc->if_index, state);
+}
+
+/*! \function void set_port_kernel_state(struct ifdata *ifc, int state)
+ *  \brief Record port state reported by the kernel, repair it if it drifted.
+ */
+static void set_port_kernel_state(struct ifdata *ifc, int state)
+{
+	ifc->kernel_state = state;
+	if (!ifc->up || ifc->programmed_state < 0 ||
+	    state == ifc->programmed_state ||
+	    bridge_state_pending(ifc->if_index))
+		return;
+
+	INFO("Port %s in state %d, should be %d. Repairing",
+	     ifc->name, state, ifc->programmed_state);
+	ifc->state_repairs++;
+	ifc->state_writes++;
+	bridge_set_state(ifc->if_index, ifc->programmed_state);
+}
+
+/*! \function void bridge_link_modes_notify(int if_index, int speed, int duplex)
+ *  \brief Speed and duplex reported through ethtool netlink, -1 if unknown.
+ */
+void bridge_link_modes_notify(int if_index, int speed, int duplex)
+{
+	struct ifdata *ifc = find_if(if_index);
+
+	if (!ifc || ifc->is_bridge)
+		return;
+	LOG("Port %s speed %d duplex %d", ifc->name, speed, duplex);
+	/* Unknown while the link is down, keep what we had */
+	if (speed < 0)
+		speed = ifc->speed;
+	if (duplex < 0)
+		duplex = ifc->duplex;
+	set_port_speed_duplex(ifc, speed, duplex);
+}
+
 /*------------------------------------------------------------*/
 
-int bridge_notify(int br_index, int if_index, int newlink, int up)
+/* Interfaces seen in netlink messages are stamped with the current
+   generation, so after a resync we know which ones the kernel no
+   longer has. */
+static unsigned int sync_gen = 0;
+
+void bridge_stp_hold(void)
+{
+	stp_start_held = 1;
+}
+
+void bridge_stp_release(void)
+{
+	struct ifdata *br;
+
+	if (!stp_start_held)
+		return;
+	stp_start_held = 0;
+	for (br = br_head; br; br = br->bridge_next) {
+		if (br->stp_state == 2 && !br->stp_up)
+			init_bridge_stp(br);
+	}
+}
+
+void bridge_resync_begin(void)
+{
+	sync_gen++;
+	INFO("generation %u", sync_gen);
+	bridge_stp_hold();
+}
+
+void bridge_resync_end(void)
+{
+	struct ifdata *ifc;
+
+ restart:
+	for (ifc = if_head; ifc; ifc = ifc->next) {
+		if (ifc->sync_gen != sync_gen) {
+			INFO("Missed deletion of %s", ifc->name);
+			/* Deleting a bridge deletes its ports too */
+			delete_if(ifc);
+			goto restart;
+		}
+	}
+	bridge_state_retry();
+	bridge_stp_release();
+}
+
+int bridge_notify(int br_index, int if_index, int newlink, int up,
+		  const struct link_attrs *attrs)
 {
 	if (up)
 		up = 1;
@@ -546,6 +703,7 @@ int bridge_notify(int br_index, int if_index, int newlink, int up)
 			      br_index);
 			return -1;
 		}
+		br->sync_gen = sync_gen;
 		/* Bridge must be up if we get such notifications */
 		if (!br->up)
 			set_br_up(br, 1);
@@ -569,14 +727,26 @@ int bridge_notify(int br_index, int if_index, int newlink, int up)
 				ifc = NULL;
 			}
 		}
-		if (!ifc)
-			ifc = create_if(if_index, br);
 		if (!ifc) {
-			ERROR
-			    ("Couldn't create data for interface %d (master %d)",
-			     if_index, br_index);
-			return -1;
+			ifc = create_if(if_index, br);
+			if (!ifc) {
+				ERROR
+				    ("Couldn't create data for interface %d (master %d)",
+				     if_index, br_index);
+				return -1;
+			}
+			ifc->port_no = attrs->port_no;
+			set_port_macaddr(ifc, attrs->addr);
+			if (br->stp_up)
+				add_port_stp(ifc);
+		} else if (attrs->addr &&
+			   (!ifc->have_macaddr ||
+			    memcmp(ifc->macaddr, attrs->addr, ETH_ALEN))) {
+			set_port_macaddr(ifc, attrs->addr);
+			if (br->stp_up && ifc->port_index >= 0)
+				port_macaddr_changed(ifc);
 		}
+		ifc->sync_gen = sync_gen;
 		if (!newlink && !is_bridge_slave(br->name, ifc->name)) {
 			/* brctl delif generates a DELLINK, but so does ifconfig <slave> down.
 			   So check and delete if it has been removed.
@@ -586,6 +756,8 @@ int bridge_notify(int br_index, int if_index, int newlink, int up)
 		}
 		if (ifc->up != up)
 			set_if_up(ifc, up);	/* And speed and duplex */
+		if (attrs->port_state >= 0)
+			set_port_kernel_state(ifc, attrs->port_state);
 	} else {		/* No br_index */
 		if (!newlink) {
 			/* DELLINK not from bridge means interface unregistered. */
@@ -594,10 +766,11 @@ int bridge_notify(int br_index, int if_index, int newlink, int up)
 				delete_if(ifc);
 			return 0;
 		} else {	/* This may be a new link */
-			if (!ifc) {
+			if (!ifc && attrs->is_bridge != 0) {
 				char ifname[IFNAMSIZ];
-				if (if_indextoname(if_index, ifname)
-				    && is_bridge(ifname)) {
+				if (attrs->is_bridge == 1
+				    || (if_indextoname(if_index, ifname)
+					&& is_bridge(ifname))) {
 					ifc = create_if(if_index, NULL);
 					if (!ifc) {
 						ERROR
@@ -607,17 +780,23 @@ int bridge_notify(int br_index, int if_index, int newlink, int up)
 					}
 				}
 			}
-			if (ifc && !ifc->is_bridge &&
-			    !is_bridge_slave(ifc->master->name, ifc->name)) {
-				/* Interface might have left bridge and we might have missed deletion */
+			if (ifc && !ifc->is_bridge) {
+				/* Enslaved ports always come with IFLA_MASTER,
+				   so it has left the bridge and we missed
+				   the deletion */
 				delete_if(ifc);
 				return 0;
 			}
-			if (ifc && ifc->up != up) {
-				if (ifc->is_bridge)
+			if (ifc) {	/* Bridge */
+				int changed = (ifc->up != up);
+				ifc->sync_gen = sync_gen;
+				if (attrs->stp_state >= 0 &&
+				    attrs->stp_state != ifc->stp_state) {
+					ifc->stp_state = attrs->stp_state;
+					changed = 1;
+				}
+				if (changed)
 					set_br_up(ifc, up);
-				else
-					set_if_up(ifc, up);
 			}
 		}
 	}
@@ -653,7 +832,7 @@ void bridge_bpdu_rcv(int if_index, const unsigned char *data, int len)
 			//    TST(ntohs(*(uint16_t*)bpdu.body.message_age)
 			//        < ntohs(*(uint16_t*)bpdu.body.max_age), );
 			TST(memcmp(bpdu->body.bridge_id, &ifc->master->bridge_id, 8) != 0
-			    || (ntohs(*(uint16_t *) bpdu->body.port_id) & 0xfff) !=
+			    || UID_PORT_ID_NUMBER(ntohs(*(uint16_t *) bpdu->body.port_id)) !=
 			    ifc->port_index,);
 			break;
 		case BPDU_TOPO_CHANGE_TYPE:
@@ -677,6 +856,7 @@ void bridge_one_second(void)
 {
 	//  LOG("");
 	struct ifdata *br;
+	bridge_state_retry();	/* Port states the socket didn't take */
 	for (br = br_head; br; br = br->bridge_next) {
 		if (br->stp_up) {
 			instance_begin(br);
@@ -684,14 +864,6 @@ void bridge_one_second(void)
 			instance_end();
 		}
 	}
-
-	/* To get information about port changes when bridge is down */
-	/* But won't work so well since we will not sense deletions */
-	static int count = 0;
-	count++;
-	if (count % 60 == 0)
-		bridge_get_configuration();
-
 }
 
 /* Implementing STP_OUT functions */
@@ -741,6 +913,41 @@ STP_OUT_flush_lt(IN int port_index, IN int vlan_id,
 	return 0;
 }
 
+int STP_OUT_flush_ports(IN int vlan_id, IN BITMAP_T *ports, IN char *reason)
+{
+	LOG("%d ports, reason %s", BitmapCount(ports), reason);
+	TST(vlan_id == 0, 0);
+
+	char fname[128];
+	struct ifdata *port;
+	int all = 1;
+	for (port = current_br->port_list; port; port = port->port_next) {
+		if (port->port_index <= 0 || port->port_index > BITMAP_BITS ||
+		    !BitmapGetBit(ports, port->port_index - 1)) {
+			all = 0;
+			break;
+		}
+	}
+
+	if (all) {	/* one write for the whole bridge */
+		sprintf(fname, "/sys/class/net/%s/bridge/flush",
+			current_br->name);
+		flush_port(fname);
+		return 0;
+	}
+
+	for (port = current_br->port_list; port; port = port->port_next) {
+		if (port->port_index > 0 && port->port_index <= BITMAP_BITS &&
+		    BitmapGetBit(ports, port->port_index - 1)) {
+			sprintf(fname, "/sys/class/net/%s/brif/%s/flush",
+				current_br->name, port->name);
+			flush_port(fname);
+		}
+	}
+
+	return 0;
+}
+
 /* for bridge id calculation */
 void STP_OUT_get_port_mac(IN int port_index,
 			  OUT unsigned char *mac)
@@ -749,7 +956,11 @@ void STP_OUT_get_port_mac(IN int port_index,
 	struct ifdata *port = find_port(port_index);
 	
 	TST(port != NULL,);
-	get_hwaddr(port->name, mac);
+	if (!port->have_macaddr) {	/* Not heard from netlink yet */
+		TST(get_hwaddr(port->name, port->macaddr) == 0,);
+		port->have_macaddr = 1;
+	}
+	memcpy(mac, port->macaddr, ETH_ALEN);
 }
 
 unsigned long STP_OUT_get_port_oper_speed(IN unsigned int port_index)
@@ -810,8 +1021,7 @@ int STP_OUT_set_port_state(IN int port_index, IN int vlan_id,
 			fprintf(stderr, "set_port_state: Unexpected state %d\n", state);
 			return -1;
 	}
-	if (port->up)
-		bridge_set_state(port->if_index, br_state);
+	program_port_state(port, br_state);
 	return 0;
 }
 
@@ -876,6 +1086,8 @@ int STP_OUT_get_init_stpm_cfg(IN int vlan_id, INOUT UID_STP_CFG_T * cfg)
 	cfg->hello_time = current_br->hello_time;
 	cfg->forward_delay = current_br->forward_delay;
 	cfg->force_version = current_br->force_version;
+	cfg->flush_window = current_br->flush_window;
+	cfg->rx_fast = current_br->rx_fast;
 
 	return 0;
 }
@@ -1042,6 +1254,45 @@ int CTL_set_port_config(int br_index, int port_index, UID_STP_PORT_CFG_T * cfg)
 	return 0;
 }
 
+int CTL_get_port_kernel_state(int br_index, int port_index,
+			      struct port_kernel_state *ks)
+{
+	LOG("bridge %d port %d", br_index, port_index);
+	CTL_CHECK_BRIDGE_PORT;
+	ks->programmed = port->programmed_state;
+	ks->reported = port->kernel_state;
+	ks->writes = port->state_writes;
+	ks->suppressed = port->state_suppressed;
+	ks->repairs = port->state_repairs;
+	return 0;
+}
+
+int CTL_set_trace(int br_index, int port_index, const char *mach_name,
+		  int enable)
+{
+	INFO("bridge %d, port %d, %s %s", br_index, port_index, mach_name,
+	     enable ? "on" : "off");
+	CTL_CHECK_BRIDGE;
+	char name[16];
+	int lib_port_index = 0;
+	int r;
+	if (port_index) {
+		struct ifdata *port = find_if(port_index);
+		if (port == NULL || port->is_bridge || port->master != br)
+			return Err_Port_does_not_belong_to_bridge;
+		lib_port_index = port->port_index;
+	}
+	strncpy(name, mach_name, sizeof(name) - 1);
+	name[sizeof(name) - 1] = 0;
+	instance_begin(br);
+	r = STP_IN_set_trace(0, lib_port_index, name, enable);
+	instance_end();
+	if (r)
+		ERROR("Error setting trace of %s for bridge %d: %s", name,
+		      br_index, STP_IN_get_error_explanation(r));
+	return r;
+}
+
 int CTL_set_debug_level(int level)
 {
 	INFO("level %d", level);
@@ -15,6 +15,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <errno.h>
 #include <syslog.h>
 #include <fcntl.h>
 #include <sys/socket.h>
@@ -22,6 +23,7 @@
 #include <net/if.h>
 #include <netinet/in.h>
 #include <linux/if_bridge.h>
+#include <linux/if_ether.h>
 #include <string.h>
 
 #include "libnetlink.h"
@@ -57,6 +59,55 @@ static const char *port_states[] = {
 };
 
 
+static void resync_dump_done(struct nlmsghdr *n);
+
+/* Pick out the attributes bridge_track.c caches in ifdata */
+static void parse_link_attrs(struct rtattr *tb[], struct link_attrs *attrs)
+{
+	struct rtattr *info[IFLA_INFO_MAX + 1];
+	struct rtattr *br[IFLA_BR_MAX + 1];
+
+	attrs->is_bridge = -1;
+	attrs->stp_state = -1;
+	attrs->port_no = -1;
+	attrs->port_state = -1;
+	attrs->addr = NULL;
+
+	if (tb[IFLA_ADDRESS] && RTA_PAYLOAD(tb[IFLA_ADDRESS]) == ETH_ALEN)
+		attrs->addr = RTA_DATA(tb[IFLA_ADDRESS]);
+
+	if (tb[IFLA_PROTINFO]) {
+		/* Older kernels send just the port state here */
+		if (RTA_PAYLOAD(tb[IFLA_PROTINFO]) == sizeof(__u8))
+			attrs->port_state =
+			    *(__u8 *) RTA_DATA(tb[IFLA_PROTINFO]);
+		else {
+			struct rtattr *brport[IFLA_BRPORT_MAX + 1];
+			parse_rtattr_nested(brport, IFLA_BRPORT_MAX,
+					    tb[IFLA_PROTINFO]);
+			if (brport[IFLA_BRPORT_STATE])
+				attrs->port_state = *(__u8 *)
+				    RTA_DATA(brport[IFLA_BRPORT_STATE]);
+			if (brport[IFLA_BRPORT_NO])
+				attrs->port_no = *(__u16 *)
+				    RTA_DATA(brport[IFLA_BRPORT_NO]);
+		}
+	}
+
+	if (!tb[IFLA_LINKINFO])
+		return;
+	parse_rtattr_nested(info, IFLA_INFO_MAX, tb[IFLA_LINKINFO]);
+	if (!info[IFLA_INFO_KIND])
+		return;
+	attrs->is_bridge = !strcmp(RTA_DATA(info[IFLA_INFO_KIND]), "bridge");
+	if (!attrs->is_bridge || !info[IFLA_INFO_DATA])
+		return;
+
+	parse_rtattr_nested(br, IFLA_BR_MAX, info[IFLA_INFO_DATA]);
+	if (br[IFLA_BR_STP_STATE])
+		attrs->stp_state = *(__u32 *) RTA_DATA(br[IFLA_BR_STP_STATE]);
+}
+
 static int dump_msg(const struct sockaddr_nl *who, struct nlmsghdr *n,
 		    void *arg)
 {
@@ -66,9 +117,12 @@ static int dump_msg(const struct sockaddr_nl *who, struct nlmsghdr *n,
 	int len = n->nlmsg_len;
 	char b1[IFNAMSIZ];
 	int af_family = ifi->ifi_family;
+	struct link_attrs attrs;
 
-        if (n->nlmsg_type == NLMSG_DONE)
+        if (n->nlmsg_type == NLMSG_DONE || n->nlmsg_type == NLMSG_ERROR) {
+          resync_dump_done(n);
           return 0;
+        }
         
 	len -= NLMSG_LENGTH(sizeof(*ifi));
 	if (len < 0) {
@@ -104,6 +158,8 @@ static int dump_msg(const struct sockaddr_nl *who, struct nlmsghdr *n,
           return 0;
         }
 
+	parse_link_attrs(tb, &attrs);
+
 	if (tb[IFLA_IFNAME] == NULL) {
 		fprintf(stderr, "BUG: nil ifname\n");
 		return -1;
@@ -146,12 +202,11 @@ static int dump_msg(const struct sockaddr_nl *who, struct nlmsghdr *n,
 			if_indextoname(*(int*)RTA_DATA(tb[IFLA_MASTER]), b1));
 	}
 
-	if (tb[IFLA_PROTINFO]) {
-		uint8_t state = *(uint8_t *)RTA_DATA(tb[IFLA_PROTINFO]);
-		if (state <= BR_STATE_BLOCKING)
-			fprintf(fp, "state %s", port_states[state]);
+	if (attrs.port_state >= 0) {
+		if (attrs.port_state <= BR_STATE_BLOCKING)
+			fprintf(fp, "state %s", port_states[attrs.port_state]);
 		else
-			fprintf(fp, "state (%d)", state);
+			fprintf(fp, "state (%d)", attrs.port_state);
 	}
 
 
@@ -166,7 +221,7 @@ static int dump_msg(const struct sockaddr_nl *who, struct nlmsghdr *n,
           }
 
           bridge_notify((tb[IFLA_MASTER]?*(int*)RTA_DATA(tb[IFLA_MASTER]):-1), 
-                        ifi->ifi_index, newlink, up);
+                        ifi->ifi_index, newlink, up, &attrs);
         }
 	return 0;
 }
@@ -245,12 +300,21 @@ struct rtnl_handle rth;
 struct epoll_event_handler br_handler;
 
 struct rtnl_handle rth_state;
+struct epoll_event_handler br_state_handler;
+
+extern void bridge_state_ev_handler(uint32_t events,
+				    struct epoll_event_handler *h);
 
 void br_ev_handler(uint32_t events, struct epoll_event_handler *h)
 {
-  if (rtnl_listen(&rth, dump_msg, stdout) < 0) {
-    fprintf(stderr, "Error on bridge monitoring socket\n");
-    exit(-1);
+  while (rtnl_listen(&rth, dump_msg, stdout) < 0) {
+    if (errno != ENOBUFS) {
+      fprintf(stderr, "Error on bridge monitoring socket\n");
+      exit(-1);
+    }
+    /* The kernel dropped notifications, we can't tell which */
+    fprintf(stderr, "Lost link notifications, resyncing\n");
+    bridge_get_configuration();
   }
 }
 
@@ -266,6 +330,19 @@ int init_bridge_ops(void)
     return -1;
   }
 
+  /* Generic link info first, it carries the bridges' stp_state; the
+     bridges start STP after the port dump, with all their ports */
+  bridge_stp_hold();
+  if (rtnl_wilddump_request(&rth, AF_UNSPEC, RTM_GETLINK) < 0) {
+    fprintf(stderr, "Cannot send dump request: %m\n");
+    return -1;
+  }
+  
+  if (rtnl_dump_filter(&rth, dump_msg, stdout, NULL, NULL) < 0) {
+    fprintf(stderr, "Dump terminated\n");
+    return -1;
+  }
+
   if (rtnl_wilddump_request(&rth, PF_BRIDGE, RTM_GETLINK) < 0) {
     fprintf(stderr, "Cannot send dump request: %m\n");
     return -1;
@@ -275,6 +352,7 @@ int init_bridge_ops(void)
     fprintf(stderr, "Dump terminated\n");
     return -1;
   }
+  bridge_stp_release();
 
   if (fcntl(rth.fd, F_SETFL, O_NONBLOCK) < 0) {
     fprintf(stderr, "Error setting O_NONBLOCK: %m\n");
@@ -287,14 +365,83 @@ int init_bridge_ops(void)
   
   if (add_epoll(&br_handler) < 0)
     return -1;
+
+  /* State changes are acked asynchronously, see brstate.c */
+  if (fcntl(rth_state.fd, F_SETFL, O_NONBLOCK) < 0) {
+    fprintf(stderr, "Error setting O_NONBLOCK: %m\n");
+    return -1;
+  }
+
+  br_state_handler.fd = rth_state.fd;
+  br_state_handler.arg = NULL;
+  br_state_handler.handler = bridge_state_ev_handler;
+
+  if (add_epoll(&br_state_handler) < 0)
+    return -1;
   
   return 0;
 }
 
+/* Resync is done only after notifications were lost. It dumps the
+   generic link info (for bridges) and then the bridge port info on the
+   monitoring socket, one dump at a time. The responses go through
+   bridge_notify, which only acts on differences from what we have;
+   whatever wasn't seen by the end is gone and gets deleted. */
+enum {
+  RESYNC_NONE,
+  RESYNC_LINKS,
+  RESYNC_PORTS,
+};
+
+static int resync_phase = RESYNC_NONE;
+static int resync_again = 0;
+
+static void resync_request(int phase)
+{
+  int family = (phase == RESYNC_LINKS) ? AF_UNSPEC : PF_BRIDGE;
+
+  resync_phase = phase;
+  if (rtnl_wilddump_request(&rth, family, RTM_GETLINK) < 0) {
+    fprintf(stderr, "Cannot send dump request: %m\n");
+    resync_phase = RESYNC_NONE;
+    bridge_stp_release();
+  }
+}
+
+static void resync_dump_done(struct nlmsghdr *n)
+{
+  if (resync_phase == RESYNC_NONE || n->nlmsg_seq != rth.dump)
+    return;
+
+  if (n->nlmsg_type == NLMSG_ERROR) {
+    struct nlmsgerr *err = NLMSG_DATA(n);
+    fprintf(stderr, "Resync dump failed: %s\n", strerror(-err->error));
+    resync_phase = RESYNC_NONE;
+    bridge_stp_release();
+    return;
+  }
+
+  if (resync_again) {
+    /* More notifications were lost meanwhile, start over */
+    resync_again = 0;
+    bridge_resync_begin();
+    resync_request(RESYNC_LINKS);
+  } else if (resync_phase == RESYNC_LINKS) {
+    resync_request(RESYNC_PORTS);
+  } else {
+    resync_phase = RESYNC_NONE;
+    bridge_resync_end();
+  }
+}
+
 /* Send message. Response is through bridge_notify */
 void bridge_get_configuration(void)
 {
-  if (rtnl_wilddump_request(&rth, PF_BRIDGE, RTM_GETLINK) < 0) {
-    fprintf(stderr, "Cannot send dump request: %m\n");
+  if (resync_phase != RESYNC_NONE) {
+    /* Only one dump at a time on a socket */
+    resync_again = 1;
+    return;
   }
+  bridge_resync_begin();
+  resync_request(RESYNC_LINKS);
 }
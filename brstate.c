@@ -26,7 +26,49 @@
 
 #include "libnetlink.h"
 
-static int br_set_state(struct rtnl_handle *rth, unsigned ifindex, __u8 state)
+#include "bridge_ctl.h"
+#include "epoll_loop.h"
+#include "log.h"
+
+extern struct rtnl_handle rth_state;
+
+/* State changes are not waited for. Each request is sent with NLM_F_ACK
+   and remembered here until its reply comes back on rth_state, which is
+   serviced from the epoll loop. The kernel answers requests in the order
+   they were sent, so the ring is kept in sequence order and replies are
+   matched against its tail. A request the socket doesn't take (EAGAIN,
+   ENOBUFS) stays at the head of the ring, unsent; it and the ones after
+   it are sent in order, when the socket takes them again. */
+
+#define MAX_PENDING 256		/* Must be a power of 2 */
+#define MAX_STATE_RETRIES 3
+
+struct pending_req {
+	__u32 seq;
+	int ifindex;
+	__u8 state;		/* State we want the port to be in */
+	__u8 query;		/* RTM_GETLINK sent to check the kernel state */
+	__u8 retries;
+};
+
+static struct pending_req pending[MAX_PENDING];
+/* Sent, waiting for a reply: [pending_tail, pending_unsent);
+   not sent yet: [pending_unsent, pending_head) */
+static unsigned int pending_head, pending_unsent, pending_tail;
+static int draining;
+
+#define PENDING_COUNT (pending_head - pending_tail)
+#define SENT_COUNT (pending_unsent - pending_tail)
+#define PENDING(i) (pending[(i) & (MAX_PENDING - 1)])
+
+static inline int seq_before(__u32 a, __u32 b)
+{
+	return (int)(a - b) < 0;
+}
+
+static void state_drain(void);
+
+static int send_request(struct pending_req *p)
 {
 	struct {
 		struct nlmsghdr n;
@@ -37,28 +79,254 @@ static int br_set_state(struct rtnl_handle *rth, unsigned ifindex, __u8 state)
 	memset(&req, 0, sizeof(req));
 
 	req.n.nlmsg_len = NLMSG_LENGTH(sizeof(struct ifinfomsg));
-	req.n.nlmsg_flags = NLM_F_REQUEST | NLM_F_REPLACE;
-	req.n.nlmsg_type = RTM_SETLINK;
 	req.ifi.ifi_family = AF_BRIDGE;
-	req.ifi.ifi_index = ifindex;
+	req.ifi.ifi_index = p->ifindex;
+	if (p->query) {
+		req.n.nlmsg_flags = NLM_F_REQUEST;
+		req.n.nlmsg_type = RTM_GETLINK;
+	} else {
+		req.n.nlmsg_flags = NLM_F_REQUEST | NLM_F_REPLACE | NLM_F_ACK;
+		req.n.nlmsg_type = RTM_SETLINK;
+		addattr32(&req.n, sizeof(req.buf), IFLA_PROTINFO, p->state);
+	}
+	req.n.nlmsg_seq = ++rth_state.seq;
 
-	addattr32(&req.n, sizeof(req.buf), IFLA_PROTINFO, state);
+	if (rtnl_send(&rth_state, (const char *)&req.n, req.n.nlmsg_len) < 0)
+		return -1;
+	p->seq = req.n.nlmsg_seq;
+	return 0;
+}
 
-	return rtnl_talk(rth, &req.n, 0, 0, NULL, NULL, NULL);
+/* Send the unsent requests, oldest first, till the socket refuses one */
+static void send_unsent(void)
+{
+	while (pending_unsent != pending_head) {
+		if (send_request(&PENDING(pending_unsent)) < 0) {
+			LOG("%u requests still unsent: %m",
+			    pending_head - pending_unsent);
+			return;
+		}
+		pending_unsent++;
+	}
 }
 
-#include "bridge_ctl.h"
+static int queue_request(int ifindex, __u8 state, int query, int retries)
+{
+	struct pending_req *p;
 
-extern struct rtnl_handle rth_state;
+	if (PENDING_COUNT == MAX_PENDING && !draining)
+		state_drain();
+	if (PENDING_COUNT == MAX_PENDING) {
+		p = &PENDING(pending_tail);
+		if (pending_tail == pending_unsent) {
+			ERROR("Too many requests unsent, dropping state %d "
+			      "for ifindex %d", p->state, p->ifindex);
+			pending_unsent++;
+		} else
+			LOG("Too many requests outstanding, not tracking seq %u",
+			    p->seq);
+		pending_tail++;
+	}
 
-int bridge_set_state(int ifindex, int brstate)
+	p = &PENDING(pending_head++);
+	p->ifindex = ifindex;
+	p->state = state;
+	p->query = query;
+	p->retries = retries;
+
+	if (pending_unsent + 1 != pending_head) {
+		/* Older ones wait, this one can't pass them */
+		send_unsent();
+		return 0;
+	}
+	if (send_request(p) < 0) {
+		ERROR("Couldn't send request for ifindex %d: %m. Will retry",
+		      ifindex);
+		return 0;
+	}
+	pending_unsent++;
+	return 0;
+}
+
+static int br_set_state(unsigned ifindex, __u8 state, int retries)
+{
+	return queue_request(ifindex, state, 0, retries);
+}
+
+static int br_query_state(unsigned ifindex, __u8 state, int retries)
+{
+	return queue_request(ifindex, state, 1, retries);
+}
+
+/* Port state as reported by the kernel in a RTM_NEWLINK, -1 if absent */
+static int kernel_port_state(struct nlmsghdr *n)
 {
-	int err = br_set_state(&rth_state, ifindex, brstate);
-	if (err < 0) {
-		fprintf(stderr,
-			"Couldn't set bridge state, ifindex %d, state %d\n",
-			ifindex, brstate);
+	struct ifinfomsg *ifi = NLMSG_DATA(n);
+	struct rtattr *tb[IFLA_MAX + 1];
+	struct rtattr *info[IFLA_INFO_MAX + 1];
+	struct rtattr *brport[IFLA_BRPORT_MAX + 1];
+	struct rtattr *rta = NULL;
+	int len = n->nlmsg_len - NLMSG_LENGTH(sizeof(*ifi));
+
+	if (len < 0)
+		return -1;
+	parse_rtattr(tb, IFLA_MAX, IFLA_RTA(ifi), len);
+
+	if (tb[IFLA_PROTINFO]) {
+		if (RTA_PAYLOAD(tb[IFLA_PROTINFO]) == sizeof(__u8))
+			return *(__u8 *) RTA_DATA(tb[IFLA_PROTINFO]);
+		rta = tb[IFLA_PROTINFO];
+	} else if (tb[IFLA_LINKINFO]) {
+		parse_rtattr_nested(info, IFLA_INFO_MAX, tb[IFLA_LINKINFO]);
+		rta = info[IFLA_INFO_SLAVE_DATA];
+	}
+	if (!rta)
 		return -1;
+
+	parse_rtattr_nested(brport, IFLA_BRPORT_MAX, rta);
+	if (!brport[IFLA_BRPORT_STATE])
+		return -1;
+	return *(__u8 *) RTA_DATA(brport[IFLA_BRPORT_STATE]);
+}
+
+static int newer_set_pending(int ifindex)
+{
+	unsigned int i;
+	for (i = pending_tail; i != pending_head; i++)
+		if (!PENDING(i).query && PENDING(i).ifindex == ifindex)
+			return 1;
+	return 0;
+}
+
+/* We don't know whether the kernel has the state we asked for.
+   Ask it, unless a later state change will settle it anyway. */
+static void reconcile(struct pending_req *p)
+{
+	if (newer_set_pending(p->ifindex))
+		return;
+	if (p->retries >= MAX_STATE_RETRIES) {
+		ERROR("Giving up setting state %d on ifindex %d",
+		      p->state, p->ifindex);
+		return;
+	}
+	br_query_state(p->ifindex, p->state, p->retries + 1);
+}
+
+static void reconcile_all(void)
+{
+	struct pending_req lost[MAX_PENDING];
+	int i, j, count = 0;
+
+	while (SENT_COUNT)
+		lost[count++] = PENDING(pending_tail++);
+
+	for (i = 0; i < count; i++) {
+		for (j = i + 1; j < count; j++)
+			if (!lost[j].query && lost[j].ifindex == lost[i].ifindex)
+				break;
+		if (j == count)
+			reconcile(&lost[i]);
 	}
+}
+
+static void handle_reply(struct pending_req *p, struct nlmsghdr *n)
+{
+	int err = 0;
+	int kstate;
+
+	if (n->nlmsg_type == NLMSG_ERROR) {
+		struct nlmsgerr *e = NLMSG_DATA(n);
+		if (n->nlmsg_len < NLMSG_LENGTH(sizeof(*e)))
+			err = -EINVAL;
+		else
+			err = e->error;
+	}
+
+	if (!p->query) {
+		if (err == 0)
+			return;
+		ERROR("Couldn't set bridge state, ifindex %d, state %d: %s",
+		      p->ifindex, p->state, strerror(-err));
+		reconcile(p);
+		return;
+	}
+
+	if (err) {
+		INFO("Can't get state of ifindex %d: %s",
+		     p->ifindex, strerror(-err));
+		return;
+	}
+	if (n->nlmsg_type != RTM_NEWLINK)
+		return;
+	if (newer_set_pending(p->ifindex))
+		return;
+
+	kstate = kernel_port_state(n);
+	if (kstate == p->state) {
+		LOG("ifindex %d reconciled, state %d", p->ifindex, kstate);
+		return;
+	}
+	INFO("ifindex %d in state %d, want %d. Retrying",
+	     p->ifindex, kstate, p->state);
+	br_set_state(p->ifindex, p->state, p->retries);
+}
+
+static int state_reply(const struct sockaddr_nl *who, struct nlmsghdr *n,
+		       void *arg)
+{
+	struct pending_req p;
+
+	/* Anything older than this reply will not get one any more */
+	while (SENT_COUNT && seq_before(PENDING(pending_tail).seq,
+					n->nlmsg_seq)) {
+		p = PENDING(pending_tail++);
+		LOG("No reply for seq %u, ifindex %d", p.seq, p.ifindex);
+		reconcile(&p);
+	}
+
+	if (!SENT_COUNT || PENDING(pending_tail).seq != n->nlmsg_seq)
+		return 0;
+
+	p = PENDING(pending_tail++);
+	handle_reply(&p, n);
 	return 0;
 }
+
+static void state_drain(void)
+{
+	draining = 1;
+	while (rtnl_listen(&rth_state, state_reply, NULL) < 0) {
+		if (errno != ENOBUFS) {
+			ERROR("Error on bridge state socket");
+			break;
+		}
+		/* Replies were dropped and we can't tell which ones */
+		INFO("State socket overrun, reconciling %u requests",
+		     SENT_COUNT);
+		reconcile_all();
+	}
+	send_unsent();
+	draining = 0;
+}
+
+void bridge_state_ev_handler(uint32_t events, struct epoll_event_handler *h)
+{
+	state_drain();
+}
+
+/* A state write to ifindex hasn't been answered yet */
+int bridge_state_pending(int ifindex)
+{
+	return newer_set_pending(ifindex);
+}
+
+int bridge_set_state(int ifindex, int brstate)
+{
+	return br_set_state(ifindex, brstate, 0);
+}
+
+/* Send the requests, that the socket didn't take before */
+void bridge_state_retry(void)
+{
+	send_unsent();
+}
@@ -0,0 +1,72 @@
+#!/bin/sh
+#
+# Startup check for rstpd (make check, as root): a bridge with PORTS
+# ports is up before rstpd starts. rstpd must start STP on it once,
+# with all its ports (init_bridge_stp), and add none of them one by
+# one (add_port_stp).
+#
+# The kernel calls /sbin/bridge-stp for user mode STP (stp_state 2)
+# only for bridges of the initial network namespace, so the bridge of
+# the check is made there; it is removed at the end. The check is
+# skipped, if /sbin/bridge-stp does not give user mode STP, or if
+# another rstpd or another user mode bridge is on the host: rstpd
+# would take over that bridge.
+
+PORTS=${PORTS:-16}
+BR=rstpchk0
+LOG=${LOG:-/tmp/rstpd_check.log}
+
+cd "$(dirname "$0")"
+
+skip() {
+	echo "check_startup: skipped, $1"
+	exit 0
+}
+
+[ "$(id -u)" = 0 ] || skip "not root"
+pidof rstpd > /dev/null && skip "rstpd runs"
+for b in /sys/class/net/*/bridge; do
+	[ -e "$b" ] || continue
+	[ "$(cat "$b/stp_state")" = 2 ] &&
+		skip "user mode STP bridge $(basename "$(dirname "$b")")"
+done
+
+cleanup() {
+	i=0
+	while [ $i -lt $PORTS ]; do
+		ip link del rstpchk$i.a 2>/dev/null
+		i=$((i+1))
+	done
+	ip link del $BR 2>/dev/null
+}
+
+cleanup
+ip link add $BR type bridge || exit 1
+i=0
+while [ $i -lt $PORTS ]; do
+	ip link add rstpchk$i.a type veth peer name rstpchk$i.b &&
+	ip link set rstpchk$i.a master $BR &&
+	ip link set rstpchk$i.a up &&
+	ip link set rstpchk$i.b up || { cleanup; exit 1; }
+	i=$((i+1))
+done
+ip link set $BR up
+echo 1 > /sys/class/net/$BR/bridge/stp_state
+if [ "$(cat /sys/class/net/$BR/bridge/stp_state)" != 2 ]; then
+	cleanup
+	skip "no user mode STP"
+fi
+
+LD_LIBRARY_PATH=rstplib timeout -s INT 3 ./rstpd -d -v2 > "$LOG" 2>&1
+cleanup
+
+started=$(grep -c "$BR: STP started with $PORTS ports" "$LOG")
+single=$(grep -c "$BR: port .* added to STP" "$LOG")
+if [ "$started" = 1 ] && [ "$single" = 0 ]; then
+	echo "check_startup: passed, $BR started once with $PORTS ports"
+	exit 0
+fi
+echo "check_startup: FAILED, $BR started $started times with $PORTS ports," \
+     "$single ports added one by one"
+grep "$BR: " "$LOG"
+exit 1
@@ -33,6 +33,8 @@ CLIENT_SIDE_FUNCTION(enable_bridge_rstp)
     CLIENT_SIDE_FUNCTION(get_port_state)
     CLIENT_SIDE_FUNCTION(set_port_config)
     CLIENT_SIDE_FUNCTION(set_debug_level)
+    CLIENT_SIDE_FUNCTION(get_port_kernel_state)
+    CLIENT_SIDE_FUNCTION(set_trace)
 #include <base.h>
 const char *CTL_error_explanation(int err_no)
 {
@@ -42,6 +42,23 @@ int CTL_set_port_config(int br_index, int port_index, UID_STP_PORT_CFG_T * cfg);
 
 int CTL_set_debug_level(int level);
 
+/* Port state in the kernel bridge, as rstpd keeps track of it */
+struct port_kernel_state {
+	int programmed;		/* Last state written, -1 if none */
+	int reported;		/* Last state the kernel reported, -1 if not known */
+	unsigned long writes;
+	unsigned long suppressed;	/* Writes skipped, kernel was already there */
+	unsigned long repairs;	/* Rewrites after the kernel state drifted */
+};
+
+int CTL_get_port_kernel_state(int br_index, int port_index,
+			      struct port_kernel_state *ks);
+
+/* Tracepoints of a state machine of a port, port_index 0 for the bridge
+ * and all its ports, mach_name "all" for every machine */
+int CTL_set_trace(int br_index, int port_index, const char *mach_name,
+		  int enable);
+
 #define CTL_ERRORS \
  CHOOSE(Err_Interface_not_a_bridge), \
  CHOOSE(Err_Bridge_RSTP_not_enabled), \
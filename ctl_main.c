@@ -17,6 +17,7 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include <limits.h>
+#include <linux/if_bridge.h>
 
 #include "ctl_socket_client.h"
 #include "ctl_functions.h"
@@ -42,6 +43,23 @@ static void print_bridge_id(UID_BRIDGE_ID_T * bridge_id, unsigned char cr)
 		printf("\n");
 }
 
+static const char *br_state2str(int br_state)
+{
+	static const char *names[] = {
+		[BR_STATE_DISABLED] = "disabled",
+		[BR_STATE_LISTENING] = "listening",
+		[BR_STATE_LEARNING] = "learning",
+		[BR_STATE_FORWARDING] = "forwarding",
+		[BR_STATE_BLOCKING] = "blocking",
+	};
+
+	if (br_state < 0)
+		return "-";
+	if (br_state > BR_STATE_BLOCKING)
+		return "unknown";
+	return names[br_state];
+}
+
 static char *stp_state2str(RSTP_PORT_STATE stp_port_state, int detail)
 {
 	if (detail) {
@@ -198,6 +216,14 @@ static int do_showbridge(const char *br_name)
 	printf("Forward Delay:   %2d   Bridge Forward Delay: %-2d\n",
 	       (int)uid_state.forward_delay, (int)uid_cfg.forward_delay);
 	printf("Hold Time:       %2d\n", (int)uid_cfg.hold_time);
+	printf("Guard Evaluations: %lu   Last Event: %lu\n",
+	       uid_state.guard_evals, uid_state.last_guard_evals);
+	printf("Memory:          %lu bytes\n", uid_state.mem_bytes);
+	printf("Flush Window:    %2d   Flushes: %lu   Ports: %lu   Requests: %lu\n",
+	       (int)uid_cfg.flush_window, uid_state.flush_calls,
+	       uid_state.flushed_ports, uid_state.flush_requests);
+	printf("Fast Repeats:    %-3s  Repeated BPDUs: %lu\n",
+	       uid_cfg.rx_fast ? "on" : "off", uid_state.rx_fast_bpdus);
 
 	return 0;
 }
@@ -285,7 +311,7 @@ static int do_showport(int br_index, const char *port_name,
 		       (unsigned long)uid_port.port_id, uid_state->vlan_name);
 #endif
 		printf("Priority:          %-d\n",
-		       (int)(uid_port.port_id >> 8));
+		       (int)UID_PORT_ID_PRIO(uid_port.port_id));
 		printf("State:             %-16s",
 		       stp_state2str(uid_port.state, 1));
 		printf("       Uptime: %-9lu\n", uid_port.uptime);
@@ -389,6 +415,19 @@ static int do_showport(int br_index, const char *port_name,
 		       (unsigned long)uid_port.rx_cfg_bpdu_cnt);
 		printf("TCN BPDU rx:       %lu\n",
 		       (unsigned long)uid_port.rx_tcn_bpdu_cnt);
+		printf("Repeated BPDU rx:  %lu\n",
+		       (unsigned long)uid_port.rx_fast_bpdu_cnt);
+		printf("Memory:            %lu bytes\n", uid_port.mem_bytes);
+
+		struct port_kernel_state ks;
+		if (CTL_get_port_kernel_state(br_index, port_index, &ks) == 0) {
+			printf("Kernel state:      programmed: %-11s",
+			       br_state2str(ks.programmed));
+			printf("reported: %s\n", br_state2str(ks.reported));
+			printf("State writes:      %-9lu suppressed: %-9lu "
+			       "repairs: %lu\n",
+			       ks.writes, ks.suppressed, ks.repairs);
+		}
 	} else {
 		printf("%c%c%c  ",
 		       (uid_port.oper_point2point) ? ' ' : '*',
@@ -540,6 +579,14 @@ static int set_bridge_cfg_value(int br_index, unsigned long value,
 		uid_cfg.force_version = value;
 		val_name = "force_version";
 		break;
+	case BR_CFG_FLUSH_WINDOW:
+		uid_cfg.flush_window = value;
+		val_name = "flush_window";
+		break;
+	case BR_CFG_RX_FAST:
+		uid_cfg.rx_fast = value;
+		val_name = "rx_fast";
+		break;
 	case BR_CFG_AGE_MODE:
 	case BR_CFG_AGE_TIME:
 	default:
@@ -595,6 +642,23 @@ static int cmd_setbridgefdelay(int argc, char *const *argv)
 	return set_bridge_cfg_value(br_index, getuint(argv[2]), BR_CFG_DELAY);
 }
 
+static int cmd_setbridgeflushwindow(int argc, char *const *argv)
+{
+
+	int br_index = get_index(argv[1], "bridge");
+	return set_bridge_cfg_value(br_index, getuint(argv[2]),
+				    BR_CFG_FLUSH_WINDOW);
+}
+
+static int cmd_setbridgerxfast(int argc, char *const *argv)
+{
+
+	int br_index = get_index(argv[1], "bridge");
+	return set_bridge_cfg_value(br_index,
+				    getyesno(argv[2], "on", "off"),
+				    BR_CFG_RX_FAST);
+}
+
 static int cmd_setbridgeforcevers(int argc, char *const *argv)
 {
 
@@ -721,6 +785,24 @@ static int cmd_portmcheck(int argc, char *const *argv)
 	return set_port_cfg_value(br_index, port_index, 0, PT_CFG_MCHECK);
 }
 
+static int cmd_settrace(int argc, char *const *argv)
+{
+	int br_index = get_index(argv[1], "bridge");
+	int port_index = 0;
+	int rc;
+
+	if (strcmp(argv[2], "all"))
+		port_index = get_index(argv[2], "port");
+	rc = CTL_set_trace(br_index, port_index, argv[3],
+			   getyesno(argv[4], "on", "off"));
+	if (0 != rc) {
+		printf("can't set trace of %s: %s\n",
+		       argv[3], STP_IN_get_error_explanation(rc));
+		return -1;
+	}
+	return 0;
+}
+
 static int cmd_debuglevel(int argc, char *const *argv)
 {
 	return CTL_set_debug_level(getuint(argv[1]));
@@ -753,6 +835,10 @@ static const struct command commands[] = {
 	 "<bridge> <maxage>\tset bridge max age (6-40)"},
 	{2, 0, "setfdelay", cmd_setbridgefdelay,
 	 "<bridge> <fwd_delay>\tset bridge forward delay (4-30)"},
+	{2, 0, "setflushwindow", cmd_setbridgeflushwindow,
+	 "<bridge> <seconds>\tgather fdb flushes for (0-10)"},
+	{2, 0, "setrxfast", cmd_setbridgerxfast,
+	 "<bridge> {on|off}\trepeated BPDUs skip the state machines"},
 	{2, 0, "setforcevers", cmd_setbridgeforcevers,
 	 "<bridge> {normal|slow}\tnormal RSTP or force to STP"},
 	{3, 0, "setportprio", cmd_setportprio,
@@ -767,6 +853,8 @@ static const struct command commands[] = {
 	 "<bridge> <port> {yes|no|auto}\tset whether p2p connection"},
 	{2, 0, "portmcheck", cmd_portmcheck,
 	 "<bridge> <port>\ttry to get back from STP to RSTP mode"},
+	{4, 0, "settrace", cmd_settrace,
+	 "<bridge> {<port>|all} {<machine>|all} {on|off}\ttrace state machines"},
 	{1, 0, "debuglevel", cmd_debuglevel, "<level>\t\tLevel of verbosity"},
 };
 
@@ -68,6 +68,8 @@ int handle_message(int cmd, void *inbuf, int lin, void *outbuf, int *lout)
 		SERVER_MESSAGE_CASE(get_port_state);
 		SERVER_MESSAGE_CASE(set_port_config);
 		SERVER_MESSAGE_CASE(set_debug_level);
+		SERVER_MESSAGE_CASE(get_port_kernel_state);
+		SERVER_MESSAGE_CASE(set_trace);
 
 	default:
 		ERROR("CTL: Unknown command %d", cmd);
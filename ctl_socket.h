@@ -149,6 +149,45 @@ struct set_debug_level_OUT {
 #define set_debug_level_COPY_OUT ({ (void)0; })
 #define set_debug_level_CALL (in->level)
 
+#if 0
+int CTL_get_port_kernel_state(int br_index, int port_index,
+			      struct port_kernel_state *ks);
+#endif
+#define CMD_CODE_get_port_kernel_state 107
+#define get_port_kernel_state_ARGS (int br_index, int port_index, struct port_kernel_state *ks)
+struct get_port_kernel_state_IN {
+	int br_index;
+	int port_index;
+};
+struct get_port_kernel_state_OUT {
+	struct port_kernel_state ks;
+};
+#define get_port_kernel_state_COPY_IN \
+  ({ in->br_index = br_index; in->port_index = port_index; })
+#define get_port_kernel_state_COPY_OUT ({ *ks = out->ks; })
+#define get_port_kernel_state_CALL (in->br_index, in->port_index, &out->ks)
+
+#if 0
+int CTL_set_trace(int br_index, int port_index, const char *mach_name,
+		  int enable);
+#endif
+#define CMD_CODE_set_trace 108
+#define set_trace_ARGS (int br_index, int port_index, const char *mach_name, int enable)
+struct set_trace_IN {
+	int br_index;
+	int port_index;
+	char mach_name[16];
+	int enable;
+};
+struct set_trace_OUT {
+};
+#define set_trace_COPY_IN \
+  ({ in->br_index = br_index; in->port_index = port_index; \
+     strncpy(in->mach_name, mach_name, sizeof(in->mach_name) - 1); \
+     in->mach_name[sizeof(in->mach_name) - 1] = 0; in->enable = enable; })
+#define set_trace_COPY_OUT ({ (void)0; })
+#define set_trace_CALL (in->br_index, in->port_index, in->mach_name, in->enable)
+
 /* General case part in ctl command server switch */
 #define SERVER_MESSAGE_CASE(name) \
 case CMD_CODE_ ## name : do { \
@@ -0,0 +1,223 @@
+/*****************************************************************************
+  This program is free software; you can redistribute it and/or modify it
+  under the terms of the GNU General Public License as published by the Free
+  Software Foundation; either version 2 of the License, or (at your option)
+  any later version.
+
+  This program is distributed in the hope that it will be useful, but WITHOUT
+  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+  more details.
+
+  You should have received a copy of the GNU General Public License along with
+  this program; if not, write to the Free Software Foundation, Inc., 59
+  Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+  The full GNU General Public License is included in this distribution in the
+  file called LICENSE.
+
+******************************************************************************/
+
+/* Link speed and duplex from the ethtool generic netlink family.
+   Requests are sent without waiting, replies and change notifications
+   from the "monitor" group come back through the epoll loop. */
+
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <linux/genetlink.h>
+#include <linux/ethtool.h>
+#include <linux/ethtool_netlink.h>
+
+#include "libnetlink.h"
+#include "bridge_ctl.h"
+#include "epoll_loop.h"
+#include "log.h"
+
+#ifndef SOL_NETLINK
+#define SOL_NETLINK 270
+#endif
+
+#define GENL_ATTRS(n) \
+	((struct rtattr *)((char *)NLMSG_DATA(n) + GENL_HDRLEN))
+#define GENL_ATTRS_LEN(n) ((int)(n)->nlmsg_len - NLMSG_LENGTH(GENL_HDRLEN))
+
+static struct rtnl_handle rth_eth;
+static struct epoll_event_handler eth_handler;
+static int ethtool_family = -1;
+
+/* Find the ethtool family id and the id of its monitor group */
+static int resolve_family(int *family, int *mcgrp)
+{
+	struct {
+		struct nlmsghdr n;
+		struct genlmsghdr g;
+		char buf[64];
+	} req;
+	static char answer_buf[16384];
+	struct nlmsghdr *answer = (struct nlmsghdr *)answer_buf;
+	struct rtattr *tb[CTRL_ATTR_MAX + 1];
+	struct rtattr *grp;
+	int len;
+
+	memset(&req, 0, sizeof(req));
+	req.n.nlmsg_len = NLMSG_LENGTH(GENL_HDRLEN);
+	req.n.nlmsg_flags = NLM_F_REQUEST;
+	req.n.nlmsg_type = GENL_ID_CTRL;
+	req.g.cmd = CTRL_CMD_GETFAMILY;
+	req.g.version = 1;
+	addattr_l(&req.n, sizeof(req), CTRL_ATTR_FAMILY_NAME,
+		  ETHTOOL_GENL_NAME, strlen(ETHTOOL_GENL_NAME) + 1);
+
+	if (rtnl_talk(&rth_eth, &req.n, 0, 0, answer, NULL, NULL) < 0)
+		return -1;
+	if (answer->nlmsg_type != GENL_ID_CTRL || GENL_ATTRS_LEN(answer) < 0)
+		return -1;
+
+	parse_rtattr(tb, CTRL_ATTR_MAX, GENL_ATTRS(answer),
+		     GENL_ATTRS_LEN(answer));
+	if (!tb[CTRL_ATTR_FAMILY_ID] || !tb[CTRL_ATTR_MCAST_GROUPS])
+		return -1;
+	*family = *(__u16 *) RTA_DATA(tb[CTRL_ATTR_FAMILY_ID]);
+
+	*mcgrp = -1;
+	len = RTA_PAYLOAD(tb[CTRL_ATTR_MCAST_GROUPS]);
+	for (grp = RTA_DATA(tb[CTRL_ATTR_MCAST_GROUPS]); RTA_OK(grp, len);
+	     grp = RTA_NEXT(grp, len)) {
+		struct rtattr *g[CTRL_ATTR_MCAST_GRP_MAX + 1];
+		parse_rtattr_nested(g, CTRL_ATTR_MCAST_GRP_MAX, grp);
+		if (g[CTRL_ATTR_MCAST_GRP_NAME] && g[CTRL_ATTR_MCAST_GRP_ID] &&
+		    !strcmp(RTA_DATA(g[CTRL_ATTR_MCAST_GRP_NAME]),
+			    ETHTOOL_MCGRP_MONITOR_NAME))
+			*mcgrp = *(__u32 *) RTA_DATA(g[CTRL_ATTR_MCAST_GRP_ID]);
+	}
+	return 0;
+}
+
+static int eth_msg(const struct sockaddr_nl *who, struct nlmsghdr *n,
+		   void *arg)
+{
+	struct genlmsghdr *g = NLMSG_DATA(n);
+	struct rtattr *tb[ETHTOOL_A_LINKMODES_MAX + 1];
+	struct rtattr *hdr[ETHTOOL_A_HEADER_MAX + 1];
+	__u32 speed;
+	__u8 duplex;
+
+	if (n->nlmsg_type == NLMSG_ERROR) {
+		struct nlmsgerr *e = NLMSG_DATA(n);
+		LOG("Link modes request failed: %s", strerror(-e->error));
+		return 0;
+	}
+	if (n->nlmsg_type != ethtool_family || GENL_ATTRS_LEN(n) < 0)
+		return 0;
+	if (g->cmd != ETHTOOL_MSG_LINKMODES_GET_REPLY &&
+	    g->cmd != ETHTOOL_MSG_LINKMODES_NTF)
+		return 0;
+
+	parse_rtattr(tb, ETHTOOL_A_LINKMODES_MAX, GENL_ATTRS(n),
+		     GENL_ATTRS_LEN(n));
+	if (!tb[ETHTOOL_A_LINKMODES_HEADER] ||
+	    !tb[ETHTOOL_A_LINKMODES_SPEED] || !tb[ETHTOOL_A_LINKMODES_DUPLEX])
+		return 0;
+	parse_rtattr_nested(hdr, ETHTOOL_A_HEADER_MAX,
+			    tb[ETHTOOL_A_LINKMODES_HEADER]);
+	if (!hdr[ETHTOOL_A_HEADER_DEV_INDEX])
+		return 0;
+
+	speed = *(__u32 *) RTA_DATA(tb[ETHTOOL_A_LINKMODES_SPEED]);
+	duplex = *(__u8 *) RTA_DATA(tb[ETHTOOL_A_LINKMODES_DUPLEX]);
+
+	bridge_link_modes_notify(*(__u32 *)
+				 RTA_DATA(hdr[ETHTOOL_A_HEADER_DEV_INDEX]),
+				 speed == (__u32) SPEED_UNKNOWN ? -1 : speed,
+				 duplex == DUPLEX_UNKNOWN ? -1 : duplex);
+	return 0;
+}
+
+void eth_ev_handler(uint32_t events, struct epoll_event_handler *h)
+{
+	if (rtnl_listen(&rth_eth, eth_msg, NULL) < 0)
+		ERROR("Error on ethtool netlink socket");
+}
+
+/* Ask for the current link modes of an interface.
+   Returns -1 if ethtool netlink is not available. */
+int ethtool_request_link_modes(int ifindex)
+{
+	struct {
+		struct nlmsghdr n;
+		struct genlmsghdr g;
+		char buf[64];
+	} req;
+	struct rtattr *nest;
+
+	if (ethtool_family < 0)
+		return -1;
+
+	memset(&req, 0, sizeof(req));
+	req.n.nlmsg_len = NLMSG_LENGTH(GENL_HDRLEN);
+	req.n.nlmsg_flags = NLM_F_REQUEST;
+	req.n.nlmsg_type = ethtool_family;
+	req.n.nlmsg_seq = ++rth_eth.seq;
+	req.g.cmd = ETHTOOL_MSG_LINKMODES_GET;
+	req.g.version = ETHTOOL_GENL_VERSION;
+
+	nest = NLMSG_TAIL(&req.n);
+	addattr_l(&req.n, sizeof(req),
+		  ETHTOOL_A_LINKMODES_HEADER | NLA_F_NESTED, NULL, 0);
+	addattr32(&req.n, sizeof(req), ETHTOOL_A_HEADER_DEV_INDEX, ifindex);
+	addattr32(&req.n, sizeof(req), ETHTOOL_A_HEADER_FLAGS,
+		  ETHTOOL_FLAG_COMPACT_BITSETS);
+	nest->rta_len = (char *)NLMSG_TAIL(&req.n) - (char *)nest;
+
+	if (rtnl_send(&rth_eth, (const char *)&req.n, req.n.nlmsg_len) < 0) {
+		ERROR("Couldn't request link modes for ifindex %d: %m",
+		      ifindex);
+		return -1;
+	}
+	return 0;
+}
+
+/* Not having ethtool netlink (older kernels) is not an error, callers
+   fall back to the ethtool ioctl */
+int init_ethtool_ops(void)
+{
+	int family, mcgrp;
+
+	if (rtnl_open_byproto(&rth_eth, 0, NETLINK_GENERIC) < 0) {
+		ERROR("Couldn't open generic netlink socket");
+		return -1;
+	}
+
+	if (resolve_family(&family, &mcgrp) < 0 || mcgrp < 0) {
+		INFO("No ethtool netlink, using ethtool ioctl");
+		rtnl_close(&rth_eth);
+		return 0;
+	}
+
+	if (setsockopt(rth_eth.fd, SOL_NETLINK, NETLINK_ADD_MEMBERSHIP,
+		       &mcgrp, sizeof(mcgrp)) < 0) {
+		ERROR("Couldn't join ethtool monitor group: %m");
+		rtnl_close(&rth_eth);
+		return -1;
+	}
+
+	if (fcntl(rth_eth.fd, F_SETFL, O_NONBLOCK) < 0) {
+		ERROR("Error setting O_NONBLOCK: %m");
+		rtnl_close(&rth_eth);
+		return -1;
+	}
+
+	eth_handler.fd = rth_eth.fd;
+	eth_handler.arg = NULL;
+	eth_handler.handler = eth_ev_handler;
+
+	if (add_epoll(&eth_handler) < 0) {
+		rtnl_close(&rth_eth);
+		return -1;
+	}
+
+	ethtool_family = family;
+	return 0;
+}
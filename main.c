@@ -70,6 +70,7 @@ int main(int argc, char *argv[])
 	TST(ctl_socket_init() == 0, -1);
 	TST(packet_sock_init() == 0, -1);
 	TST(netsock_init() == 0, -1);
+	TST(init_ethtool_ops() == 0, -1);
 	TST(init_bridge_ops() == 0, -1);
 	if (become_daemon) {
 		FILE *f = fopen("/var/run/rstpd.pid", "w");
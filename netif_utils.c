@@ -80,9 +80,13 @@ int ethtool_get_speed_duplex(char *ifname, int *speed, int *duplex)
 		ERROR("Cannot get link status for %s: %m\n", ifname);
 		return -1;
 	}
-	*speed = ecmd.speed;	/* Ethtool speed is in Mbps */
+	*speed = ethtool_cmd_speed(&ecmd);	/* Ethtool speed is in Mbps */
+	if (*speed == (__u32) SPEED_UNKNOWN)
+		*speed = -1;
 	*duplex = ecmd.duplex;	/* We have same convention as ethtool.
 				   0 = half, 1 = full */
+	if (*duplex == DUPLEX_UNKNOWN)
+		*duplex = -1;
 	return 0;
 }
 
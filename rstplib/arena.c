@@ -0,0 +1,167 @@
+/************************************************************************
+ * RSTP library - Rapid Spanning Tree (802.1D-2004)
+ *
+ * This file is part of RSTP library.
+ *
+ * RSTP library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; version 2.1
+ *
+ * RSTP library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with RSTP library; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **********************************************************************/
+
+/* Per instance memory arena */
+
+#include "base.h"
+#include "arena.h"
+
+/* A piece of memory taken from the system: a slab or a large object */
+typedef struct arena_piece_t {
+	struct arena_piece_t *next;
+} ARENA_PIECE_T;
+
+#define PIECE_HEADER	STP_ARENA_SIZE(sizeof(ARENA_PIECE_T))
+
+/* Free objects of one size, linked through their first word */
+typedef struct arena_bin_t {
+	struct arena_bin_t *next;
+	size_t size;
+	void *head;
+} ARENA_BIN_T;
+
+STP_ARENA_T stp_default_arena;
+
+STP_ARENA_T *stp_arena = &stp_default_arena;
+
+static void *_stp_arena_piece(STP_ARENA_T *this, size_t size)
+{
+	ARENA_PIECE_T *piece;
+
+#ifdef __LINUX__
+	if (posix_memalign((void **)&piece, STP_ARENA_ALIGN,
+			   PIECE_HEADER + size)) {
+		return NULL;
+	}
+#else
+	piece = (ARENA_PIECE_T *)malloc(PIECE_HEADER + size);
+	if (!piece) {
+		return NULL;
+	}
+#endif
+	piece->next = this->pieces;
+	this->pieces = piece;
+	this->reserved += PIECE_HEADER + size;
+
+	return (char *)piece + PIECE_HEADER;
+}
+
+static ARENA_BIN_T *_stp_arena_bin(STP_ARENA_T *this, size_t size)
+{
+	register ARENA_BIN_T *bin;
+
+	for (bin = this->bins; bin; bin = bin->next) {
+		if (bin->size == size) {
+			return bin;
+		}
+	}
+	return NULL;
+}
+
+/* Zeroed and aligned to STP_ARENA_ALIGN */
+void *STP_arena_alloc(size_t size)
+{
+	register STP_ARENA_T *this = stp_arena;
+	register ARENA_BIN_T *bin;
+	void *ptr;
+
+	size = STP_ARENA_SIZE(size);
+
+	bin = _stp_arena_bin(this, size);
+	if (bin && bin->head) {
+		ptr = bin->head;
+		bin->head = *(void **)ptr;
+	} else if (size <= STP_ARENA_SMALL) {
+		if (this->left < size) {
+			this->cur = _stp_arena_piece(this, STP_ARENA_SLAB_SIZE);
+			if (!this->cur) {
+				this->left = 0;
+				return NULL;
+			}
+			this->left = STP_ARENA_SLAB_SIZE;
+		}
+		ptr = this->cur;
+		this->cur += size;
+		this->left -= size;
+	} else {
+		ptr = _stp_arena_piece(this, size);
+		if (!ptr) {
+			return NULL;
+		}
+	}
+
+	memset(ptr, 0, size);
+	this->in_use += size;
+	return ptr;
+}
+
+/* Back to the free list of its size */
+void STP_arena_free(void *ptr, size_t size)
+{
+	register STP_ARENA_T *this = stp_arena;
+	register ARENA_BIN_T *bin;
+
+	size = STP_ARENA_SIZE(size);
+
+	bin = _stp_arena_bin(this, size);
+	if (!bin) {
+		/* bins are few (one per object size) and never freed */
+		bin = (ARENA_BIN_T *)STP_arena_alloc(sizeof(ARENA_BIN_T));
+		if (!bin) {
+			return; /* lost till STP_arena_release */
+		}
+		this->in_use -= STP_ARENA_SIZE(sizeof(ARENA_BIN_T));
+		bin->size = size;
+		bin->next = this->bins;
+		this->bins = bin;
+	}
+
+	*(void **)ptr = bin->head;
+	bin->head = ptr;
+	this->in_use -= size;
+}
+
+char *STP_arena_strdup(const char *src)
+{
+	char *str;
+
+	str = (char *)STP_arena_alloc(strlen(src) + 1);
+	if (str) {
+		strcpy(str, src);
+	}
+	return str;
+}
+
+void STP_arena_free_str(char *str)
+{
+	STP_arena_free(str, strlen(str) + 1);
+}
+
+/* Give all the memory of the arena back to the system */
+void STP_arena_release(STP_ARENA_T *this)
+{
+	register ARENA_PIECE_T *piece;
+
+	while ((piece = this->pieces)) {
+		this->pieces = piece->next;
+		free(piece);
+	}
+	memset(this, 0, sizeof(STP_ARENA_T));
+}
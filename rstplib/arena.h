@@ -0,0 +1,74 @@
+/************************************************************************
+ * RSTP library - Rapid Spanning Tree (802.1D-2004)
+ *
+ * This file is part of RSTP library.
+ *
+ * RSTP library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; version 2.1
+ *
+ * RSTP library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with RSTP library; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **********************************************************************/
+
+/* Memory of an STP instance. Bridges, ports, machines and names are
+ * taken from it. Small objects are cut from slabs, large ones (port
+ * blocks) get their own piece. Freed objects go to free lists by size
+ * and are reused; all of it is given back at once by STP_arena_release. */
+
+#ifndef _STP_ARENA_H__
+#define _STP_ARENA_H__
+
+#define STP_ARENA_ALIGN		STP_CACHE_LINE	/* of every object */
+#define STP_ARENA_SLAB_SIZE	4096
+#define STP_ARENA_SMALL		(STP_ARENA_SLAB_SIZE / 4)
+
+typedef struct stp_arena_t {
+	struct arena_piece_t	*pieces;	/* all memory from the system */
+	char			*cur;		/* free part of the last slab */
+	size_t			left;
+	struct arena_bin_t	*bins;		/* free lists by size */
+	unsigned long		in_use;		/* bytes given out */
+	unsigned long		reserved;	/* bytes taken from the system */
+} STP_ARENA_T;
+
+/* The arena of the current instance, see STP_IN_instance_begin;
+ * the default one is used outside of instances */
+extern STP_ARENA_T *stp_arena;
+extern STP_ARENA_T stp_default_arena;
+
+#define STP_ARENA_SIZE(SIZE)	\
+	(((SIZE) + STP_ARENA_ALIGN - 1) & ~((size_t)STP_ARENA_ALIGN - 1))
+
+#define STP_ARENA_NEW(PTR, TYPE, EXTRA, MSG)				\
+	{								\
+		PTR = (TYPE *)STP_arena_alloc(sizeof(TYPE) + (EXTRA));	\
+		if (! PTR) {						\
+			STP_FATAL("malloc", MSG, -6);			\
+		}							\
+	}
+
+#define STP_ARENA_DEL(PTR, TYPE, EXTRA)					\
+	{								\
+		STP_arena_free(PTR, sizeof(TYPE) + (EXTRA));		\
+		PTR = NULL;						\
+	}
+
+void *STP_arena_alloc(size_t size);
+
+void STP_arena_free(void *ptr, size_t size);
+
+char *STP_arena_strdup(const char *src);
+
+void STP_arena_free_str(char *str);
+
+void STP_arena_release(STP_ARENA_T *arena);
+
+#endif /* _STP_ARENA_H__ */
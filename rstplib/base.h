@@ -104,6 +104,9 @@
 	CHOOSE(STP_Cannot_Compute_Bridge_Prio),			\
 	CHOOSE(STP_Another_Error),				\
 	CHOOSE(STP_Nothing_To_Do),				\
+	CHOOSE(STP_No_Such_State_Machine),			\
+	CHOOSE(STP_Small_Flush_Window),				\
+	CHOOSE(STP_Large_Flush_Window),				\
 	CHOOSE(STP_LAST_DUMMY),					\
 }
 
@@ -160,6 +163,12 @@ extern ULONG Ntohl(ULONG n);
 		}					\
 	}
 
+#define STP_CACHE_LINE	64
+
+/* Breaks the build, if COND (a constant expression) is false */
+#define STP_COMPILE_ASSERT(NAME, COND)			\
+	typedef char stp_compile_assert_##NAME[(COND) ? 1 : -1]
+
 #define STP_NEW_IN_LIST(WHAT, TYPE, LIST, MSG)	\
 	{					\
 		STP_MALLOC(WHAT, TYPE, MSG);	\
@@ -23,57 +23,141 @@
 #ifndef __BITMAP_H
 #define __BITMAP_H
 
-#define NUMBER_OF_PORTS 4
+/* Sets of ports: bit (port_index - 1) stands for the port. The width
+ * covers the 12 bit port numbers of 802.1t; it may be set at build. */
+#ifndef BITMAP_BITS
+#define BITMAP_BITS 4096
+#endif
+
+#define NUMBER_OF_PORTS 4 /* of the bridges of the simulator (bridge.c) */
+
+#define BITMAP_WORD_BITS	((int)(8 * sizeof(unsigned long)))
+#define BITMAP_WORDS		\
+	((BITMAP_BITS + 8 * sizeof(unsigned long) - 1) / (8 * sizeof(unsigned long)))
+
+/* the bits of the last word, that are in the bitmap */
+#define BITMAP_LAST_MASK	\
+	(BITMAP_BITS % BITMAP_WORD_BITS ?				\
+	 ~0UL >> (BITMAP_WORD_BITS - BITMAP_BITS % BITMAP_WORD_BITS) : ~0UL)
 
 typedef struct tagBITMAP {
-	unsigned long part0; /* Least Significant part */
+	unsigned long part[BITMAP_WORDS]; /* part[0] is the least significant */
 } BITMAP_T;
 
+#define BITMAP_FOR_WORDS(WORD) \
+	for ((WORD) = 0; (WORD) < (int)BITMAP_WORDS; (WORD)++)
+
 #define BitmapClear(BitmapPtr) \
-	{ (BitmapPtr)->part0 = 0; }
+	{ register int _w; BITMAP_FOR_WORDS(_w) (BitmapPtr)->part[_w] = 0; }
 
 #define BitmapSetAllBits(BitmapPtr) \
-	{ (BitmapPtr)->part0 = 0xF; }
+	{ register int _w; BITMAP_FOR_WORDS(_w) { (BitmapPtr)->part[_w] = ~0UL; } \
+	  (BitmapPtr)->part[BITMAP_WORDS - 1] &= BITMAP_LAST_MASK; }
 
 #define BitmapClearBits(BitmapPtr,BitmapBitsPtr) \
-	{ (BitmapPtr)->part0 &= ~((BitmapBitsPtr)->part0); }
+	{ register int _w; BITMAP_FOR_WORDS(_w) \
+	  (BitmapPtr)->part[_w] &= ~((BitmapBitsPtr)->part[_w]); }
 
 #define BitmapSetBits(BitmapPtr,BitmapBitsPtr) \
-	{ (BitmapPtr)->part0 |= ((BitmapBitsPtr)->part0); }
+	{ register int _w; BITMAP_FOR_WORDS(_w) \
+	  (BitmapPtr)->part[_w] |= ((BitmapBitsPtr)->part[_w]); }
 
 #define BitmapOr(ResultPtr,BitmapPtr1,BitmapPtr2) \
-	{ (ResultPtr)->part0 = (BitmapPtr1)->part0 | (BitmapPtr2)->part0; }
+	{ register int _w; BITMAP_FOR_WORDS(_w) \
+	  (ResultPtr)->part[_w] = (BitmapPtr1)->part[_w] | (BitmapPtr2)->part[_w]; }
 
 #define BitmapAnd(ResultPtr,BitmapPtr1,BitmapPtr2) \
-	{ (ResultPtr)->part0 = (BitmapPtr1)->part0 & (BitmapPtr2)->part0; }
+	{ register int _w; BITMAP_FOR_WORDS(_w) \
+	  (ResultPtr)->part[_w] = (BitmapPtr1)->part[_w] & (BitmapPtr2)->part[_w]; }
 
 #define BitmapNot(ResultPtr,BitmapPtr) \
-	{ (ResultPtr)->part0 = ~((BitmapPtr)->part0); }
+	{ register int _w; BITMAP_FOR_WORDS(_w) { \
+	  (ResultPtr)->part[_w] = ~((BitmapPtr)->part[_w]); } \
+	  (ResultPtr)->part[BITMAP_WORDS - 1] &= BITMAP_LAST_MASK; }
+
+#define BitmapXor(ResultPtr,BitmapPtr1,BitmapPtr2) \
+	{ register int _w; BITMAP_FOR_WORDS(_w) \
+	  (ResultPtr)->part[_w] = (BitmapPtr1)->part[_w] ^ (BitmapPtr2)->part[_w]; }
+
+#define BitmapCopy(BitmapDstPtr,BitmapSrcPtr) \
+	{ *(BitmapDstPtr) = *(BitmapSrcPtr); }
 
 /* Return zero if identical */
 #define BitmapCmp(BitmapPtr1,BitmapPtr2) \
-	((BitmapPtr1)->part0 != (BitmapPtr2)->part0) 
+	_bitmap_cmp((BitmapPtr1), (BitmapPtr2))
 
 #define BitmapIsZero(BitmapPtr) \
-	(!(BitmapPtr)->part0)
+	(BitmapFirstBit(BitmapPtr) < 0)
 
 #define BitmapIsAllOnes(BitmapPtr) \
-	((BitmapPtr)->part0 == 0xF)
+	(BitmapCount(BitmapPtr) == BITMAP_BITS)
 
+/* Bit range [0 .. BITMAP_BITS - 1] */
 #define BitmapGetBit(BitmapPtr,Bit) \
-	((BitmapPtr)->part0 & (1 << (Bit)))
+	(((BitmapPtr)->part[(Bit) / BITMAP_WORD_BITS] >> \
+	  ((Bit) % BITMAP_WORD_BITS)) & 1UL)
 
-/* Bit range [0 .. 63] */
 #define BitmapSetBit(BitmapPtr,Bit) \
-	{(BitmapPtr)->part0 |= (1 << (Bit)); }
+	{(BitmapPtr)->part[(Bit) / BITMAP_WORD_BITS] |= \
+	  (1UL << ((Bit) % BITMAP_WORD_BITS)); }
 
 #define BitmapClearBit(BitmapPtr,Bit) \
-	(BitmapPtr)->part0 &= ~(1 << (Bit));
-
-#define BitmapCopy(BitmapDstPtr,BitmapSrcPtr) \
-	{ (BitmapDstPtr)->part0 = (BitmapSrcPtr)->part0; }
-
-#define BitmapXor(ResultPtr,BitmapPtr1,BitmapPtr2) \
-	{ (ResultPtr)->part0 = (BitmapPtr1)->part0 ^ (BitmapPtr2)->part0; }
+	(BitmapPtr)->part[(Bit) / BITMAP_WORD_BITS] &= \
+	  ~(1UL << ((Bit) % BITMAP_WORD_BITS));
+
+/* Goes over the set bits only, lowest first:
+ *   BitmapForEachBit(&ports, bit) { port_index = bit + 1; ... } */
+#define BitmapForEachBit(BitmapPtr,Bit) \
+	for ((Bit) = BitmapFirstBit(BitmapPtr); (Bit) >= 0; \
+	     (Bit) = BitmapNextBit((BitmapPtr), (Bit)))
+
+/* The first set bit after Bit, -1 if there is none */
+static inline int BitmapNextBit(const BITMAP_T *bmp, int bit)
+{
+	register int word;
+	register unsigned long part;
+
+	if (++bit >= BITMAP_BITS) {
+		return -1;
+	}
+	word = bit / BITMAP_WORD_BITS;
+	part = bmp->part[word] & (~0UL << (bit % BITMAP_WORD_BITS));
+	while (!part) {
+		if (++word >= (int)BITMAP_WORDS) {
+			return -1;
+		}
+		part = bmp->part[word];
+	}
+	bit = word * BITMAP_WORD_BITS + __builtin_ctzl(part);
+	return bit < BITMAP_BITS ? bit : -1;
+}
+
+static inline int BitmapFirstBit(const BITMAP_T *bmp)
+{
+	return BitmapNextBit(bmp, -1);
+}
+
+/* Number of the set bits */
+static inline int BitmapCount(const BITMAP_T *bmp)
+{
+	register int word, count = 0;
+
+	BITMAP_FOR_WORDS(word) {
+		count += __builtin_popcountl(bmp->part[word]);
+	}
+	return count;
+}
+
+static inline int _bitmap_cmp(const BITMAP_T *bmp1, const BITMAP_T *bmp2)
+{
+	register int word;
+
+	BITMAP_FOR_WORDS(word) {
+		if (bmp1->part[word] != bmp2->part[word]) {
+			return 1;
+		}
+	}
+	return 0;
+}
 
 #endif /* __BITMAP_H */
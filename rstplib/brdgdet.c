@@ -41,10 +41,10 @@ void STP_brdgdet_enter_state(STATE_MACH_T *s)
 		case BEGIN:
 			break;
 		case EDGE:
-			port->operEdge = True;
+			PORT_SET(port, operEdge);
 			break;
 		case NOT_EDGE:
-			port->operEdge = False;
+			PORT_CLR(port, operEdge);
 			break;
 	}
 }
@@ -55,19 +55,24 @@ Bool STP_brdgdet_check_conditions(STATE_MACH_T *s)
 
 	switch (s->State) {
 		case BEGIN:
-			if (port->AdminEdgePort) {
+			if (PORT_GET(port, AdminEdgePort)) {
 				return STP_hop_2_state(s, EDGE);
 			}
 			return STP_hop_2_state(s, NOT_EDGE);
 		case EDGE:
-			if ((!port->portEnabled && !port->AdminEdgePort) || !port->operEdge) {
+			if (!PORT_ANY_FLAGS(port, PORT_FLAG(portEnabled) |
+						  PORT_FLAG(AdminEdgePort)) ||
+			    !PORT_GET(port, operEdge)) {
 				return STP_hop_2_state(s, NOT_EDGE);
 			}
 			break;
 		case NOT_EDGE:
-			if ((!port->portEnabled && port->AdminEdgePort) ||
-			    ((port->edgeDelayWhile == 0) && port->AutoEdgePort &&
-			      port->sendRSTP && port->proposing)) {
+			if ((!PORT_GET(port, portEnabled) &&
+			     PORT_GET(port, AdminEdgePort)) ||
+			    ((PORT_TIMER(port, edgeDelayWhile) == 0) &&
+			     PORT_ALL_FLAGS(port, PORT_FLAG(AutoEdgePort) |
+						  PORT_FLAG(sendRSTP) |
+						  PORT_FLAG(proposing)))) {
 				return STP_hop_2_state(s, EDGE);
 			}
 			break;
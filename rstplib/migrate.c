@@ -26,68 +26,79 @@
 #include "stpm.h"
 #include "migrate.h"
 
-#define STATES {		\
-	CHOOSE(CHECKING_RSTP),	\
-	CHOOSE(SELECTING_STP),	\
-	CHOOSE(SENSING),		\
+/* Figure 17-15, as stmtab.h makes the table of it */
+#define MACHINE(STATE, GO)						\
+	STATE(CHECKING_RSTP, checking_rstp,				\
+	      GO(checking_done, SENSING)				\
+	      GO(checking_disabled, CHECKING_RSTP))			\
+	STATE(SELECTING_STP, selecting_stp,				\
+	      GO(selecting_done, SENSING))				\
+	STATE(SENSING, sensing,						\
+	      GO(sensing_rstp, CHECKING_RSTP)				\
+	      GO(sensing_stp, SELECTING_STP))
+
+static void checking_rstp(STATE_MACH_T *this)
+{
+	register PORT_T *port = this->owner.port;
+
+	PORT_CLR(port, mcheck);
+	PORT_PUT(port, sendRSTP, port->owner->rstpVersion);
+	PORT_TIMER(port, mdelayWhile) = MigrateTime;
 }
 
-#define GET_STATE_NAME STP_migrate_get_state_name
-#include "choose.h"
+static void selecting_stp(STATE_MACH_T *this)
+{
+	register PORT_T *port = this->owner.port;
 
-void STP_migrate_enter_state(STATE_MACH_T *this)
+	PORT_CLR(port, sendRSTP);
+	PORT_TIMER(port, mdelayWhile) = MigrateTime;
+}
+
+static void sensing(STATE_MACH_T *this)
+{
+	PORT_CLR_FLAGS(this->owner.port, PORT_FLAG(rcvdRSTP) |
+					 PORT_FLAG(rcvdSTP));
+}
+
+static inline Bool checking_done(STATE_MACH_T *this)
+{
+	return PORT_TIMER(this->owner.port, mdelayWhile) == 0;
+}
+
+static inline Bool checking_disabled(STATE_MACH_T *this)
 {
 	register PORT_T *port = this->owner.port;
-	register STPM_T *stpm = port->owner;
-
-	switch (this->State) {
-		case BEGIN:
-		case CHECKING_RSTP:
-			port->mcheck = False;
-			port->sendRSTP = stpm->rstpVersion;
-			port->mdelayWhile = MigrateTime;
-			break;
-		case SELECTING_STP:
-			port->sendRSTP = False;
-			port->mdelayWhile = MigrateTime;
-			break;
-		case SENSING:
-			port->rcvdRSTP = port->rcvdSTP = False;
-			break;
-	}
+
+	return PORT_TIMER(port, mdelayWhile) != MigrateTime &&
+	       !PORT_GET(port, portEnabled);
 }
 
-Bool STP_migrate_check_conditions(STATE_MACH_T *this)
+static inline Bool selecting_done(STATE_MACH_T *this)
 {
 	register PORT_T *port = this->owner.port;
-	register STPM_T *stpm = port->owner;
-
-	if (BEGIN == this->State)
-		return STP_hop_2_state (this, CHECKING_RSTP);
-
-	switch (this->State) {
-		case CHECKING_RSTP:
-			if (port->mdelayWhile == 0) {
-				return STP_hop_2_state(this, SENSING);
-			}
-			if (port->mdelayWhile != MigrateTime && !port->portEnabled) {
-				return STP_hop_2_state(this, CHECKING_RSTP);
-			}
-			break;
-		case SELECTING_STP:
-			if (port->mdelayWhile == 0 ||
-			    !port->portEnabled || port->mcheck) {
-				return STP_hop_2_state(this, SENSING);
-			}
-			break;
-		case SENSING:
-			if (!port->portEnabled || port->mcheck ||
-			    (stpm->rstpVersion && !port->sendRSTP && port->rcvdRSTP)) {
-				return STP_hop_2_state(this, CHECKING_RSTP);
-			}
-			if (port->sendRSTP && port->rcvdSTP) {
-				return STP_hop_2_state(this, SELECTING_STP);
-			}
-	}
-	return False;
+
+	return PORT_TIMER(port, mdelayWhile) == 0 ||
+	       !PORT_GET(port, portEnabled) ||
+	       PORT_GET(port, mcheck);
 }
+
+static inline Bool sensing_rstp(STATE_MACH_T *this)
+{
+	register PORT_T *port = this->owner.port;
+
+	return !PORT_GET(port, portEnabled) ||
+	       PORT_GET(port, mcheck) ||
+	       (port->owner->rstpVersion && !PORT_GET(port, sendRSTP) &&
+		PORT_GET(port, rcvdRSTP));
+}
+
+static inline Bool sensing_stp(STATE_MACH_T *this)
+{
+	return PORT_ALL_FLAGS(this->owner.port, PORT_FLAG(sendRSTP) |
+						PORT_FLAG(rcvdSTP));
+}
+
+#define GET_STATE_NAME STP_migrate_get_state_name
+#define ENTER_STATE STP_migrate_enter_state
+#define CHECK_CONDITIONS STP_migrate_check_conditions
+#include "stmtab.h"
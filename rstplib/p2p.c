@@ -55,11 +55,11 @@ void STP_p2p_enter_state(STATE_MACH_T *s)
 	switch (s->State) {
 		case BEGIN:
 		case INIT:
-			port->p2p_recompute = True;
+			PORT_SET(port, p2p_recompute);
 			break;
 		case RECOMPUTE:
-			port->operPointToPointMac = computeP2P (port);
-			port->p2p_recompute = False;
+			PORT_PUT(port, operPointToPointMac, computeP2P (port));
+			PORT_CLR(port, p2p_recompute);
 			break;
 		case STABLE:
 			break;
@@ -77,7 +77,7 @@ Bool STP_p2p_check_conditions(STATE_MACH_T *s)
 		case RECOMPUTE:
 			return STP_hop_2_state(s, STABLE);
 		case STABLE:
-			if (port->p2p_recompute) {
+			if (PORT_GET(port, p2p_recompute)) {
 				return STP_hop_2_state(s, RECOMPUTE);
 			}
 			break;
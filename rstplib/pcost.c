@@ -59,18 +59,15 @@ static long computeAutoPCost(STATE_MACH_T *this)
 	} else /* ??? */{ /* > Tb/s */
 		lret = 1;
 	}
-#ifdef STP_DBG
-	if (port->pcost->debug) {
+	if (STP_TRACING(port->pcost)) {
 		stp_trace("usedSpeed=%lu lret=%ld", port->usedSpeed, lret);
 	}
-#endif
 
 	return lret;
 }
 
 static void updPortPathCost(PORT_T *port) {
-	port->reselect = True;
-	port->selected = False;
+	STP_rolesel_reselect(port);
 }
 
 void
@@ -83,11 +80,9 @@ STP_pcost_enter_state(STATE_MACH_T *this)
 			break;
 		case AUTO:
 			port->operSpeed = STP_OUT_get_port_oper_speed(port->port_index);
-#ifdef STP_DBG
-			if (port->pcost->debug) {
+			if (STP_TRACING(port->pcost)) {
 				stp_trace("AUTO:operSpeed=%lu", port->operSpeed);
 			}
-#endif
 			port->usedSpeed = port->operSpeed;
 			port->operPCost = computeAutoPCost (this);
 			break;
@@ -22,7 +22,10 @@
 
 /* STP PORT instance : 17.18, 17.15 */
 
+#include <stddef.h>
+
 #include "base.h"
+#include "arena.h"
 #include "stpm.h"
 #include "stp_in.h"
 
@@ -38,7 +41,13 @@
 #include "receive.h"
 #include "rolesel.h"
 
-#include "stp_to.h" /* for STP_OUT_get_port_name & STP_OUT_get_port_link_status */
+#include "stp_to.h" /* for STP_OUT_get_port_name, STP_OUT_get_port_mac & STP_OUT_get_port_link_status */
+
+/* The layout of PORT_T (see port.h): what the loops over all ports
+ * read fits in two cache lines, and a port stays within 16 of them */
+STP_COMPILE_ASSERT(port_hot_lines,
+		   offsetof(PORT_T, machines) <= 2 * STP_CACHE_LINE);
+STP_COMPILE_ASSERT(port_lines, sizeof(PORT_T) <= 16 * STP_CACHE_LINE);
 
 PORT_T *STP_port_create(STPM_T *stpm, int port_index)
 {
@@ -47,6 +56,11 @@ PORT_T *STP_port_create(STPM_T *stpm, int port_index)
 	register int iii;
 	unsigned short port_prio;
 
+	/* the port number has to fit in the Port Identifier */
+	if (port_index < 1 || port_index > UID_PORT_ID_MAX_NUMBER) {
+		return NULL;
+	}
+
 	/* check, if the port has just been added */
 	for (this = stpm->ports; this; this = this->next) {
 		if (this->port_index == port_index) {
@@ -54,85 +68,61 @@ PORT_T *STP_port_create(STPM_T *stpm, int port_index)
 		}
 	}
 
-	STP_NEW_IN_LIST(this, PORT_T, stpm->ports, "port create");
+	this = STP_stpm_port_alloc(stpm);
 
 	this->owner = stpm;
+	this->tc_prop_seen = stpm->tc_prop_epoch;
+	this->sync_seen = stpm->sync_epoch;
+	this->reroot_seen = stpm->reroot_epoch;
 	this->machines = NULL;
 	this->port_index = port_index;
-	this->port_name = strdup(STP_OUT_get_port_name (port_index));
-	this->uptime = 0;
+	this->port_name = STP_arena_strdup(STP_OUT_get_port_name (port_index));
+	if (!this->port_name) {
+		STP_FATAL("strdup", "port name", -7);
+	}
+	STP_OUT_get_port_mac (port_index, this->mac);
+	this->up_since = stpm->seconds;
 
 	STP_OUT_get_init_port_cfg(stpm->vlan_id, port_index, &port_cfg);
 	port_prio = port_cfg.port_priority;
-	this->admin_non_stp = port_cfg.admin_non_stp;
-	this->AdminEdgePort = port_cfg.admin_edge;
+	PORT_PUT(this, admin_non_stp, port_cfg.admin_non_stp);
+	PORT_PUT(this, AdminEdgePort, port_cfg.admin_edge);
 	this->adminPCost = port_cfg.admin_port_path_cost;
 	this->adminPointToPointMac = port_cfg.admin_point2point;
 
 	this->LinkDelay = DEF_LINK_DELAY;
-	this->portId = (port_prio << 8) + port_index;
-
-	iii = 0;
-	this->timers[iii++] = &this->edgeDelayWhile;
-	this->timers[iii++] = &this->fdWhile;
-	this->timers[iii++] = &this->helloWhen;
-	this->timers[iii++] = &this->mdelayWhile;
-	this->timers[iii++] = &this->rbWhile;
-	this->timers[iii++] = &this->rcvdInfoWhile;
-	this->timers[iii++] = &this->rrWhile;
-	this->timers[iii++] = &this->tcWhile;
-	this->timers[iii++] = &this->txCount;
+	this->portId = UID_PORT_ID(port_prio, port_index);
 
 	/* create and bind port state machines */
-	STP_STATE_MACH_IN_LIST(receive);	/* 17.23 */
-	
-	STP_STATE_MACH_IN_LIST(topoch);		/* 17.31 */
+	iii = PORT_MACHINES_NUMBER;
+	STP_STATE_MACH_IN_ARRAY(receive, &this->mach[--iii]);	/* 17.23 */
 
-	STP_STATE_MACH_IN_LIST(migrate);	/* 17.24 */
-	
-	STP_STATE_MACH_IN_LIST(p2p);
+	STP_STATE_MACH_IN_ARRAY(topoch, &this->mach[--iii]);	/* 17.31 */
 
-	STP_STATE_MACH_IN_LIST(brdgdet);	/* 17.25 */
+	STP_STATE_MACH_IN_ARRAY(migrate, &this->mach[--iii]);	/* 17.24 */
 
-	STP_STATE_MACH_IN_LIST(pcost)
+	STP_STATE_MACH_IN_ARRAY(p2p, &this->mach[--iii]);
 
-	STP_STATE_MACH_IN_LIST(info);		/* 17.27 */
-	
-	STP_STATE_MACH_IN_LIST(roletrns);	/* 17.29 */
+	STP_STATE_MACH_IN_ARRAY(brdgdet, &this->mach[--iii]);	/* 17.25 */
 
-	STP_STATE_MACH_IN_LIST(sttrans);	/* 17.30 */
+	STP_STATE_MACH_IN_ARRAY(pcost, &this->mach[--iii]);
 
-	STP_STATE_MACH_IN_LIST(transmit);	/* 17.26 */
+	STP_STATE_MACH_IN_ARRAY(info, &this->mach[--iii]);	/* 17.27 */
 
-#ifdef STP_DBG
+	STP_STATE_MACH_IN_ARRAY(roletrns, &this->mach[--iii]);	/* 17.29 */
 
-#if 0
-	this->roletrns->ignoreHop2State = 14; /* DESIGNATED_PORT; */
-	this->info->ignoreHop2State = 3; /* CURRENT */
-	this->transmit->ignoreHop2State = 3; /* IDLE */
-	this->edge->ignoreHop2State = 0; /* DISABLED; */
-#endif
+	STP_STATE_MACH_IN_ARRAY(sttrans, &this->mach[--iii]);	/* 17.30 */
 
-#if 0
-	this->info->debug = 1;
-	this->pcost->debug = 1;
-	this->p2p->debug = 1;
-	this->edge->debug = 1;
-	this->migrate->debug = 1;
-	this->sttrans->debug = 1;
-	this->topoch->debug = 1;
-	this->roletrns->debug = 1;
-#endif
-	this->sttrans->debug = 1;
+	STP_STATE_MACH_IN_ARRAY(transmit, &this->mach[--iii]);	/* 17.26 */
 
-#endif
 	return this;
 }
 
 void STP_port_init(PORT_T *this, STPM_T *stpm, Bool check_link)
 {
 	if (check_link) {
-		this->adminEnable = STP_OUT_get_port_link_status (this->port_index);
+		PORT_PUT(this, adminEnable,
+			 STP_OUT_get_port_link_status (this->port_index));
 		STP_VECT_create(&this->designatedPriority,
 				&stpm->BridgeIdentifier,
 				0,
@@ -140,24 +130,25 @@ void STP_port_init(PORT_T *this, STPM_T *stpm, Bool check_link)
 				this->portId,
 				this->portId);
 		STP_copy_times(&this->designatedTimes, &stpm->rootTimes);
-		this->fdWhile = 0;
+		PORT_TIMER(this, fdWhile) = 0;
 	}
 
 	/* reset timers */
-	this->helloWhen = 0;
-	this->mdelayWhile = 0;
-	this->rbWhile = 0;
-	this->rcvdInfoWhile = 0;
-	this->rrWhile = 0;
-	this->tcWhile = 0;
-	this->txCount = 0;
-	this->portEnabled = True;
+	PORT_TIMER(this, helloWhen) = 0;
+	PORT_TIMER(this, mdelayWhile) = 0;
+	PORT_TIMER(this, rbWhile) = 0;
+	PORT_TIMER(this, rcvdInfoWhile) = 0;
+	PORT_TIMER(this, rrWhile) = 0;
+	PORT_TIMER(this, tcWhile) = 0;
+	PORT_TIMER(this, txCount) = 0;
+	PORT_SET(this, portEnabled);
 
 	this->msgPortRole = RSTP_PORT_ROLE_UNKN;
 	this->selectedRole = DisabledPort;
-	this->sendRSTP = True;
+	PORT_SET(this, sendRSTP);
 	this->operSpeed = STP_OUT_get_port_oper_speed(this->port_index);
-	this->p2p_recompute = True;
+	PORT_SET(this, p2p_recompute);
+	STP_rolesel_port_changed(this);
 }
 
 void STP_port_delete(PORT_T *this)
@@ -166,17 +157,17 @@ void STP_port_delete(PORT_T *this)
 	register PORT_T *prev;
 	register PORT_T *tmp;
 	register STATE_MACH_T *stater;
-	register void *pv;
 
 	stpm = this->owner;
 
-	free (this->port_name);
-	for (stater = this->machines; stater; ) {
-		pv = (void *)stater->next;
-		STP_state_mach_delete (stater);
-		stater = (STATE_MACH_T *)pv;
+	/* the machines are in the port slot, they are not deleted apart */
+	for (stater = this->machines; stater; stater = stater->next) {
+		STP_state_mach_set_debug(stater, False);
 	}
 
+	STP_stpm_unmark_port (this);
+	STP_arena_free_str (this->port_name);
+
 	prev = NULL;
 	for (tmp = stpm->ports; tmp; tmp = tmp->next) {
 		if (tmp->port_index == this->port_index) {
@@ -185,7 +176,7 @@ void STP_port_delete(PORT_T *this)
 			} else {
 				stpm->ports = this->next;
 			}
-			STP_FREE(this, "stp instance");
+			STP_stpm_port_free(stpm, this);
 			break;
 		}
 		prev = tmp;
@@ -199,26 +190,33 @@ int STP_port_rx_bpdu(PORT_T *this, BPDU_T *bpdu, size_t len)
 	return 0;
 }
 
-#ifdef STP_DBG
+/* Bytes of the port: its slot and its name */
+unsigned long STP_port_mem_bytes(PORT_T *this)
+{
+	return sizeof(PORT_T) + STP_ARENA_SIZE(strlen(this->port_name) + 1);
+}
+
 int STP_port_trace_state_machine(PORT_T *this, char *mach_name, int enadis, int vlan_id)
 {
 	register struct state_mach_t *stater;
+	int found = 0;
 
 	for (stater = this->machines; stater; stater = stater->next) {
-		if (! strcmp(mach_name, "all") || ! strcmp(mach_name, stater->name)) {
+		if (! strcmp(mach_name, "all") || ! strcmp(mach_name, STP_state_mach_name(stater))) {
+			found++;
 			/* if (stater->debug != enadis) */
 			{
 				stp_trace ("port %s on %s trace %-8s (was %s) now %s",
 				this->port_name, this->owner->name,
-				stater->name,
+				STP_state_mach_name(stater),
 				stater->debug ? " enabled" :"disabled",
 				enadis ? " enabled" :"disabled");
 			}
-			stater->debug = enadis;
+			STP_state_mach_set_debug(stater, enadis);
 		}
 	}
 
-	return 0;
+	return found;
 }
 
 void STP_port_trace_flags(char *title, PORT_T *this)
@@ -226,18 +224,16 @@ void STP_port_trace_flags(char *title, PORT_T *this)
 #if 0 /* it may be opened for more deep debugging */
 	unsigned long flag = 0L;
 
-	if (this->reRoot) flag |= 0x000001L;
-	if (this->sync) flag |= 0x000002L;
-	if (this->synced) flag |= 0x000004L;
+	if (PORT_GET(this, reRoot)) flag |= 0x000001L;
+	if (PORT_GET(this, sync)) flag |= 0x000002L;
+	if (PORT_GET(this, synced)) flag |= 0x000004L;
 
-	if (this->proposed) flag |= 0x000010L;
-	if (this->proposing) flag |= 0x000020L;
-	if (this->agreed) flag |= 0x000040L;
-	if (this->updtInfo) flag |= 0x000080L;
+	if (PORT_GET(this, proposed)) flag |= 0x000010L;
+	if (PORT_GET(this, proposing)) flag |= 0x000020L;
+	if (PORT_GET(this, agreed)) flag |= 0x000040L;
+	if (PORT_GET(this, updtInfo)) flag |= 0x000080L;
 
-	if (this->operEdge) flag |= 0x000100L;
+	if (PORT_GET(this, operEdge)) flag |= 0x000100L;
 	stp_trace("         %-12s: flags=0X%04lx port=%s", title, flag, this->port_name);
 #endif
 }
-
-#endif
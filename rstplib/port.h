@@ -27,8 +27,30 @@
 
 #include "statmch.h"
 
-#define TIMERS_NUMBER   9
-typedef unsigned int PORT_TIMER_T;
+/* per port Timers. They are kept by the port block in rows, one row
+ * per timer, so that STP_stpm_one_second() decrements a row at once */
+#define PORT_TIMERS(T)							\
+	T(edgeDelayWhile)	/* 17.17.1 */				\
+	T(fdWhile)		/* 17.17.2 */				\
+	T(helloWhen)		/* 17.17.3 */				\
+	T(mdelayWhile)		/* 17.17.4 */				\
+	T(rbWhile)		/* 17.17.5 */				\
+	T(rcvdInfoWhile)	/* 17.17.6 */				\
+	T(rrWhile)		/* 17.17.7 */				\
+	T(tcWhile)		/* 17.17.8 */				\
+	T(txCount)		/* 17.19.44 */
+
+#define PORT_TIMER_ENUM(WHAT)	PT_##WHAT,
+typedef enum {
+	PORT_TIMERS(PORT_TIMER_ENUM)
+	TIMERS_NUMBER
+} PORT_TIMER_ID_T;
+#undef PORT_TIMER_ENUM
+
+typedef unsigned short PORT_TIMER_T;
+
+/* the timer of the port, an lvalue */
+#define PORT_TIMER(P, T)	((P)->timer[PT_##T * (P)->timer_stride])
 
 typedef enum {
 	Mine,
@@ -54,84 +76,122 @@ typedef enum {
 	NonStpPort
 } PORT_ROLE_T;
 
+#define PORT_MACHINES_NUMBER	10
+
+/* Boolean per port variables (17.19 and the management ones), packed
+ * into one word: a port is reset and "all of them" conditions are
+ * tested by masks */
+#define PORT_FLAGS(F)							\
+	F(reRoot)		/* 17.19.33 */				\
+	F(reselect)		/* 17.19.34 */				\
+	F(selected)		/* 17.19.36 */				\
+	F(sync)			/* 17.19.39 */				\
+	F(synced)		/* 17.19.40 */				\
+	F(agree)		/* 17.19.2 */				\
+	F(agreed)		/* 17.19.3 */				\
+	F(disputed)		/* 17.19.6 */				\
+	F(fbdFlush)		/* 17.19.7 */				\
+	F(forward)		/* 17.19.8 */				\
+	F(forwarding)		/* 17.19.9 */				\
+	F(learn)		/* 17.19.11 */				\
+	F(learning)		/* 17.19.12 */				\
+	F(mcheck)		/* 17.19.13 */				\
+	F(newInfo)		/* 17.19.16 */				\
+	F(operEdge)		/* 17.19.17 */				\
+	F(portEnabled)		/* 17.19.18 */				\
+	F(proposed)		/* 17.19.23 */				\
+	F(proposing)		/* 17.19.24 */				\
+	F(rcvdBPDU)		/* 17.19.25 */				\
+	F(rcvdMsg)		/* 17.19.27 */				\
+	F(rcvdRSTP)		/* 17.19.28 */				\
+	F(rcvdSTP)		/* 17.19.29 */				\
+	F(rcvdTc)		/* 17.19.30 */				\
+	F(rcvdTcAck)		/* 17.19.31 */				\
+	F(rcvdTcn)		/* 17.19.32 */				\
+	F(sendRSTP)		/* 17.19.38 */				\
+	F(tc)			/* 17.19.41 */				\
+	F(tcAck)		/* 17.19.42 */				\
+	F(tick)			/* 17.19.43 */				\
+	F(updtInfo)		/* 17.19.45 */				\
+	F(admin_non_stp)						\
+	F(AdminEdgePort)						\
+	F(AutoEdgePort)							\
+	F(adminEnable)		/* 'has LINK' */			\
+	F(p2p_recompute)						\
+	F(operPointToPointMac)						\
+	F(wasInitBpdu)
+
+#define PORT_FLAG_ENUM(WHAT)	PF_##WHAT,
+typedef enum {
+	PORT_FLAGS(PORT_FLAG_ENUM)
+	PORT_FLAGS_NUMBER	/* not more than 64 */
+} PORT_FLAG_T;
+#undef PORT_FLAG_ENUM
+
+typedef unsigned long long PORT_FLAGS_T;
+
+#define PORT_FLAG(F)		((PORT_FLAGS_T)1 << PF_##F)
+
+#define PORT_GET(P, F)		((Bool)(((P)->flags >> PF_##F) & 1))
+#define PORT_SET(P, F)		((P)->flags |= PORT_FLAG(F))
+#define PORT_CLR(P, F)		((P)->flags &= ~PORT_FLAG(F))
+#define PORT_PUT(P, F, V)	((V) ? PORT_SET(P, F) : PORT_CLR(P, F))
+
+/* MASK is an OR of PORT_FLAG()s */
+#define PORT_SET_FLAGS(P, MASK)	((P)->flags |= (MASK))
+#define PORT_CLR_FLAGS(P, MASK)	((P)->flags &= ~(MASK))
+#define PORT_ALL_FLAGS(P, MASK)	(((P)->flags & (MASK)) == (MASK))
+#define PORT_ANY_FLAGS(P, MASK)	(((P)->flags & (MASK)) != 0)
+#define PORT_FLAGS_ARE(P, MASK, VALUE) (((P)->flags & (MASK)) == (VALUE))
+
+/* The fields, that the state machines look at on every check and every
+ * tick, come first and the statistics and names last, so that a pass
+ * over the ports touches as few cache lines as possible. Ports live in
+ * the blocks of their bridge (see PORT_BLOCK_T in stpm.h). */
 typedef struct port_t {
+	/* what the loops over all ports of the bridge (role selection,
+	 * the *Tree procedures, allSynced, reRooted) read */
 	struct port_t	*next;
+	struct stpm_t	*owner;			/* Bridge, that this port belongs to */
+	int		port_index;
+	PORT_FLAGS_T	flags;			/* PORT_FLAGS */
+	unsigned long	tc_prop_seen;		/* of owner->tc_prop_epoch */
+	unsigned long	sync_seen;		/* of owner->sync_epoch */
+	unsigned long	reroot_seen;		/* of owner->reroot_epoch */
+	Bool		counted_synced;		/* in owner->synced_ports */
+	Bool		counted_rerooting;	/* in owner->rerooting_ports */
+	INFO_IS_T	infoIs;			/* 17.19.10 */
+	PORT_ROLE_T	selectedRole;		/* 17.19.37 */
 
-	/* per Port state machines */
+	struct port_t	*next_dirty;		/* in owner->dirty_ports */
+	Bool		dirty;			/* machines to be checked */
 
-	STATE_MACH_T	*receive;		/* 17.23 */
-	STATE_MACH_T	*migrate;		/* 17.24 */
-	STATE_MACH_T	*brdgdet;		/* 17.25 */
-	STATE_MACH_T	*transmit;		/* 17.26 */
-	STATE_MACH_T	*info;			/* 17.27 */
-	STATE_MACH_T	*roletrns;		/* 17.29 */
-	STATE_MACH_T	*sttrans;		/* 17.30 */
-	STATE_MACH_T	*topoch;		/* 17.31 */
-	STATE_MACH_T	*p2p;			/* 6.4.3, 6.5.1 */
-	STATE_MACH_T	*pcost;			/*  */
+	struct port_t	*next_flush;		/* in owner->flush_ports */
 
-	STATE_MACH_T	*machines;		/* list of machines */
+	struct port_t	*sel_next;		/* in owner->sel_changed */
+	Bool		sel_queued;		/* role to be recomputed */
+	int		sel_leaf;		/* in owner->sel_tree */
 
-	struct stpm_t	*owner;			/* Bridge, that this port belongs to */
+	STATE_MACH_T	*machines;		/* list of machines */
 
-	/* per port Timers */
-	PORT_TIMER_T	edgeDelayWhile;		/* 17.17.1 */
-	PORT_TIMER_T	fdWhile;		/* 17.17.2 */
-	PORT_TIMER_T	helloWhen;		/* 17.17.3 */
-	PORT_TIMER_T	mdelayWhile;		/* 17.17.4 */
-	PORT_TIMER_T	rbWhile;		/* 17.17.5 */
-	PORT_TIMER_T	rcvdInfoWhile;		/* 17.17.6 */
-	PORT_TIMER_T	rrWhile;		/* 17.17.7 */
-	PORT_TIMER_T	tcWhile;		/* 17.17.8 */
-	PORT_TIMER_T	txCount;		/* 17.19.44 */
+	/* per port Timers: the column of the port in the timer rows
+	 * of its block, see PORT_TIMER */
+	PORT_TIMER_T	*timer;
+	int		timer_stride;
 
-	PORT_TIMER_T	*timers[TIMERS_NUMBER];	/* list of timers */
+	unsigned long	up_since; /* owner->seconds, for 14.8.2.1.3.a */
 
 	unsigned int	ageingTime;		/* 17.19.1 */
-	Bool		agree;			/* 17.19.2 */
-	Bool		agreed;			/* 17.19.3 */
 	PRIO_VECTOR_T	designatedPriority;	/* 17.19.4 */
 	TIMEVALUES_T	designatedTimes;	/* 17.19.5 */
-	Bool		disputed;		/* 17.19.6 */
-	Bool		fbdFlush;		/* 17.19.7 */
-	Bool		forward;		/* 17.19.8 */
-	Bool		forwarding;		/* 17.19.9 */
-	INFO_IS_T	infoIs;			/* 17.19.10 */
-	Bool		learn;			/* 17.19.11 */
-	Bool		learning;		/* 17.19.12 */
-	Bool		mcheck;			/* 17.19.13 */
 	PRIO_VECTOR_T	msgPriority;		/* 17.19.14 */
 	TIMEVALUES_T	msgTimes;		/* 17.19.15 */
-	Bool		newInfo;		/* 17.19.16 */
-	Bool		operEdge;		/* 17.19.17 */
-	Bool		portEnabled;		/* 17.19.18 */
 	PORT_ID		portId;			/* 17.19.19 */
 	unsigned long	PortPathCost;		/* 17.19.20 */
 	PRIO_VECTOR_T	portPriority;		/* 17.19.21 */
 	TIMEVALUES_T	portTimes;		/* 17.19.22 */
-	Bool		proposed;		/* 17.19.23 */
-	Bool		proposing;		/* 17.19.24 */
-	Bool		rcvdBPDU;		/* 17.19.25 */
 	RCVD_INFO_T	rcvdInfo;		/* 17.19.26 */
-	Bool		rcvdMsg;		/* 17.19.27 */
-	Bool		rcvdRSTP;		/* 17.19.28 */
-	Bool		rcvdSTP;		/* 17.19.29 */
-	Bool		rcvdTc;			/* 17.19.30 */
-	Bool		rcvdTcAck;		/* 17.19.31 */
-	Bool		rcvdTcn;		/* 17.19.32 */
-	Bool		reRoot;			/* 17.19.33 */
-	Bool		reselect;		/* 17.19.34 */
 	PORT_ROLE_T	role;			/* 17.19.35 */
-	Bool		selected;		/* 17.19.36 */
-	PORT_ROLE_T	selectedRole;		/* 17.19.37 */
-	Bool		sendRSTP;		/* 17.19.38 */
-	Bool		sync;			/* 17.19.39 */
-	Bool		synced;			/* 17.19.40 */
-	Bool		tc;			/* 17.19.41 */
-	Bool		tcAck;			/* 17.19.42 */
-	Bool		tick;			/* 17.19.43 */
-	Bool		tcProp;			/* 17.19.44 */
-	Bool		updtInfo;		/* 17.19.45 */
 
 	/* message information */
 	unsigned char	msgBpduVersion;
@@ -143,26 +203,41 @@ typedef struct port_t {
 	unsigned long	operPCost;
 	unsigned long	operSpeed;
 	unsigned long	usedSpeed;
-	int		LinkDelay; /* TBD: LinkDelay may be managed ? */
-	Bool		AdminEdgePort;
-	Bool		AutoEdgePort;
-	Bool		adminEnable; /* 'has LINK' */
-	Bool		wasInitBpdu;
-	Bool		admin_non_stp;
-
-	Bool		p2p_recompute;
-	Bool		operPointToPointMac;
+
 	ADMIN_P2P_T	adminPointToPointMac;
 
-	/* statistics */
+	/* per Port state machines */
+
+	STATE_MACH_T	*receive;		/* 17.23 */
+	STATE_MACH_T	*migrate;		/* 17.24 */
+	STATE_MACH_T	*brdgdet;		/* 17.25 */
+	STATE_MACH_T	*transmit;		/* 17.26 */
+	STATE_MACH_T	*info;			/* 17.27 */
+	STATE_MACH_T	*roletrns;		/* 17.29 */
+	STATE_MACH_T	*sttrans;		/* 17.30 */
+	STATE_MACH_T	*topoch;		/* 17.31 */
+	STATE_MACH_T	*p2p;			/* 6.4.3, 6.5.1 */
+	STATE_MACH_T	*pcost;			/*  */
+
+	STATE_MACH_T	mach[PORT_MACHINES_NUMBER]; /* storage of the above */
+
+	/* cold: management and statistics */
+	int		LinkDelay; /* TBD: LinkDelay may be managed ? */
+
 	unsigned long	rx_cfg_bpdu_cnt;
 	unsigned long	rx_rstp_bpdu_cnt;
 	unsigned long	rx_tcn_bpdu_cnt;
 
-	unsigned long	uptime; /* 14.8.2.1.3.a */
+	/* the last BPDU, that gave designated information, and the repeats
+	 * of it, that took the fast path, see STP_info_rx_repeated */
+	BPDU_HEADER_T	rx_last_hdr;
+	BPDU_BODY_T	rx_last_body;
+	Bool		rx_last_valid;
+	unsigned long	rx_fast_bpdu_cnt;
 
-	int		port_index;
 	char		*port_name;
+	unsigned char	mac[6]; /* from STP_OUT_get_port_mac, for bridge id */
+	Bool		in_use; /* slot of the port block is taken */
 
 #ifdef STP_DBG
 	unsigned int	skip_rx;
@@ -178,11 +253,12 @@ int STP_port_rx_bpdu (PORT_T *this, BPDU_T *bpdu, size_t len);
 
 void STP_port_init (PORT_T *this, struct stpm_t *stpm, Bool check_link);
 
-#ifdef STP_DBG
+unsigned long STP_port_mem_bytes(PORT_T *this);
+
+/* Returns the number of the machines of the port named by mach_name */
 int STP_port_trace_state_machine (PORT_T *this, char *mach_name, int enadis, int vlan_id);
 
 void STP_port_trace_flags (char *title, PORT_T *this);
-#endif
 
 #endif /*  _STP_PORT_H__ */
 
@@ -22,6 +22,8 @@
 
 #include "base.h"
 #include "stpm.h"
+#include "migrate.h" /* for MigrateTime */
+#include "roletrns.h"
 
 /* The Port Information State Machine : 17.27 */
 
@@ -68,19 +70,15 @@ static RCVD_INFO_T rcvInfo(STATE_MACH_T *this)
 	int bridcmp;
 	register PORT_T *port = this->owner.port;
 
-#ifdef STP_DBG
-	if (this->debug) {
+	if (STP_TRACING(this)) {
 		stp_trace("port->msgBpduType = %d", port->msgBpduType);
 	}
-#endif
 	
 	port->msgPortRole = (port->msgFlags & PORT_ROLE_MASK) >> PORT_ROLE_OFFS;
 
-#ifdef STP_DBG
-	if (this->debug) {
+	if (STP_TRACING(this)) {
 		stp_trace("Updating port->msgPortRole = %d", port->msgPortRole);
 	}
-#endif		
 	/* See 17.21.8 Note: A configuration BPDU explicitly conveys a Designated Port Role. */
 	if (BPDU_CONFIG_TYPE == port->msgBpduType) {
 		port->msgPortRole = RSTP_PORT_ROLE_DESGN;
@@ -96,15 +94,12 @@ static RCVD_INFO_T rcvInfo(STATE_MACH_T *this)
 	if (RSTP_PORT_ROLE_DESGN == port->msgPortRole) {
 		bridcmp = STP_VECT_compare_vector (&port->msgPriority, &port->portPriority);
 		if (bridcmp < 0 ||
-		    (!STP_VECT_compare_bridge_id (&port->msgPriority.design_bridge,
-						  &port->portPriority.design_bridge) &&
-		    port->msgPriority.design_port == port->portPriority.design_port &&
+		    (STP_VECT_same_designated (&port->msgPriority,
+					       &port->portPriority) &&
 		    STP_compare_times (&port->msgTimes, &port->portTimes))) {
-#ifdef STP_DBG
-			if (this->debug) {
+			if (STP_TRACING(this)) {
 				stp_trace ("SuperiorDesignatedInfo:bridcmp=%d", (int)bridcmp);
 			}
-#endif
 			return SuperiorDesignatedInfo;
 		}
 	}
@@ -118,11 +113,9 @@ static RCVD_INFO_T rcvInfo(STATE_MACH_T *this)
 	    (!STP_VECT_compare_vector (&port->msgPriority,
 				       &port->portPriority) &&
 	     !STP_compare_times (&port->msgTimes, &port->portTimes))) {
-#ifdef STP_DBG
-		if (this->debug) {
+		if (STP_TRACING(this)) {
 			stp_trace ("%s", "RepeatedDesignatedInfo");
 		}
-#endif
 		return RepeatedDesignatedInfo;
 	}
 
@@ -134,11 +127,9 @@ static RCVD_INFO_T rcvInfo(STATE_MACH_T *this)
 	if (RSTP_PORT_ROLE_DESGN == port->msgPortRole &&
 	    STP_VECT_compare_vector(&port->msgPriority,
 				    &port->portPriority) > 0) {
-#ifdef STP_DBG
-		if (this->debug) {
+		if (STP_TRACING(this)) {
 			stp_trace ("%s", "InferiorDesignatedInfo");
 		}
-#endif
 		return InferiorDesignatedInfo;
 	}
  
@@ -151,19 +142,15 @@ static RCVD_INFO_T rcvInfo(STATE_MACH_T *this)
 	     RSTP_PORT_ROLE_ALTBACK == port->msgPortRole) &&
 	    STP_VECT_compare_vector (&port->msgPriority,
 				     &port->portPriority) >= 0) {
-#ifdef STP_DBG
-		if (this->debug) {
+		if (STP_TRACING(this)) {
 			stp_trace ("%s", "InferiorRootAlternateInfo");
 		}
-#endif
 		return InferiorRootAlternateInfo;
 	}
 
-#ifdef STP_DBG
-	if (this->debug) {
+	if (STP_TRACING(this)) {
 		stp_trace ("%s", "OtherInfo");
 	}
-#endif
 	return OtherInfo;
 }
 
@@ -174,12 +161,12 @@ static Bool betterorsameinfo(STATE_MACH_T *this)
 {
 	register PORT_T *port = this->owner.port;
 
-	if (port->newInfo == Received && port->infoIs == Received &&
+	if (PORT_GET(port, newInfo) == Received && port->infoIs == Received &&
 	    STP_VECT_compare_vector (&port->msgPriority, &port->portPriority) <= 0) {
 		return True;
 	}
 	
-	if (port->newInfo == Mine && port->infoIs == Mine &&
+	if (PORT_GET(port, newInfo) == Mine && port->infoIs == Mine &&
 	    STP_VECT_compare_vector (&port->designatedPriority, &port->portPriority) <= 0) {
 		return True;
 	}
@@ -198,12 +185,12 @@ static void recordAgreement(STATE_MACH_T *this)
 	register PORT_T *port = this->owner.port;
 
 	if (port->owner->rstpVersion && 
-	    port->operPointToPointMac &&
+	    PORT_GET(port, operPointToPointMac) &&
 	    AGREEMENT_BIT & port->msgFlags) {
-		port->agreed = True;
-		port->proposing = False;
+		PORT_SET(port, agreed);
+		PORT_CLR(port, proposing);
 	} else {
-		port->agreed = False;
+		PORT_CLR(port, agreed);
 	}	
 }
 
@@ -218,8 +205,8 @@ static void recordDispute(STATE_MACH_T *this)
 	register PORT_T *port = this->owner.port;
 	
 	if (LEARN_BIT & port->msgFlags) {
-		port->agreed = True;
-		port->proposing = False;
+		PORT_SET(port, agreed);
+		PORT_CLR(port, proposing);
 	}
 }
 
@@ -235,7 +222,7 @@ static void recordProposal(STATE_MACH_T *this)
 
 	if (RSTP_PORT_ROLE_DESGN == port->msgPortRole &&
 	    (PROPOSAL_BIT & port->msgFlags)) {
-		port->proposed = True;
+		PORT_SET(port, proposed);
 	}
 }
 
@@ -274,32 +261,26 @@ static void setTcFlags(STATE_MACH_T *this)
 	register PORT_T *port = this->owner.port;
 
 	if (BPDU_TOPO_CHANGE_TYPE == port->msgBpduType) {
-#ifdef STP_DBG
-		if (this->debug) {
+		if (STP_TRACING(this)) {
 			stp_trace ("port %s rx rcvdTcn", port->port_name);
 		}
-#endif
-		port->rcvdTcn = True;
+		PORT_SET(port, rcvdTcn);
 	} else {
 		if (TOPOLOGY_CHANGE_BIT & port->msgFlags) {
-#ifdef STP_DBG
-			if (this->debug) {
+			if (STP_TRACING(this)) {
 				stp_trace("(%s-%s) rx rcvdTc 0X%lx",
 					  port->owner->name, port->port_name,
 					  (unsigned long) port->msgFlags);
 			}
-#endif
-			port->rcvdTc = True;
+			PORT_SET(port, rcvdTc);
 		}
 		if (TOPOLOGY_CHANGE_ACK_BIT & port->msgFlags) {
-#ifdef STP_DBG
-			if (this->debug) {
+			if (STP_TRACING(this)) {
 				stp_trace("port %s rx rcvdTcAck 0X%lx",
 					  port->port_name,
 					  (unsigned long) port->msgFlags);
 			}
-#endif
-			port->rcvdTcAck = True;
+			PORT_SET(port, rcvdTcAck);
 		}
 	}
 }
@@ -314,17 +295,17 @@ Bool updtBPDUVersion(STATE_MACH_T *this)
 	register PORT_T *port = this->owner.port;
 
 	if (BPDU_TOPO_CHANGE_TYPE == port->msgBpduType) {
-		port->rcvdSTP = True;
+		PORT_SET(port, rcvdSTP);
 	}
 
 	if (port->msgBpduVersion < 2) {
-		port->rcvdSTP = True;
+		PORT_SET(port, rcvdSTP);
 	}
   
 	if (BPDU_RSTP == port->msgBpduType) {
 		/* port->port->owner->ForceVersion >= NORMAL_RSTP
 		   we have checked in STP_info_rx_bpdu */
-		port->rcvdRSTP = True;
+		PORT_SET(port, rcvdRSTP);
 	}
 
 	return True;
@@ -353,25 +334,22 @@ static Bool updtRcvdInfoWhile(STATE_MACH_T *this)
 		} else {
 			dt = dm;
 		}
-		port->rcvdInfoWhile = dt;
+		PORT_TIMER(port, rcvdInfoWhile) = dt;
 #if 0
 		stp_trace("ma=%d eff_age=%d dm=%d dt=%d p=%s",
 			  (int) port->portTimes.MessageAge,
 			  (int) eff_age, (int) dm, (int) dt, port->port_name);
 #endif
 	} else {
-		port->rcvdInfoWhile = 0;
+		PORT_TIMER(port, rcvdInfoWhile) = 0;
 /****/
-#ifdef STP_DBG
-		/*if (this->debug) */
-		{
+		if (STP_TRACING(this)) {
 			stp_trace("port %s: MaxAge=%d MessageAge=%d HelloTime=%d rcvdInfoWhile=null !",
 				  port->port_name,
 				  (int) port->portTimes.MaxAge,
 				  (int) port->portTimes.MessageAge,
 				  (int) port->portTimes.HelloTime);
 		}
-#endif
 /****/
 	}
 
@@ -406,27 +384,23 @@ void STP_info_rx_bpdu(PORT_T *port, struct stp_bpdu_t *bpdu, size_t len)
 	switch (bpdu->hdr.bpdu_type) {
 		case BPDU_CONFIG_TYPE:
 			port->rx_cfg_bpdu_cnt++;
-#ifdef STP_DBG
-			if (port->info->debug) {
+			if (STP_TRACING(port->info)) {
 				stp_trace("CfgBpdu on port %s", port->port_name);
 			}
-#endif
-			if (port->admin_non_stp) {
+			if (PORT_GET(port, admin_non_stp)) {
 				return;
 			}
-			port->rcvdBPDU = True;
+			PORT_SET(port, rcvdBPDU);
 			break;
 		case BPDU_TOPO_CHANGE_TYPE:
 			port->rx_tcn_bpdu_cnt++;
-#ifdef STP_DBG
-			if (port->info->debug) {
+			if (STP_TRACING(port->info)) {
 				stp_trace("TcnBpdu on port %s", port->port_name);
 			}
-#endif
-			if (port->admin_non_stp) {
+			if (PORT_GET(port, admin_non_stp)) {
 				return;
 			}
-			port->rcvdBPDU = True;
+			PORT_SET(port, rcvdBPDU);
 			port->msgBpduVersion = bpdu->hdr.version;
 			port->msgBpduType = bpdu->hdr.bpdu_type;
 			return;
@@ -435,11 +409,11 @@ void STP_info_rx_bpdu(PORT_T *port, struct stp_bpdu_t *bpdu, size_t len)
 			return;
 		case BPDU_RSTP:
 			port->rx_rstp_bpdu_cnt++;
-			if (port->admin_non_stp) {
+			if (PORT_GET(port, admin_non_stp)) {
 				return;
 			}
 			if (port->owner->ForceVersion >= NORMAL_RSTP) {
-				port->rcvdBPDU = True;
+				PORT_SET(port, rcvdBPDU);
 			} else {
 				return;
 			}
@@ -455,9 +429,14 @@ void STP_info_rx_bpdu(PORT_T *port, struct stp_bpdu_t *bpdu, size_t len)
 	port->msgBpduType =    bpdu->hdr.bpdu_type;
 	port->msgFlags =       bpdu->body.flags;
 
+	/* valid, if it gives designated information, see the states */
+	memcpy(&port->rx_last_hdr, &bpdu->hdr, sizeof(BPDU_HEADER_T));
+	memcpy(&port->rx_last_body, &bpdu->body, sizeof(BPDU_BODY_T));
+	port->rx_last_valid = False;
+
 	/* 17.18.11 */
 	STP_VECT_get_vector(&bpdu->body, &port->msgPriority);
-	port->msgPriority.bridge_port = port->portId;
+	STP_VECT_set_bridge_port(&port->msgPriority, port->portId);
 
 	/* 17.18.12 */
 	STP_get_times(&bpdu->body, &port->msgTimes);
@@ -465,6 +444,81 @@ void STP_info_rx_bpdu(PORT_T *port, struct stp_bpdu_t *bpdu, size_t len)
 	/* 17.18.25, 17.18.26 : see setTcFlags() */
 }
 
+/*! \function Bool STP_info_rx_repeated(PORT_T *port, BPDU_T *bpdu)
+ *  \brief Fast path for a BPDU, that is a byte by byte repeat of the last
+ *  one, that gave designated information, while the port is settled with
+ *  that information. Without TC, TC Ack and Proposal flags such a repeat
+ *  only restarts rcvdInfoWhile (REPEATED_DESIGNATED) and sets, what the
+ *  Port Receive machine sets: that is done here and the machines are not
+ *  run. The Agreement flag needs no full path: recordAgreement is done
+ *  only for a message, that conveys a Root or Alternate Port Role
+ *  (NOT_DESIGNATED), the full path of such a repeat is
+ *  REPEATED_DESIGNATED too. Returns False, if the BPDU has to take the
+ *  full path.
+ */
+Bool STP_info_rx_repeated(PORT_T *port, BPDU_T *bpdu)
+{
+	register STPM_T *stpm = port->owner;
+	Bool rcvdRSTP, rcvdSTP;
+
+	if (!stpm->rx_fast || !port->rx_last_valid ||
+	    memcmp(&port->rx_last_body, &bpdu->body, sizeof(BPDU_BODY_T)) ||
+	    memcmp(&port->rx_last_hdr, &bpdu->hdr, sizeof(BPDU_HEADER_T))) {
+		return False;
+	}
+
+	if (bpdu->body.flags & (TOPOLOGY_CHANGE_BIT | PROPOSAL_BIT |
+				TOPOLOGY_CHANGE_ACK_BIT)) {
+		return False;
+	}
+
+	if (CURRENT != port->info->State ||
+	    Received != port->infoIs ||
+	    !PORT_FLAGS_ARE(port, PORT_FLAG(portEnabled) |
+				  PORT_FLAG(selected) |
+				  PORT_FLAG(reselect) |
+				  PORT_FLAG(updtInfo) |
+				  PORT_FLAG(rcvdBPDU) |
+				  PORT_FLAG(rcvdMsg) |
+				  PORT_FLAG(operEdge) |
+				  PORT_FLAG(admin_non_stp),
+			    PORT_FLAG(portEnabled) |
+			    PORT_FLAG(selected))) {
+		return False;
+	}
+
+	/* updtBPDUVersion; what could move the Port Protocol Migration
+	 * (SENSING) takes the full path */
+	rcvdRSTP = BPDU_RSTP == bpdu->hdr.bpdu_type;
+	rcvdSTP = bpdu->hdr.version < 2;
+	if (rcvdRSTP && stpm->ForceVersion < NORMAL_RSTP) {
+		return False;
+	}
+	if ((rcvdRSTP && stpm->rstpVersion && !PORT_GET(port, sendRSTP)) ||
+	    (rcvdSTP && PORT_GET(port, sendRSTP))) {
+		return False;
+	}
+	if (!STP_roletrns_restart_timers(port)) {
+		return False;
+	}
+
+	if (rcvdRSTP) {
+		port->rx_rstp_bpdu_cnt++;
+		PORT_SET(port, rcvdRSTP);
+	} else {
+		port->rx_cfg_bpdu_cnt++;
+	}
+	if (rcvdSTP) {
+		PORT_SET(port, rcvdSTP);
+	}
+	PORT_TIMER(port, edgeDelayWhile) = MigrateTime;
+	updtRcvdInfoWhile(port->info);
+
+	port->rx_fast_bpdu_cnt++;
+	stpm->rx_fast_bpdus++;
+	return True;
+}
+
 /*! \function void STP_info_enter_state(STATE_MACH_T *this)
  *  \brief Implements
  */
@@ -482,37 +536,50 @@ void STP_info_enter_state(STATE_MACH_T *this)
 			port->rx_cfg_bpdu_cnt = 0;
 			port->rx_rstp_bpdu_cnt = 0;
 			port->rx_tcn_bpdu_cnt = 0;
+			port->rx_fast_bpdu_cnt = 0;
       
 		case DISABLED:
-			port->rcvdMsg = False;
-			port->proposing = port->proposed = port->agree = port->agreed = False;
-			port->rcvdInfoWhile = 0;
+			port->rx_last_valid = False;
+			PORT_CLR(port, rcvdMsg);
+			PORT_CLR_FLAGS(port, PORT_FLAG(proposing) |
+					     PORT_FLAG(proposed) |
+					     PORT_FLAG(agree) |
+					     PORT_FLAG(agreed));
+			PORT_TIMER(port, rcvdInfoWhile) = 0;
 			port->infoIs = Disabled;
-			port->reselect = True;
-			port->selected = False;
+			STP_rolesel_reselect(port);
 			break;
 		case AGED:
+			port->rx_last_valid = False;
 			port->infoIs = Aged;
-			port->reselect = True;
-			port->selected = False;
+			STP_rolesel_reselect(port);
 			break;
 		case UPDATE:
-			port->proposing = port->proposed = False;
-			port->agreed = port->agreed && betterorsameinfo(this);
-			port->synced = port->synced && port->agreed;
+			PORT_CLR_FLAGS(port, PORT_FLAG(proposing) |
+					     PORT_FLAG(proposed));
+			if (!betterorsameinfo(this)) {
+				PORT_CLR(port, agreed);
+			}
+			if (!PORT_GET(port, agreed)) {
+				PORT_CLR(port, synced);
+			}
 			
 			STP_VECT_copy(&port->portPriority, &port->designatedPriority);
 			STP_copy_times(&port->portTimes, &port->designatedTimes);
+			port->rx_last_valid = False;
 			
-			port->updtInfo = False;
+			PORT_CLR(port, updtInfo);
 			port->infoIs = Mine;
-			port->newInfo = True;
-#ifdef STP_DBG
-			if (this->debug) {
+			PORT_SET(port, newInfo);
+			STP_rolesel_port_changed(port);
+			if (STP_TRACING(this)) {
+				BRIDGE_ID design_bridge;
+
+				STP_VECT_get_design_bridge(&port->portPriority,
+							   &design_bridge);
 				STP_VECT_br_id_print("updated: portPriority.design_bridge",
-						     &port->portPriority.design_bridge, True);
+						     &design_bridge, True);
 			}
-#endif
 			break;
 		case CURRENT:
 			break;
@@ -520,35 +587,39 @@ void STP_info_enter_state(STATE_MACH_T *this)
 			port->rcvdInfo = rcvInfo (this);
 			break;
 		case SUPERIOR_DESIGNATED:
-			port->agreed = port->proposing = False;
+			PORT_CLR_FLAGS(port, PORT_FLAG(agreed) |
+					     PORT_FLAG(proposing));
 			recordProposal(this);
 			setTcFlags(this);
-			port->agree = port->agree && betterorsameinfo(this);
+			if (!betterorsameinfo(this)) {
+				PORT_CLR(port, agree);
+			}
 			recordPriority(this);
 			recordTimes(this);
 			updtRcvdInfoWhile(this);
 			port->infoIs = Received;
-			port->reselect = True;
-			port->selected = False;
-			port->rcvdMsg = False;
+			port->rx_last_valid = True;
+			STP_rolesel_reselect(port);
+			PORT_CLR(port, rcvdMsg);
 			break;
 		case REPEATED_DESIGNATED:
 			recordProposal(this);
 			setTcFlags(this);
 			updtRcvdInfoWhile(this);
-			port->rcvdMsg = False;
+			PORT_CLR(port, rcvdMsg);
+			port->rx_last_valid = True;
 			break;
 		case INFERIOR_DESIGNATED:
 			recordDispute(this);
-			port->rcvdMsg = False;
+			PORT_CLR(port, rcvdMsg);
 			break;
 		case NOT_DESIGNATED:
 			recordAgreement(this);
 			setTcFlags(this);
-			port->rcvdMsg = False;
+			PORT_CLR(port, rcvdMsg);
 			break;
 		case OTHER:
-			port->rcvdMsg = False;
+			PORT_CLR(port, rcvdMsg);
 			break;
 	}
 }
@@ -560,21 +631,23 @@ Bool STP_info_check_conditions(STATE_MACH_T *this)
 {
 	register PORT_T *port = this->owner.port;
 
-	if ((!port->portEnabled && port->infoIs != Disabled) || BEGIN == this->State) {
+	if ((!PORT_GET(port, portEnabled) && port->infoIs != Disabled) ||
+	    BEGIN == this->State) {
 		return STP_hop_2_state(this, DISABLED);
 	}
 
 	switch (this->State) {
 		case DISABLED:
-			if (port->portEnabled) {
+			if (PORT_GET(port, portEnabled)) {
 				return STP_hop_2_state(this, AGED);
 			}
-			if (port->rcvdMsg) {
+			if (PORT_GET(port, rcvdMsg)) {
 				return STP_hop_2_state(this, DISABLED);
 			}
 			break;
 		case AGED:
-			if (port->selected && port->updtInfo) {
+			if (PORT_ALL_FLAGS(port, PORT_FLAG(selected) |
+						 PORT_FLAG(updtInfo))) {
 				return STP_hop_2_state(this, UPDATE);
 			}
 			break;
@@ -582,17 +655,19 @@ Bool STP_info_check_conditions(STATE_MACH_T *this)
 			return STP_hop_2_state(this, CURRENT);
 			break;
 		case CURRENT:
-			if (port->selected && port->updtInfo) {
+			if (PORT_ALL_FLAGS(port, PORT_FLAG(selected) |
+						 PORT_FLAG(updtInfo))) {
 				return STP_hop_2_state(this, UPDATE);
 			}
 
 			if (Received == port->infoIs &&
-			    !port->rcvdInfoWhile &&
-			    !port->updtInfo &&
-			    !port->rcvdMsg) {
+			    !PORT_TIMER(port, rcvdInfoWhile) &&
+			    !PORT_GET(port, updtInfo) &&
+			    !PORT_GET(port, rcvdMsg)) {
 				return STP_hop_2_state(this, AGED);
 			}
-			if (port->rcvdMsg && !port->updtInfo) {
+			if (PORT_GET(port, rcvdMsg) &&
+			    !PORT_GET(port, updtInfo)) {
 				return STP_hop_2_state(this, RECEIVE);
 			}
 			break;
@@ -33,6 +33,8 @@ Bool STP_info_check_conditions(STATE_MACH_T *s);
 
 void STP_info_rx_bpdu(PORT_T *this, struct stp_bpdu_t *bpdu, size_t len);
 
+Bool STP_info_rx_repeated(PORT_T *this, struct stp_bpdu_t *bpdu);
+
 char *STP_info_get_state_name(int state);
 
 #endif /* _STP_INFOR_H__ */
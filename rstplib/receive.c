@@ -43,15 +43,18 @@ void STP_receive_enter_state(STATE_MACH_T *this)
 	switch (this->State) {
 		case BEGIN:
 		case DISCARD:
-			port->rcvdBPDU = port->rcvdRSTP = port->rcvdSTP = False;
-			port->rcvdMsg = False;
-			port->edgeDelayWhile = MigrateTime;
+			PORT_CLR_FLAGS(port, PORT_FLAG(rcvdBPDU) |
+					     PORT_FLAG(rcvdRSTP) |
+					     PORT_FLAG(rcvdSTP) |
+					     PORT_FLAG(rcvdMsg));
+			PORT_TIMER(port, edgeDelayWhile) = MigrateTime;
 			break;
 		case RECEIVE:
 			updtBPDUVersion(this);
-			port->operEdge = port->rcvdBPDU = False;
-			port->rcvdMsg = True;
-			port->edgeDelayWhile = MigrateTime;
+			PORT_CLR_FLAGS(port, PORT_FLAG(operEdge) |
+					     PORT_FLAG(rcvdBPDU));
+			PORT_SET(port, rcvdMsg);
+			PORT_TIMER(port, edgeDelayWhile) = MigrateTime;
 			break;
 	};
 }
@@ -61,18 +64,23 @@ Bool STP_receive_check_conditions(STATE_MACH_T *this)
 	register PORT_T *port = this->owner.port;
 
 	if (BEGIN == this->State ||
-	    ((port->rcvdBPDU || (port->edgeDelayWhile != MigrateTime)) && !port->portEnabled)) {
+	    ((PORT_GET(port, rcvdBPDU) ||
+	      (PORT_TIMER(port, edgeDelayWhile) != MigrateTime)) &&
+	     !PORT_GET(port, portEnabled))) {
 		return STP_hop_2_state(this, DISCARD);
 	}
 	
 	switch (this->State) {
 		case DISCARD:
-			if (port->rcvdBPDU && port->portEnabled) {
+			if (PORT_ALL_FLAGS(port, PORT_FLAG(rcvdBPDU) |
+						 PORT_FLAG(portEnabled))) {
 				return STP_hop_2_state(this, RECEIVE);
 			}
 			break;
 		case RECEIVE:
-			if (port->rcvdBPDU && port->portEnabled && !port->rcvdMsg) {
+			if (PORT_ALL_FLAGS(port, PORT_FLAG(rcvdBPDU) |
+						 PORT_FLAG(portEnabled)) &&
+			    !PORT_GET(port, rcvdMsg)) {
 				return STP_hop_2_state(this, RECEIVE);
 			}
 			break;
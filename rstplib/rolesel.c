@@ -23,6 +23,7 @@
 /* Port Role Selection state machine : 17.28 */
 
 #include "base.h"
+#include "arena.h"
 #include "stpm.h"
 
 #define STATES { \
@@ -58,9 +59,12 @@ void stp_dbg_break_point (PORT_T * port, STPM_T* stpm)
  */
 static Bool _is_backup_port(PORT_T *port, STPM_T *this)
 {
-	if (!STP_VECT_compare_bridge_id
-	    (&port->portPriority.design_bridge, &this->BridgeIdentifier) &&
-	    port->portPriority.design_port != this->rootPortId) {
+	BRIDGE_ID design_bridge;
+
+	STP_VECT_get_design_bridge(&port->portPriority, &design_bridge);
+	if (!STP_VECT_compare_bridge_id(&design_bridge,
+					&this->BridgeIdentifier) &&
+	    STP_VECT_DESIGN_PORT(&port->portPriority) != this->rootPortId) {
 #if 0 /* def STP_DBG */
 		if (port->info->debug) {
 			STP_VECT_br_id_print("portPriority.design_bridge",
@@ -113,13 +117,11 @@ static void setRoleSelected(char *reason, STPM_T *stpm, PORT_T *port,
 			return;
 	}
 
-#ifdef STP_DBG
-	if (port->roletrns->debug) {
+	if (STP_TRACING(port->roletrns)) {
 		stp_trace("%s(%s-%s) => %s",
 			  reason, stpm->name,
 			  port->port_name, new_role_name);
 	}
-#endif
 }
 
 /*! \function static void updtRoleDisableTree(STPM_T *this)
@@ -132,22 +134,141 @@ static void updtRoleDisableTree(STPM_T *this)
 
 	for (port = this->ports; port; port = port->next) {
 		port->selectedRole = DisabledPort;
+		STP_stpm_mark_port(port);
 	}
+	this->sel_valid = False;
 }
 
 /*! \function static void clearReselectTree(STPM_T *this)
  *  \brief Implements 17.21.2
- *  Clears reselect for all Ports of the Bridge.
+ *  Clears reselect for all Ports of the Bridge. The ports, that have it
+ *  set, are all in sel_changed (STP_rolesel_reselect): only the queued
+ *  ports are visited.
  */
 static void clearReselectTree(STPM_T *this)
 {
 	register PORT_T *port;
 
+	for (port = this->sel_changed; port; port = port->sel_next) {
+		PORT_CLR(port, reselect);
+	}
+	this->reselect_ports = 0;
+}
+
+/* The selection keeps a tournament tree over the ports of the bridge:
+ * leaf sel_leaves + port->sel_leaf holds the port, if it has a root path
+ * priority vector (17.4.2.2), each node above holds the better one of its
+ * two children. A change of one port replays its way to the top only, so
+ * the best root path priority vector of the bridge is found in O(log n).
+ * Leaves are numbered in the order of the list of ports; on equal vectors
+ * the left one wins, as the first one did in the scan of the list. */
+
+static Bool _rolesel_candidate(PORT_T *port)
+{
+	return !PORT_GET(port, admin_non_stp) && Received == port->infoIs;
+}
+
+static void _rolesel_root_path_prio(PORT_T *port, PRIO_VECTOR_T *prio)
+{
+	STP_VECT_copy(prio, &port->portPriority);
+	STP_VECT_set_root_path_cost(prio,
+		STP_VECT_ROOT_PATH_COST(prio) + port->portId);
+}
+
+/* left is the one with the lower leaves */
+static PORT_T *_rolesel_better(PORT_T *left, PORT_T *right)
+{
+	PRIO_VECTOR_T left_prio, right_prio;
+
+	if (!left || !right) {
+		return left ? left : right;
+	}
+	_rolesel_root_path_prio(left, &left_prio);
+	_rolesel_root_path_prio(right, &right_prio);
+	return STP_VECT_compare_vector(&right_prio, &left_prio) < 0 ?
+		right : left;
+}
+
+/* Renumbers the leaves after ports came or went and fills all the tree */
+static void _rolesel_build_tree(STPM_T *this)
+{
+	register PORT_T *port;
+	register int iii, leaves;
+
+	iii = 0;
+	for (port = this->ports; port; port = port->next) {
+		iii++;
+	}
+	for (leaves = 1; leaves < iii; leaves <<= 1)
+		;
+
+	if (leaves != this->sel_leaves) {
+		if (this->sel_tree) {
+			STP_arena_free(this->sel_tree, 2 * this->sel_leaves *
+						       sizeof(PORT_T *));
+		}
+		this->sel_tree = (PORT_T **)
+			STP_arena_alloc(2 * leaves * sizeof(PORT_T *));
+		if (!this->sel_tree) {
+			STP_FATAL("malloc", "role selection tree", -6);
+		}
+		this->sel_leaves = leaves;
+	}
+
+	iii = 0;
 	for (port = this->ports; port; port = port->next) {
-		port->reselect = False;
+		port->sel_leaf = iii;
+		port->sel_queued = False;
+		this->sel_tree[leaves + iii++] =
+			_rolesel_candidate(port) ? port : NULL;
+	}
+	while (iii < leaves) {
+		this->sel_tree[leaves + iii++] = NULL;
+	}
+	for (iii = leaves - 1; iii > 0; iii--) {
+		this->sel_tree[iii] = _rolesel_better(this->sel_tree[2 * iii],
+						      this->sel_tree[2 * iii + 1]);
+	}
+	this->sel_changed = NULL;
+}
+
+static void _rolesel_update_leaf(STPM_T *this, PORT_T *port)
+{
+	register int iii;
+
+	iii = this->sel_leaves + port->sel_leaf;
+	this->sel_tree[iii] = _rolesel_candidate(port) ? port : NULL;
+	for (iii >>= 1; iii > 0; iii >>= 1) {
+		this->sel_tree[iii] = _rolesel_better(this->sel_tree[2 * iii],
+						      this->sel_tree[2 * iii + 1]);
 	}
 }
 
+/* The information of the port (infoIs, portPriority, portTimes, portId
+ * or admin_non_stp) has changed: the next selection looks at it */
+void STP_rolesel_port_changed(PORT_T *port)
+{
+	if (port->sel_queued) {
+		return;
+	}
+	port->sel_queued = True;
+	port->sel_next = port->owner->sel_changed;
+	port->owner->sel_changed = port;
+}
+
+/* reselect = TRUE; selected = FALSE, as the machines and the management
+ * do it: the port is queued for the next selection and counted in
+ * reselect_ports, that the selection checks instead of the ports */
+void STP_rolesel_reselect(PORT_T *port)
+{
+	if (!PORT_GET(port, reselect)) {
+		PORT_SET(port, reselect);
+		port->owner->reselect_ports++;
+	}
+	PORT_CLR(port, selected);
+	STP_rolesel_port_changed(port);
+}
+
 /*! \function static void updtRootPriority(STATE_MACH_T *this)
  *  \brief Implements 17.21.25 subfunction (a), (b) & (c).
  *     a) The root path priority vector for each Port that has a port priority
@@ -175,32 +296,127 @@ static void updtRootPriority(STATE_MACH_T *this)
 
 	stpm = this->owner.stpm;
 
-	for (port = stpm->ports; port; port = port->next) {
-		if (port->admin_non_stp) {
-			continue;
+	if (!stpm->sel_valid) {
+		_rolesel_build_tree(stpm);
+	} else {
+		for (port = stpm->sel_changed; port; port = port->sel_next) {
+			_rolesel_update_leaf(stpm, port);
 		}
+	}
 
-		if (Received == port->infoIs) {
-			STP_VECT_copy(&rootPathPrio, &port->portPriority);
-			rootPathPrio.root_path_cost += port->portId;
+	port = stpm->sel_tree[1];
+	if (!port) {
+		return;
+	}
 
-			if (STP_VECT_compare_vector (&rootPathPrio, &stpm->rootPriority) < 0) {
-				STP_VECT_copy(&stpm->rootPriority, &rootPathPrio);
-				STP_copy_times(&stpm->rootTimes, &port->portTimes);
-				dm = (8 +  stpm->rootTimes.MaxAge) / 16;
-				if (!dm) {
-					dm = 1;
-				}
-				stpm->rootTimes.MessageAge += dm;
-#ifdef STP_DBG
-				if (port->roletrns->debug) {
-					stp_trace("updtRootPriority: dm=%d rootTimes.MessageAge=%d on port %s",
-						  (int)dm, (int)stpm->rootTimes.MessageAge,
-						  port->port_name);
+	_rolesel_root_path_prio(port, &rootPathPrio);
+	if (STP_VECT_compare_vector (&rootPathPrio, &stpm->rootPriority) < 0) {
+		STP_VECT_copy(&stpm->rootPriority, &rootPathPrio);
+		STP_copy_times(&stpm->rootTimes, &port->portTimes);
+		dm = (8 +  stpm->rootTimes.MaxAge) / 16;
+		if (!dm) {
+			dm = 1;
+		}
+		stpm->rootTimes.MessageAge += dm;
+		if (STP_TRACING(port->roletrns)) {
+			stp_trace("updtRootPriority: dm=%d rootTimes.MessageAge=%d on port %s",
+				  (int)dm, (int)stpm->rootTimes.MessageAge,
+				  port->port_name);
+		}
+	}
+}
+
+/* (d) & (e) for one port */
+static void updtDesignated(STPM_T *stpm, PORT_T *port, BRIDGE_ID *root_bridge)
+{
+	STP_VECT_create(&port->designatedPriority,
+			root_bridge,
+			STP_VECT_ROOT_PATH_COST(&stpm->rootPriority),
+			&stpm->BridgeIdentifier, port->portId, port->portId);
+	STP_copy_times(&port->designatedTimes, &stpm->rootTimes);
+	port->designatedTimes.HelloTime = stpm->BridgeTimes.HelloTime;
+}
+
+/* (f), (g), (h), (i), (j), (k) and (l) for one port */
+static void updtRole(STPM_T *stpm, PORT_T *port)
+{
+	if (PORT_GET(port, admin_non_stp)) {
+		setRoleSelected("Non", stpm, port, NonStpPort);
+		PORT_SET_FLAGS(port, PORT_FLAG(forward) |
+				     PORT_FLAG(learn));
+		return;
+	}
+
+	switch (port->infoIs) {
+		case Disabled:
+			setRoleSelected("Dis", stpm, port, DisabledPort);
+			break;
+		case Aged:
+			setRoleSelected("Age", stpm, port, DesignatedPort);
+			PORT_SET(port, updtInfo);
+			break;
+		case Mine:
+			/*     h) If the port priority vector was derived from another port on the
+			 *        Bridge or from the Bridge itself as the Root Bridge (infoIs = Mine),
+			 *        selectedRole is set to DesignatedPort. Additionally, updtInfo is set
+			 *        if the port priority vector differs from the designated priority
+			 *        vector or the Port's associated timer parameters differ from those
+			 *        for the Root Port.
+			 */
+			setRoleSelected("Mine", stpm, port, DesignatedPort);
+			if (0 != STP_VECT_compare_vector(&port->portPriority,
+			    &port->designatedPriority) ||
+			    0 != STP_compare_times(&port->portTimes,
+			    &stpm->rootTimes)) {
+				PORT_SET(port, updtInfo);
+			}
+			break;
+		case Received:
+			if (stpm->rootPortId == port->portId) {
+				/*     i) If the port priority vector was received in a Configuration Message
+				 *        and is not aged (infoIs == Received), and the root priority vector
+				 *        is now derived from it, selectedRole is set to RootPort and updtInfo
+				 *        is reset.
+				 */
+				setRoleSelected("Rec", stpm, port, RootPort);
+			} else if (STP_VECT_compare_vector (&port->designatedPriority, &port->portPriority) < 0) {
+				/*     l) If the port priority vector was received in a Configuration Message
+				 *        and is not aged (infoIs == Received), the root priority vector is
+				 *        not now derived from it, the designated priority vector is higher
+				 *        than the port priority vector, selectedRole is set to DesignatedPort
+				 *        and updtInfo is set.
+				 */
+				setRoleSelected("Rec", stpm, port, DesignatedPort);
+				PORT_SET(port, updtInfo);
+				break;
+			} else {
+				if (_is_backup_port (port, stpm)) {
+					/*     k) If the port priority vector was received in a Configuration Message
+					 *        and is not aged (infoIs = Received), the root priority vector is not
+					 *        now derived from it, the designated priority vector is not higher
+					 *        than the port priority vector, and the designated bridge and
+					 *        designated port components of the port priority vector reflect
+					 *        another port on this bridge, selectedRole is set to BackupPort and
+					 *        updtInfo is reset.
+					 */
+					setRoleSelected("rec", stpm, port, BackupPort);
+				} else {
+					/*     j) If the port priority vector was received in a Configuration Message
+					 *        and is not aged (infoIs = Received), the root priority vector is not
+					 *        now derived from it, the designated priority vector is not higher
+					 *        than the port priority vector, and the designated bridge and
+					 *        designated port components of the port priority vector do not
+					 *        reflect another port on this bridge, selectedRole is set to
+					 *        AlternatePort and updtInfo is reset.
+					 */
+					setRoleSelected("rec", stpm, port, AlternatePort);
 				}
-#endif
 			}
-		}
+			PORT_CLR(port, updtInfo);
+			break;
+		default:
+			stp_trace("undef infoIs=%d", (int) port->infoIs);
+			break;
 	}
 }
 
@@ -254,6 +470,8 @@ static void updtRolesTree(STATE_MACH_T *this)
 	register PORT_T *port;
 	register STPM_T *stpm;
 	PORT_ID old_root_port; /* for tracing of root port changing */
+	BRIDGE_ID root_bridge;
+	Bool all_ports;
 
 	stpm = this->owner.stpm;
 	old_root_port = stpm->rootPortId;
@@ -267,32 +485,9 @@ static void updtRolesTree(STATE_MACH_T *this)
 	/* (a), (b) & (c) */
 	updtRootPriority(this);
 
-	/* (d) & (e) */
-	for (port = stpm->ports; port; port = port->next) {
-		if (port->admin_non_stp) {
-			continue;
-		}
-		STP_VECT_create(&port->designatedPriority,
-				&stpm->rootPriority.root_bridge,
-				stpm->rootPriority.root_path_cost,
-				&stpm->BridgeIdentifier, port->portId, port->portId);
-		STP_copy_times(&port->designatedTimes, &stpm->rootTimes);
-		port->designatedTimes.HelloTime = stpm->BridgeTimes.HelloTime;
-
-#if 0
-#ifdef STP_DBG
-		if (port->roletrns->debug) {
-			STP_VECT_br_id_print("ch:designatedPriority.designated_bridge",
-					     &port->designatedPriorityrity.designated_bridge, True);
-		}
-#endif
-#endif
-	}
+	stpm->rootPortId = STP_VECT_BRIDGE_PORT(&stpm->rootPriority);
 
-	stpm->rootPortId = stpm->rootPriority.bridge_port;
-
-#ifdef STP_DBG
-	if (old_root_port != stpm->rootPortId) {
+	if (STP_TRACING(stpm->rolesel) && old_root_port != stpm->rootPortId) {
 		if (!stpm->rootPortId) {
 			stp_trace("\nbrige %s became root", stpm->name);
 		} else {
@@ -301,88 +496,38 @@ static void updtRolesTree(STATE_MACH_T *this)
 				  STP_stpm_get_port_name_by_id (stpm, stpm->rootPortId));
 		}
 	}
-#endif
 
-	/* (f), (g), (h), (i), (j), (k) and (l) */
-	for (port = stpm->ports; port; port = port->next) {
-		if (port->admin_non_stp) {
-			setRoleSelected("Non", stpm, port, NonStpPort);
-			port->forward = port->learn = True;
-			continue;
+	/* The designated vector, times and role of a port depend on its own
+	 * information and on the values below only: while they stay, the
+	 * ports, that have not changed, keep what they got last time */
+	all_ports = !stpm->sel_valid ||
+		    STP_VECT_compare_vector(&stpm->rootPriority,
+					    &stpm->sel_rootPriority) ||
+		    STP_compare_times(&stpm->rootTimes, &stpm->sel_rootTimes) ||
+		    STP_VECT_compare_bridge_id(&stpm->BridgeIdentifier,
+					       &stpm->sel_bridge) ||
+		    STP_compare_times(&stpm->BridgeTimes,
+				      &stpm->sel_bridgeTimes);
+
+	/* (d) & (e), then (f), (g), (h), (i), (j), (k) and (l); the
+	 * ports, that were updated, stay in sel_changed for setSelectedTree */
+	STP_VECT_get_root_bridge(&stpm->rootPriority, &root_bridge);
+	for (port = all_ports ? stpm->ports : stpm->sel_changed; port;
+	     port = all_ports ? port->next : port->sel_next) {
+		if (all_ports) {
+			STP_rolesel_port_changed(port);
 		}
-
-		switch (port->infoIs) {
-			case Disabled:
-				setRoleSelected("Dis", stpm, port, DisabledPort);
-				break;
-			case Aged:
-				setRoleSelected("Age", stpm, port, DesignatedPort);
-				port->updtInfo = True;
-				break;
-			case Mine:
-				/*     h) If the port priority vector was derived from another port on the
-				 *        Bridge or from the Bridge itself as the Root Bridge (infoIs = Mine),
-				 *        selectedRole is set to DesignatedPort. Additionally, updtInfo is set
-				 *        if the port priority vector differs from the designated priority
-				 *        vector or the Port's associated timer parameters differ from those
-				 *        for the Root Port.
-				 */
-				setRoleSelected("Mine", stpm, port, DesignatedPort);
-				if (0 != STP_VECT_compare_vector(&port->portPriority,
-				    &port->designatedPriority) ||
-				    0 != STP_compare_times(&port->portTimes,
-				    &stpm->rootTimes)) {
-					port->updtInfo = True;
-				}
-				break;
-			case Received:
-				if (stpm->rootPortId == port->portId) {
-					/*     i) If the port priority vector was received in a Configuration Message
-					 *        and is not aged (infoIs == Received), and the root priority vector
-					 *        is now derived from it, selectedRole is set to RootPort and updtInfo
-					 *        is reset.
-					 */
-					setRoleSelected("Rec", stpm, port, RootPort);
-				} else if (STP_VECT_compare_vector (&port->designatedPriority, &port->portPriority) < 0) {
-					/*     l) If the port priority vector was received in a Configuration Message
-					 *        and is not aged (infoIs == Received), the root priority vector is
-					 *        not now derived from it, the designated priority vector is higher
-					 *        than the port priority vector, selectedRole is set to DesignatedPort
-					 *        and updtInfo is set.
-					 */
-					setRoleSelected("Rec", stpm, port, DesignatedPort);
-					port->updtInfo = True;
-					break;
-				} else {
-					if (_is_backup_port (port, stpm)) {
-						/*     k) If the port priority vector was received in a Configuration Message
-						 *        and is not aged (infoIs = Received), the root priority vector is not
-						 *        now derived from it, the designated priority vector is not higher
-						 *        than the port priority vector, and the designated bridge and
-						 *        designated port components of the port priority vector reflect
-						 *        another port on this bridge, selectedRole is set to BackupPort and
-						 *        updtInfo is reset.
-						 */
-						setRoleSelected("rec", stpm, port, BackupPort);
-					} else {
-						/*     j) If the port priority vector was received in a Configuration Message
-						 *        and is not aged (infoIs = Received), the root priority vector is not
-						 *        now derived from it, the designated priority vector is not higher
-						 *        than the port priority vector, and the designated bridge and
-						 *        designated port components of the port priority vector do not
-						 *        reflect another port on this bridge, selectedRole is set to
-						 *        AlternatePort and updtInfo is reset.
-						 */
-						setRoleSelected("rec", stpm, port, AlternatePort);
-					}
-				}
-				port->updtInfo = False;
-				break;
-			default:
-				stp_trace("undef infoIs=%d", (int) port->infoIs);
-				break;
+		if (!PORT_GET(port, admin_non_stp)) {
+			updtDesignated(stpm, port, &root_bridge);
 		}
+		updtRole(stpm, port);
 	}
+
+	STP_VECT_copy(&stpm->sel_rootPriority, &stpm->rootPriority);
+	STP_copy_times(&stpm->sel_rootTimes, &stpm->rootTimes);
+	memcpy(&stpm->sel_bridge, &stpm->BridgeIdentifier, sizeof(BRIDGE_ID));
+	STP_copy_times(&stpm->sel_bridgeTimes, &stpm->BridgeTimes);
+	stpm->sel_valid = True;
 }
 
 /*! \function static Bool setSelected Tree(STPM_T *this)
@@ -390,22 +535,35 @@ static void updtRolesTree(STATE_MACH_T *this)
  *  Sets the selected variable TRUE for all Ports of the Bridge if reselect
  *  is FALSE for all Ports. If reselect is TRUE for any Port, this procedure
  *  takes no action.
+ *  A port loses selected with reselect only, so the ports without it are
+ *  the ones updtRolesTree has left in sel_changed: they are set and
+ *  marked for STP_stpm_update, the list is done with.
  */
 static Bool setSelectedTree(STPM_T *this)
 {
 	register PORT_T *port;
+	PORT_T *next;
 
-	for (port = this->ports; port; port = port->next) {
-		if (port->reselect) {
-#ifdef STP_DBG
-			stp_trace("setSelectedBridge: TRUE=reselect on port %s", port->port_name);
-#endif
-			return False;
+	if (this->reselect_ports) {
+		if (STP_TRACING(this->rolesel)) {
+			stp_trace("setSelectedBridge: TRUE=reselect on %d ports",
+				  this->reselect_ports);
 		}
+		return False;
 	}
 
-	for (port = this->ports; port; port = port->next) {
-		port->selected = True;
+	port = this->sel_changed;
+	this->sel_changed = NULL;
+	for (; port; port = next) {
+		next = port->sel_next;
+		port->sel_queued = False;
+		PORT_SET(port, selected);
+		STP_stpm_mark_port(port);
+		if (PORT_GET(port, admin_non_stp)) {
+			/* the role transitions may have taken NonStpPort
+			 * away, every selection puts it back */
+			STP_rolesel_port_changed(port);
+		}
 	}
 	return True;
 }
@@ -432,7 +590,6 @@ void STP_rolesel_enter_state(STATE_MACH_T *this)
 Bool STP_rolesel_check_conditions(STATE_MACH_T *s)
 {
 	STPM_T *stpm;
-	register PORT_T *port;
 
 	if (BEGIN == s->State) {
 		return STP_hop_2_state (s, INIT_BRIDGE);
@@ -443,11 +600,8 @@ Bool STP_rolesel_check_conditions(STATE_MACH_T *s)
 			return STP_hop_2_state(s, ROLE_SELECTION);
 		case ROLE_SELECTION:
 			stpm = s->owner.stpm;
-			for (port = stpm->ports; port; port = port->next) {
-				if (port->reselect) {
-					/* stp_trace ("reselect on port %s", port->port_name); */
-					return STP_hop_2_state(s, ROLE_SELECTION);
-				}
+			if (stpm->reselect_ports) {
+				return STP_hop_2_state(s, ROLE_SELECTION);
 			}
 			break;
 	}
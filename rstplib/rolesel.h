@@ -31,5 +31,9 @@ Bool STP_rolesel_check_conditions(STATE_MACH_T *s);
 
 char *STP_rolesel_get_state_name(int state);
 
+void STP_rolesel_port_changed(PORT_T *port);
+
+void STP_rolesel_reselect(PORT_T *port);
+
 #endif /* _STP_ROLES_SELECT_H */
 
@@ -54,17 +54,28 @@
 #define GET_STATE_NAME STP_roletrns_get_state_name
 #include "choose.h"
 
+/* selected && !updtInfo */
+#define ROLE_READY(port)						\
+	PORT_FLAGS_ARE(port, PORT_FLAG(selected) | PORT_FLAG(updtInfo),	\
+		       PORT_FLAG(selected))
+
+/* and !learning && !forwarding */
+#define ROLE_READY_BLOCKED(port)					\
+	PORT_FLAGS_ARE(port, PORT_FLAG(learning) | PORT_FLAG(forwarding) | \
+			     PORT_FLAG(selected) | PORT_FLAG(updtInfo),	\
+		       PORT_FLAG(selected))
+
 /*! \function static void setSyncTree(STATE_MACH_T *this)
  *  \brief Implements 17.21.14
  *  Sets sync TRUE for all Ports of the Bridge.
  */
 static void setSyncTree(STATE_MACH_T *this)
 {
-	register PORT_T *port;
+	register PORT_T *port = this->owner.port;
 
-	for (port = this->owner.port->owner->ports; port; port = port->next) {
-		port->sync = True;
-	}
+	port->owner->sync_epoch++;
+	port->owner->tree_mark = True;
+	STP_stpm_port_catch_up(port);
 }
 
 /*! \function static void setReRootTree(STATE_MACH_T *this)
@@ -73,41 +84,29 @@ static void setSyncTree(STATE_MACH_T *this)
  */
 static void setReRootTree(STATE_MACH_T *this)
 {
-	register PORT_T *port;
+	register PORT_T *port = this->owner.port;
 
-	for (port = this->owner.port->owner->ports; port; port = port->next) {
-		port->reRoot = True;
-	}
+	port->owner->reroot_epoch++;
+	port->owner->tree_mark = True;
+	STP_stpm_port_catch_up(port);
 }
 
+/* allSynced: synced of all the other ports, from the counts of the
+ * bridge (the port itself is counted as it was before its machines
+ * ran, see STP_stpm_update) */
 static Bool compute_allsynced(PORT_T *this)
 {
-	register PORT_T *port;
+	register STPM_T *stpm = this->owner;
 
-	for (port = this->owner->ports; port; port = port->next) {
-		if (port->port_index == this->port_index) {
-			continue;
-		}
-		if (! port->synced) {
-			return False;
-		}
-	}
-	return True;
+	return stpm->synced_ports - (this->counted_synced ? 1 : 0) ==
+	       stpm->port_count - 1;
 }
 
+/* reRooted: rrWhile is zero on all the other ports */
 static Bool compute_rerooted(PORT_T *this)
 {
-	register PORT_T *port;
-
-	for (port = this->owner->ports; port; port = port->next) {
-		if (port->port_index == this->port_index) {
-			continue;
-		}
-		if (port->rrWhile) {
-			return False;
-		}
-	}
-	return True;
+	return this->owner->rerooting_ports -
+	       (this->counted_rerooting ? 1 : 0) == 0;
 }
 
 /*! \function static unsigned short compute_edgedelay(PORT_T *port, STPM_T *stpm)
@@ -117,7 +116,7 @@ static Bool compute_rerooted(PORT_T *this)
  */
 static unsigned short compute_edgedelay(PORT_T *port, STPM_T *stpm)
 {
-	if (port->operPointToPointMac) {
+	if (PORT_GET(port, operPointToPointMac)) {
 		return MigrateTime;
 	}
 	return stpm->rootTimes.MaxAge;
@@ -135,211 +134,223 @@ void STP_roletrns_enter_state(STATE_MACH_T *this)
 		case BEGIN:
 		case INIT_PORT:
 			port->role = DisabledPort;
-			port->learn = port->forward = False;
-			port->synced = False;
-			port->sync = port->reRoot = False;
-			port->rrWhile = stpm->rootTimes.ForwardDelay;
-			port->fdWhile = stpm->rootTimes.ForwardDelay;
-			port->rbWhile = 0;
-#ifdef STP_DBG
-			if (this->debug) {
+			PORT_CLR_FLAGS(port, PORT_FLAG(learn) |
+					     PORT_FLAG(forward) |
+					     PORT_FLAG(synced) |
+					     PORT_FLAG(sync) |
+					     PORT_FLAG(reRoot));
+			PORT_TIMER(port, rrWhile) = stpm->rootTimes.ForwardDelay;
+			PORT_TIMER(port, fdWhile) = stpm->rootTimes.ForwardDelay;
+			PORT_TIMER(port, rbWhile) = 0;
+			if (STP_TRACING(this)) {
 				STP_port_trace_flags("after init", port);
 			}
-#endif
 			break;
 		case DISABLE_PORT:
 			port->role = port->selectedRole;
-			port->learn = port->forward = False;
+			PORT_CLR_FLAGS(port, PORT_FLAG(learn) |
+					     PORT_FLAG(forward));
 			break;
 		case DISABLED_PORT:
-			port->fdWhile = stpm->rootTimes.MaxAge;
-			port->synced = True;
-			port->rrWhile = 0;
-			port->sync = port->reRoot = False;
+			PORT_TIMER(port, fdWhile) = stpm->rootTimes.MaxAge;
+			PORT_SET(port, synced);
+			PORT_TIMER(port, rrWhile) = 0;
+			PORT_CLR_FLAGS(port, PORT_FLAG(sync) |
+					     PORT_FLAG(reRoot));
 			break;
 
 		/* 17.29.2 Root Port states */
 		case ROOT_PORT:
 			port->role = RootPort;
-			port->rrWhile = stpm->rootTimes.ForwardDelay;
-#ifdef STP_DBG
-			if (this->debug) {
+			PORT_TIMER(port, rrWhile) = stpm->rootTimes.ForwardDelay;
+			if (STP_TRACING(this)) {
 				STP_port_trace_flags("ROOT_PORT", port);
 			}
-#endif
 			break;
 		case ROOT_PROPOSED:
 			setSyncTree (this);
-			port->proposed = False;
-#ifdef STP_DBG
-			if (this->debug) {
+			PORT_CLR(port, proposed);
+			if (STP_TRACING(this)) {
 				STP_port_trace_flags("ROOT_PROPOSED", port);
 			}
-#endif
 			break;
 		case ROOT_FORWARD:
-			port->fdWhile = 0;
-			port->forward = True;
-#ifdef STP_DBG
-			if (this->debug) {
+			PORT_TIMER(port, fdWhile) = 0;
+			PORT_SET(port, forward);
+			if (STP_TRACING(this)) {
 				STP_port_trace_flags("ROOT_FORWARD", port);
 			}
-#endif
 			break;
 		case ROOT_AGREED:
-			port->proposed = port->sync = False; /* in ROOT_AGREED */
-			port->agree = True; /* In ROOT_AGREED */
-			port->newInfo = True;
-#ifdef STP_DBG
-			if (this->debug) {
+			/* in ROOT_AGREED */
+			PORT_CLR_FLAGS(port, PORT_FLAG(proposed) |
+					     PORT_FLAG(sync));
+			PORT_SET(port, agree); /* In ROOT_AGREED */
+			PORT_SET(port, newInfo);
+			if (STP_TRACING(this)) {
 				STP_port_trace_flags("ROOT_AGREED", port);
 			}
-#endif
 			break;
 		case ROOT_LEARN:
-			port->fdWhile = stpm->rootTimes.ForwardDelay;
-			port->learn = True;
-#ifdef STP_DBG
-			if (this->debug) {
+			PORT_TIMER(port, fdWhile) = stpm->rootTimes.ForwardDelay;
+			PORT_SET(port, learn);
+			if (STP_TRACING(this)) {
 				STP_port_trace_flags("ROOT_LEARN", port);
 			}
-#endif
 			break;
 		case REROOT:
 			setReRootTree (this);
-#ifdef STP_DBG
-			if (this->debug) {
+			if (STP_TRACING(this)) {
 				STP_port_trace_flags("REROOT", port);
 			}
-#endif
 			break;
 		case REROOTED:
-			port->reRoot = False; /* In REROOTED */
-#ifdef STP_DBG
-			if (this->debug) {
+			PORT_CLR(port, reRoot); /* In REROOTED */
+			if (STP_TRACING(this)) {
 				STP_port_trace_flags("REROOTED", port);
 			}
-#endif
 			break;
 
 		/* 17.29.3 Designated Port states */
 		case DESIGNATED_PORT:
 			port->role = DesignatedPort;
-#ifdef STP_DBG
-			if (this->debug) {
+			if (STP_TRACING(this)) {
 				STP_port_trace_flags("DESIGNATED_PORT", port);
 			}
-#endif
 			break;
 		case DESIGNATED_PROPOSE:
-			port->proposing = True; /* in DESIGNATED_PROPOSE */
-			port->edgeDelayWhile = compute_edgedelay(port, stpm);
-			port->newInfo = True;
-#ifdef STP_DBG
-			if (this->debug) {
+			PORT_SET(port, proposing); /* in DESIGNATED_PROPOSE */
+			PORT_TIMER(port, edgeDelayWhile) = compute_edgedelay(port, stpm);
+			PORT_SET(port, newInfo);
+			if (STP_TRACING(this)) {
 				STP_port_trace_flags("DESIGNATED_PROPOSE", port);
 			}
-#endif
 			break;
 		case DESIGNATED_FORWARD:
-			port->forward = True;
-			port->fdWhile = 0;
-			port->agreed = port->sendRSTP;
-#ifdef STP_DBG
-			if (this->debug) {
+			PORT_SET(port, forward);
+			PORT_TIMER(port, fdWhile) = 0;
+			PORT_PUT(port, agreed, PORT_GET(port, sendRSTP));
+			if (STP_TRACING(this)) {
 				STP_port_trace_flags("DESIGNATED_FORWARD", port);
 			}
-#endif
 			break;
 		case DESIGNATED_SYNCED:
-			port->rrWhile = 0;
-			port->synced = True; /* DESIGNATED_SYNCED */
-			port->sync = False; /* DESIGNATED_SYNCED */
-#ifdef STP_DBG
-			if (this->debug) {
+			PORT_TIMER(port, rrWhile) = 0;
+			PORT_SET(port, synced); /* DESIGNATED_SYNCED */
+			PORT_CLR(port, sync); /* DESIGNATED_SYNCED */
+			if (STP_TRACING(this)) {
 				STP_port_trace_flags("DESIGNATED_SYNCED", port);
 			}
-#endif
 			break;
 		case DESIGNATED_LEARN:
-			port->learn = True;
-			port->fdWhile = stpm->rootTimes.ForwardDelay;
-#ifdef STP_DBG
-			if (this->debug) {
+			PORT_SET(port, learn);
+			PORT_TIMER(port, fdWhile) = stpm->rootTimes.ForwardDelay;
+			if (STP_TRACING(this)) {
 				STP_port_trace_flags("DESIGNATED_LEARN", port);
 			}
-#endif
 			break;
 		case DESIGNATED_RETIRED:
-			port->reRoot = False; /* DESIGNATED_RETIRED */
-#ifdef STP_DBG
-			if (this->debug) {
+			PORT_CLR(port, reRoot); /* DESIGNATED_RETIRED */
+			if (STP_TRACING(this)) {
 				STP_port_trace_flags("DESIGNATED_RETIRED", port);
 			}
-#endif
 			break;
 		case DESIGNATED_DISCARD:
-			port->learn = port->forward = port->disputed = False;
-			port->fdWhile = stpm->rootTimes.ForwardDelay;
-#ifdef STP_DBG
-			if (this->debug) {
+			PORT_CLR_FLAGS(port, PORT_FLAG(learn) |
+					     PORT_FLAG(forward) |
+					     PORT_FLAG(disputed));
+			PORT_TIMER(port, fdWhile) = stpm->rootTimes.ForwardDelay;
+			if (STP_TRACING(this)) {
 				STP_port_trace_flags("DESIGNATED_DISCARD", port);
 			}
-#endif
 			break;
 		
 		/* 17.29.4 Alternate Port states */
 		case ALTERNATE_PORT:
-			port->fdWhile = stpm->rootTimes.ForwardDelay;
-			port->synced = True;
-			port->rrWhile = 0;
-			port->sync = port->reRoot = False;
-#ifdef STP_DBG
-			if (this->debug) {
+			PORT_TIMER(port, fdWhile) = stpm->rootTimes.ForwardDelay;
+			PORT_SET(port, synced);
+			PORT_TIMER(port, rrWhile) = 0;
+			PORT_CLR_FLAGS(port, PORT_FLAG(sync) |
+					     PORT_FLAG(reRoot));
+			if (STP_TRACING(this)) {
 				STP_port_trace_flags("ALTERNATE_PORT", port);
 			}
-#endif
 			break;
 		case ALTERNATE_PROPOSED:
 			setSyncTree(this);
-			port->proposed = False;
-#ifdef STP_DBG
-			if (this->debug) {
+			PORT_CLR(port, proposed);
+			if (STP_TRACING(this)) {
 				STP_port_trace_flags("ALTERNATE_PROPOSED", port);
 			}
-#endif
 			break;
 		case ALTERNATE_AGREED:
-			port->proposed = False;
-			port->agree = True;
-			port->newInfo = True;
+			PORT_CLR(port, proposed);
+			PORT_SET(port, agree);
+			PORT_SET(port, newInfo);
 			
-#ifdef STP_DBG
-			if (this->debug) {
+			if (STP_TRACING(this)) {
 				STP_port_trace_flags("ALTERNATE_AGREED", port);
 			}
-#endif
 			break;
 		case BLOCK_PORT:
 			port->role = port->selectedRole;
-			port->learn = port->forward = False;
-#ifdef STP_DBG
-			if (this->debug) {
+			PORT_CLR_FLAGS(port, PORT_FLAG(learn) |
+					     PORT_FLAG(forward));
+			if (STP_TRACING(this)) {
 				STP_port_trace_flags("BLOCK_PORT", port);
 			}
-#endif	
 			break;
 		case BACKUP_PORT:
-			port->rbWhile = 2 * stpm->rootTimes.HelloTime;
-#ifdef STP_DBG
-			if (this->debug) {
+			PORT_TIMER(port, rbWhile) = 2 * stpm->rootTimes.HelloTime;
+			if (STP_TRACING(this)) {
 				STP_port_trace_flags("BACKUP_PORT", port);
 			}
-#endif
 			break;
 	};
 }
 
+/*! \function Bool STP_roletrns_restart_timers(PORT_T *port)
+ *  \brief ROOT_PORT keeps rrWhile at Forward Delay, ALTERNATE_PORT keeps
+ *  fdWhile at Forward Delay and, for a Backup Port, rbWhile at twice the
+ *  Hello Time: they re-enter the state, when the timer is not at that
+ *  value. For an enabled port, that is settled in one of these states,
+ *  after a tick or a repeated BPDU (STP_info_rx_repeated) re-entering is
+ *  all, that follows; it is done here without running the machines.
+ *  Returns False, if the machines of the port have to be checked.
+ */
+Bool STP_roletrns_restart_timers(PORT_T *port)
+{
+	register STPM_T *stpm = port->owner;
+
+	STP_stpm_port_catch_up(port);
+	if (!PORT_GET(port, portEnabled) || !ROLE_READY(port) ||
+	    port->role != port->selectedRole) {
+		return False;
+	}
+	switch (port->roletrns->State) {
+		case ROOT_PORT:
+			if (!PORT_TIMER(port, rrWhile)) {
+				return False; /* not counted, see reRooted */
+			}
+			PORT_TIMER(port, rrWhile) = stpm->rootTimes.ForwardDelay;
+			return True;
+		case ALTERNATE_PORT:
+			if (PORT_TIMER(port, rrWhile) ||
+			    !PORT_FLAGS_ARE(port, PORT_FLAG(sync) |
+						  PORT_FLAG(reRoot) |
+						  PORT_FLAG(synced),
+					    PORT_FLAG(synced))) {
+				return False;
+			}
+			if (port->role == BackupPort) { /* via BACKUP_PORT */
+				PORT_TIMER(port, rbWhile) = 2 * stpm->rootTimes.HelloTime;
+			}
+			PORT_TIMER(port, fdWhile) = stpm->rootTimes.ForwardDelay;
+			return True;
+	}
+	return False;
+}
+
 Bool STP_roletrns_check_conditions(STATE_MACH_T *this)
 {
 	register PORT_T *port = this->owner.port;
@@ -354,8 +365,7 @@ Bool STP_roletrns_check_conditions(STATE_MACH_T *this)
 	}
 
 	/* Non-initial entry states */
-	if (port->role != port->selectedRole &&
-	    port->selected && !port->updtInfo) {
+	if (port->role != port->selectedRole && ROLE_READY(port)) {
 		switch (port->selectedRole) {
 			case DisabledPort:
 #if 0 /* def STP_DBG */
@@ -388,16 +398,15 @@ Bool STP_roletrns_check_conditions(STATE_MACH_T *this)
 		case INIT_PORT:
 			return STP_hop_2_state(this, DISABLE_PORT);
 		case DISABLE_PORT:
-			if (!port->learning && !port->forwarding &&
-			    port->selected && !port->updtInfo) {
+			if (ROLE_READY_BLOCKED(port)) {
 				return STP_hop_2_state(this, DISABLED_PORT);
 			}
 			break;
 		case DISABLED_PORT:
-			if ((port->fdWhile != stpm->rootTimes.MaxAge ||
-			    port->sync ||
-			    port->reRoot ||
-			    !port->synced) && port->selected && !port->updtInfo) {
+			if ((PORT_TIMER(port, fdWhile) != stpm->rootTimes.MaxAge ||
+			    PORT_GET(port, sync) ||
+			    PORT_GET(port, reRoot) ||
+			    !PORT_GET(port, synced)) && ROLE_READY(port)) {
 				return STP_hop_2_state(this, DISABLED_PORT);
 			}
 			break;
@@ -412,34 +421,41 @@ Bool STP_roletrns_check_conditions(STATE_MACH_T *this)
 			return STP_hop_2_state(this, ROOT_PORT);
 
 		case ROOT_PORT:
-			if (port->selected && !port->updtInfo) {
-				if (!port->forward && !port->reRoot) {
+			if (ROLE_READY(port)) {
+				if (!PORT_ANY_FLAGS(port, PORT_FLAG(forward) |
+							  PORT_FLAG(reRoot))) {
 					return STP_hop_2_state(this, REROOT);
 				}
 				allSynced = compute_allsynced(port);
-				if ((allSynced && !port->agree) ||
-				    (port->proposed && port->agree)) {
+				if ((allSynced && !PORT_GET(port, agree)) ||
+				    PORT_ALL_FLAGS(port, PORT_FLAG(proposed) |
+							 PORT_FLAG(agree))) {
 					return STP_hop_2_state(this, ROOT_AGREED);
 				}
-				if (port->proposed && !port->agree) {
+				if (PORT_GET(port, proposed) &&
+				    !PORT_GET(port, agree)) {
 					return STP_hop_2_state(this, ROOT_PROPOSED);
 				}
 				allReRooted = compute_rerooted(port);
-				if ((!port->fdWhile ||
-				    (allReRooted && !port->rbWhile)) && stpm->rstpVersion &&
-				    port->learn && !port->forward) {
+				if ((!PORT_TIMER(port, fdWhile) ||
+				    (allReRooted && !PORT_TIMER(port, rbWhile) &&
+				     stpm->rstpVersion)) &&
+				    PORT_GET(port, learn) &&
+				    !PORT_GET(port, forward)) {
 					return STP_hop_2_state(this, ROOT_FORWARD);
 				}
-				if ((!port->fdWhile ||
-				    (allReRooted && !port->rbWhile)) && stpm->rstpVersion &&
-				    !port->learn) {
+				if ((!PORT_TIMER(port, fdWhile) ||
+				    (allReRooted && !PORT_TIMER(port, rbWhile) &&
+				     stpm->rstpVersion)) &&
+				    !PORT_GET(port, learn)) {
 					return STP_hop_2_state(this, ROOT_LEARN);
 				}
 
-				if (port->reRoot && port->forward) {
+				if (PORT_ALL_FLAGS(port, PORT_FLAG(reRoot) |
+							 PORT_FLAG(forward))) {
 					return STP_hop_2_state(this, REROOTED);
 				}
-				if (port->rrWhile != stpm->rootTimes.ForwardDelay) {
+				if (PORT_TIMER(port, rrWhile) != stpm->rootTimes.ForwardDelay) {
 					return STP_hop_2_state(this, ROOT_PORT);
 				}
 			}
@@ -455,37 +471,55 @@ Bool STP_roletrns_check_conditions(STATE_MACH_T *this)
 			return STP_hop_2_state(this, DESIGNATED_PORT);
 
 		case DESIGNATED_PORT:
-			if (port->selected && !port->updtInfo) {
-				if (!port->forward && !port->agreed && !port->proposing && !port->operEdge) {
+			if (ROLE_READY(port)) {
+				if (!PORT_ANY_FLAGS(port, PORT_FLAG(forward) |
+							  PORT_FLAG(agreed) |
+							  PORT_FLAG(proposing) |
+							  PORT_FLAG(operEdge))) {
 					return STP_hop_2_state(this, DESIGNATED_PROPOSE);
 				}
 
-				if ((!port->learning && !port->forwarding && !port->synced) ||
-				    (port->agreed && !port->synced) ||
-				    (port->operEdge && !port->synced) ||
-				    (port->sync && port->synced)) {
+				if (!PORT_ANY_FLAGS(port, PORT_FLAG(learning) |
+							  PORT_FLAG(forwarding) |
+							  PORT_FLAG(synced)) ||
+				    (PORT_GET(port, agreed) &&
+				     !PORT_GET(port, synced)) ||
+				    (PORT_GET(port, operEdge) &&
+				     !PORT_GET(port, synced)) ||
+				    PORT_ALL_FLAGS(port, PORT_FLAG(sync) |
+							 PORT_FLAG(synced))) {
 					return STP_hop_2_state(this, DESIGNATED_SYNCED);
 				}
 
-				if (!port->rrWhile && port->reRoot) {
+				if (!PORT_TIMER(port, rrWhile) && PORT_GET(port, reRoot)) {
 					return STP_hop_2_state(this, DESIGNATED_RETIRED);
 				}
 
-				if ((!port->fdWhile || port->agreed || port->operEdge) &&
-				    (!port->rrWhile || !port->reRoot) &&
-				    !port->sync &&
-				    (port->learn && !port->forward)) {
+				if ((!PORT_TIMER(port, fdWhile) ||
+				     PORT_ANY_FLAGS(port, PORT_FLAG(agreed) |
+							  PORT_FLAG(operEdge))) &&
+				    (!PORT_TIMER(port, rrWhile) || !PORT_GET(port, reRoot)) &&
+				    PORT_FLAGS_ARE(port, PORT_FLAG(sync) |
+							 PORT_FLAG(learn) |
+							 PORT_FLAG(forward),
+						   PORT_FLAG(learn))) {
 					return STP_hop_2_state(this, DESIGNATED_FORWARD);
 				}
-				if ((!port->fdWhile || port->agreed || port->operEdge) &&
-				    (!port->rrWhile || !port->reRoot) &&
-				    !port->sync && !port->learn) {
+				if ((!PORT_TIMER(port, fdWhile) ||
+				     PORT_ANY_FLAGS(port, PORT_FLAG(agreed) |
+							  PORT_FLAG(operEdge))) &&
+				    (!PORT_TIMER(port, rrWhile) || !PORT_GET(port, reRoot)) &&
+				    !PORT_ANY_FLAGS(port, PORT_FLAG(sync) |
+							  PORT_FLAG(learn))) {
 					return STP_hop_2_state(this, DESIGNATED_LEARN);
 				}
-				if (((port->sync && !port->synced) || 
-				     (port->reRoot && port->rrWhile) ||
-				     port->disputed) &&
-				     !port->operEdge && (port->learn || port->forward)) {
+				if (((PORT_GET(port, sync) &&
+				      !PORT_GET(port, synced)) ||
+				     (PORT_GET(port, reRoot) && PORT_TIMER(port, rrWhile)) ||
+				     PORT_GET(port, disputed)) &&
+				     !PORT_GET(port, operEdge) &&
+				     PORT_ANY_FLAGS(port, PORT_FLAG(learn) |
+							  PORT_FLAG(forward))) {
 					return STP_hop_2_state(this, DESIGNATED_DISCARD);
 				}
 			}
@@ -497,27 +531,30 @@ Bool STP_roletrns_check_conditions(STATE_MACH_T *this)
 		case BACKUP_PORT:
 			return STP_hop_2_state (this, ALTERNATE_PORT);
 		case BLOCK_PORT:
-			if (!port->learning && !port->forwarding &&
-			    port->selected && !port->updtInfo) {
+			if (ROLE_READY_BLOCKED(port)) {
 				return STP_hop_2_state (this, ALTERNATE_PORT);
 			}
 			break;
 		case ALTERNATE_PORT:
-			if (port->selected && !port->updtInfo) {
+			if (ROLE_READY(port)) {
 				allSynced = compute_allsynced(port);
-				if ((allSynced && !port->agree) ||
-				    (port->proposed && port->agree)) {
+				if ((allSynced && !PORT_GET(port, agree)) ||
+				    PORT_ALL_FLAGS(port, PORT_FLAG(proposed) |
+							 PORT_FLAG(agree))) {
 					return STP_hop_2_state(this, ALTERNATE_AGREED);
 				}
-				if (port->proposed && !port->agree) {
+				if (PORT_GET(port, proposed) &&
+				    !PORT_GET(port, agree)) {
 					return STP_hop_2_state(this, ALTERNATE_PROPOSED);
 				}
-				if ((port->rbWhile != 2 * stpm->rootTimes.HelloTime) &&
+				if ((PORT_TIMER(port, rbWhile) != 2 * stpm->rootTimes.HelloTime) &&
 				    (port->role == BackupPort)) {
 					return STP_hop_2_state(this, BACKUP_PORT);
 				}
-				if ((port->fdWhile != stpm->rootTimes.ForwardDelay) ||
-				    port->sync || port->reRoot || !port->synced) {
+				if ((PORT_TIMER(port, fdWhile) != stpm->rootTimes.ForwardDelay) ||
+				    PORT_ANY_FLAGS(port, PORT_FLAG(sync) |
+							 PORT_FLAG(reRoot)) ||
+				    !PORT_GET(port, synced)) {
 					return STP_hop_2_state(this, ALTERNATE_PORT);
 				}
 			}
@@ -31,5 +31,7 @@ Bool STP_roletrns_check_conditions(STATE_MACH_T *s);
 
 char *STP_roletrns_get_state_name(int state);
 
+Bool STP_roletrns_restart_timers(PORT_T *port);
+
 #endif /* _STP_ROLES_TRANSIT_H__ */
 
@@ -23,47 +23,127 @@
 /* Generic (abstract) state machine : 17.15, 17.16 */
  
 #include "base.h"
+#include "arena.h"
 #include "statmch.h"
+#include "stpm.h"
 
-#if STP_DBG
-#  include "stpm.h"
-#endif
+#include "rolesel.h"
+#include "receive.h"
+#include "topoch.h"
+#include "migrate.h"
+#include "p2p.h"
+#include "brdgdet.h"
+#include "pcost.h"
+#include "portinfo.h"
+#include "roletrns.h"
+#include "sttrans.h"
+#include "transmit.h"
 
-STATE_MACH_T *STP_state_mach_create(void (*concreteEnterState)(STATE_MACH_T*),
-				    Bool (*concreteCheckCondition)(STATE_MACH_T*),
-				    char *(*concreteGetStatName)(int),
-				    void *owner, char *name)
+unsigned long STP_guard_evals = 0;
+
+int stp_traced = 0;
+
+#define MACH_NAME(WHAT) #WHAT,
+
+static const char *const mach_names[STP_MACH_NUMBER] = {
+	STP_MACHINES(MACH_NAME)
+};
+
+/* Direct calls of the concrete machines, no function pointers */
+
+#define ENTER_CASE(WHAT)					\
+	case STP_MACH_##WHAT:					\
+		STP_##WHAT##_enter_state(this);			\
+		break;
+
+#define CHECK_CASE(WHAT)					\
+	case STP_MACH_##WHAT:					\
+		return STP_##WHAT##_check_conditions(this);
+
+#define STATE_NAME_CASE(WHAT)					\
+	case STP_MACH_##WHAT:					\
+		return STP_##WHAT##_get_state_name(state);
+
+void STP_enter_state(STATE_MACH_T *this)
 {
-	STATE_MACH_T *this;
+	switch (this->type) {
+		STP_MACHINES(ENTER_CASE)
+		default:
+			break;
+	}
+}
+
+static Bool _stp_check_conditions(STATE_MACH_T *this)
+{
+	switch (this->type) {
+		STP_MACHINES(CHECK_CASE)
+		default:
+			return False;
+	}
+}
 
-	STP_MALLOC(this, STATE_MACH_T, "state machine");
+static char *_stp_get_state_name(STATE_MACH_T *this, int state)
+{
+	switch (this->type) {
+		STP_MACHINES(STATE_NAME_CASE)
+		default:
+			return "???";
+	}
+}
 
+void STP_state_mach_init(STATE_MACH_T *this, STATE_MACH_TYPE_T type,
+			 void *owner)
+{
+	this->type = type;
 	this->State = BEGIN;
-	this->name = (char*)strdup(name);
 	this->changeState = False;
-#if STP_DBG
 	this->debug = False;
 	this->ignoreHop2State = BEGIN;
-#endif
-	this->concreteEnterState = concreteEnterState;
-	this->concreteCheckCondition = concreteCheckCondition;
-	this->concreteGetStatName = concreteGetStatName;
 	this->owner.owner = owner;
+}
+
+STATE_MACH_T *STP_state_mach_create(STATE_MACH_TYPE_T type, void *owner)
+{
+	STATE_MACH_T *this;
+
+	STP_ARENA_NEW(this, STATE_MACH_T, 0, "state machine");
+	STP_state_mach_init(this, type, owner);
 
 	return this;
 }
 
 void STP_state_mach_delete(STATE_MACH_T *this)
 {
-	free(this->name);
-	STP_FREE(this, "state machine");
+	STP_state_mach_set_debug(this, False);
+	STP_ARENA_DEL(this, STATE_MACH_T, 0);
+}
+
+const char *STP_state_mach_name(STATE_MACH_T *this)
+{
+	return mach_names[this->type];
+}
+
+/* The only place, where debug is changed: it keeps stp_traced */
+void STP_state_mach_set_debug(STATE_MACH_T *this, Bool enable)
+{
+	char debug = 0;
+
+	if (enable) {
+		debug = (STP_MACH_rolesel == this->type) ? 2 : 1;
+	}
+	if (debug == this->debug) {
+		return;
+	}
+	stp_traced += debug ? 1 : -1;
+	this->debug = debug;
 }
 
 Bool STP_check_condition(STATE_MACH_T *this)
 {
 	Bool bret;
 
-	bret = (*(this->concreteCheckCondition))(this);
+	STP_guard_evals++;
+	bret = _stp_check_conditions(this);
 	if (bret) {
 		this->changeState = True;
 	}
@@ -79,7 +159,7 @@ Bool STP_change_state(STATE_MACH_T *this)
 		if (!this->changeState) {
 			return number_of_loops;
 		}
-		(*(this->concreteEnterState))(this);
+		STP_enter_state(this);
 		this->changeState = False;
 		STP_check_condition(this);
 	}
@@ -89,33 +169,33 @@ Bool STP_change_state(STATE_MACH_T *this)
 
 Bool STP_hop_2_state(STATE_MACH_T *this, unsigned int new_state)
 {
-#ifdef STP_DBG
-	switch (this->debug) {
-		case 0:
-			break;
-		case 1:
-			if (new_state == this->State || new_state == this->ignoreHop2State) {
+	if (STP_TRACE_ON) {
+		switch (this->debug) {
+			case 0:
 				break;
-			}
-			stp_trace("%-8s(%s-%s): %s=>%s",
-				  this->name,
-				  *this->owner.port->owner->name ? this->owner.port->owner->name : "Glbl",
-				  this->owner.port->port_name,
-				  (*(this->concreteGetStatName))(this->State),
-				  (*(this->concreteGetStatName))(new_state));
-			break;
-		case 2:
-			if (new_state == this->State) {
+			case 1:
+				if (new_state == this->State || new_state == this->ignoreHop2State) {
+					break;
+				}
+				stp_trace("%-8s(%s-%s): %s=>%s",
+					  STP_state_mach_name(this),
+					  *this->owner.port->owner->name ? this->owner.port->owner->name : "Glbl",
+					  this->owner.port->port_name,
+					  _stp_get_state_name(this, this->State),
+					  _stp_get_state_name(this, new_state));
 				break;
-			}
-			stp_trace("%s(%s): %s=>%s",
-				  this->name,
-				  *this->owner.stpm->name ? this->owner.stpm->name : "Glbl",
-				  (*(this->concreteGetStatName))(this->State),
-				  (*(this->concreteGetStatName))(new_state));
-			break;
+			case 2:
+				if (new_state == this->State) {
+					break;
+				}
+				stp_trace("%s(%s): %s=>%s",
+					  STP_state_mach_name(this),
+					  *this->owner.stpm->name ? this->owner.stpm->name : "Glbl",
+					  _stp_get_state_name(this, this->State),
+					  _stp_get_state_name(this, new_state));
+				break;
+		}
 	}
-#endif
 
 	this->State = new_state;
 	this->changeState = True;
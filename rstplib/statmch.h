@@ -28,21 +28,41 @@
 
 #define BEGIN  9999 /* distinct from any valid state */
 
+/* All the state machines. Each WHAT has STP_WHAT_enter_state,
+ * STP_WHAT_check_conditions and STP_WHAT_get_state_name, that
+ * statmch.c calls directly by the machine type. The transitions of
+ * migrate are a table, that stmtab.h generates from its description,
+ * the others are hand-written switches (see TODO). */
+#define STP_MACHINES(M)	\
+	M(rolesel)	\
+	M(receive)	\
+	M(topoch)	\
+	M(migrate)	\
+	M(p2p)		\
+	M(brdgdet)	\
+	M(pcost)	\
+	M(info)		\
+	M(roletrns)	\
+	M(sttrans)	\
+	M(transmit)
+
+#define STP_MACH_TYPE(WHAT) STP_MACH_##WHAT,
+
+typedef enum {
+	STP_MACHINES(STP_MACH_TYPE)
+	STP_MACH_NUMBER
+} STATE_MACH_TYPE_T;
+
 typedef struct state_mach_t {
 	struct state_mach_t* next;
 
-	char *name; /* for debugging */
-#ifdef STP_DBG
+	STATE_MACH_TYPE_T type;
 	char debug; /* 0- no dbg, 1 - port, 2 - stpm */
 	unsigned int ignoreHop2State;
-#endif
 
 	Bool changeState;
 	unsigned int State;
 
-	void (*concreteEnterState)(struct state_mach_t *);
-	Bool (*concreteCheckCondition)(struct state_mach_t *);
-	char *(*concreteGetStatName)(int);
 	union {
 		struct stpm_t *stpm;
 		struct port_t *port;
@@ -55,23 +75,48 @@ typedef struct state_mach_t {
 {									\
 	STATE_MACH_T *abstr;						\
 									\
-	abstr = STP_state_mach_create(STP_##WHAT##_enter_state,		\
-				      STP_##WHAT##_check_conditions,	\
-				      STP_##WHAT##_get_state_name,	\
-				      this,				\
-				      #WHAT);				\
+	abstr = STP_state_mach_create(STP_MACH_##WHAT, this);		\
+	abstr->next = this->machines;					\
+	this->machines = abstr;						\
+	this->WHAT = abstr;						\
+}
+
+/* Same for a machine, that is embedded in its owner */
+#define STP_STATE_MACH_IN_ARRAY(WHAT, SLOT)				\
+{									\
+	STATE_MACH_T *abstr = (SLOT);					\
+									\
+	STP_state_mach_init(abstr, STP_MACH_##WHAT, this);		\
 	abstr->next = this->machines;					\
 	this->machines = abstr;						\
 	this->WHAT = abstr;						\
 }
 
-STATE_MACH_T *STP_state_mach_create(void (*concreteEnterState)(STATE_MACH_T*),
-				    Bool (*concreteCheckCondition)(STATE_MACH_T*),
-				    char *(*concreteGetStatName)(int),
-				    void *owner, char *name);
+/* Number of guard (check_conditions) evaluations so far */
+extern unsigned long STP_guard_evals;
+
+/* Number of the traced machines of the instance. While it is 0 a
+ * tracepoint costs one predicted not taken branch on it, the debug
+ * flag of the machine is not even loaded. */
+extern int stp_traced;
+
+#define STP_TRACE_ON		__builtin_expect(stp_traced != 0, 0)
+
+#define STP_TRACING(MACH)	(STP_TRACE_ON && (MACH)->debug)
+
+void STP_state_mach_init(STATE_MACH_T *this, STATE_MACH_TYPE_T type,
+			 void *owner);
+
+STATE_MACH_T *STP_state_mach_create(STATE_MACH_TYPE_T type, void *owner);
 
 void STP_state_mach_delete(STATE_MACH_T *this);
 
+const char *STP_state_mach_name(STATE_MACH_T *this);
+
+void STP_state_mach_set_debug(STATE_MACH_T *this, Bool enable);
+
+void STP_enter_state(STATE_MACH_T *this);
+
 Bool STP_check_condition(STATE_MACH_T *this);
 
 Bool STP_change_state(STATE_MACH_T *this);
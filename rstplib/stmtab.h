@@ -0,0 +1,131 @@
+/************************************************************************
+ * RSTP library - Rapid Spanning Tree (802.1D-2004)
+ *
+ * This file is part of RSTP library.
+ *
+ * RSTP library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; version 2.1
+ *
+ * RSTP library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with RSTP library; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **********************************************************************/
+
+#ifndef _STP_STMTAB_H__
+#define _STP_STMTAB_H__
+
+/* Table driven state machines: the machine file describes the machine,
+ * this file generates from it the states, a dense transition table and
+ * the functions, that statmch.c calls (see migrate.c).
+ *
+ * Before the include the machine file defines
+ *   MACHINE(STATE, GO)	STATE(name, action, transitions) for each state,
+ *			the transitions as GO(guard, next), in the order
+ *			they are checked. BEGIN goes to the first state and
+ *			enters it with the action of the first state.
+ *   GET_STATE_NAME, ENTER_STATE, CHECK_CONDITIONS
+ *			the names of the generated functions
+ * and the functions named in it:
+ *   static void action(STATE_MACH_T *this)
+ *   static inline Bool guard(STATE_MACH_T *this)
+ * A guard is named in one transition only, it is its id in the table.
+ *
+ * The row of a state holds its transitions as (guard id, next state),
+ * up to the longest row; guard id 0 ends a shorter one. The guards and
+ * the actions are called directly, by a switch on the id. */
+
+#define STMTAB_NONE(...)
+
+/* the states */
+#define STMTAB_STATE_ENUM(name, action, trans)	name,
+typedef enum {
+	MACHINE(STMTAB_STATE_ENUM, STMTAB_NONE)
+} THE_STATE_T;
+
+#define STMTAB_STATE_NAME(name, action, trans)	#name,
+char *GET_STATE_NAME(int state)
+{
+	static char *state_names[] = {
+		MACHINE(STMTAB_STATE_NAME, STMTAB_NONE)
+	};
+
+	if (BEGIN == state) {
+		return "Begin";
+	}
+	return state_names[state];
+}
+
+/* the guard ids */
+#define STMTAB_TRANS(name, action, trans)	trans
+#define STMTAB_GUARD_ENUM(guard, next)		STMTAB_G_##guard,
+enum {
+	STMTAB_G_NONE,
+	MACHINE(STMTAB_TRANS, STMTAB_GUARD_ENUM)
+};
+
+/* sizeof the union is the longest row plus the end */
+#define STMTAB_ROW_LEN(name, action, trans)	char name[1 trans];
+#define STMTAB_COUNT(guard, next)		+ 1
+typedef union {
+	MACHINE(STMTAB_ROW_LEN, STMTAB_COUNT)
+} STMTAB_ROW_T;
+
+typedef struct {
+	unsigned char guard;
+	unsigned char next;
+} STMTAB_GO_T;
+
+#define STMTAB_ROW(name, action, trans)		{ trans },
+#define STMTAB_GO(guard, next)			{ STMTAB_G_##guard, next },
+static const STMTAB_GO_T stmtab[][sizeof(STMTAB_ROW_T)] = {
+	MACHINE(STMTAB_ROW, STMTAB_GO)
+};
+
+#define STMTAB_GUARD_CASE(guard, next)				\
+	case STMTAB_G_##guard:					\
+		return guard(this);
+
+static inline Bool stmtab_guard(unsigned char id, STATE_MACH_T *this)
+{
+	switch (id) {
+		MACHINE(STMTAB_TRANS, STMTAB_GUARD_CASE)
+	}
+	return False;
+}
+
+#define STMTAB_ENTER_CASE(name, action, trans)			\
+	case name:						\
+		action(this);					\
+		break;
+
+void ENTER_STATE(STATE_MACH_T *this)
+{
+	switch (BEGIN == this->State ? 0 : this->State) {
+		MACHINE(STMTAB_ENTER_CASE, STMTAB_NONE)
+	}
+}
+
+Bool CHECK_CONDITIONS(STATE_MACH_T *this)
+{
+	register const STMTAB_GO_T *go;
+
+	if (BEGIN == this->State) {
+		return STP_hop_2_state(this, 0);
+	}
+
+	for (go = stmtab[this->State]; go->guard; go++) {
+		if (stmtab_guard(go->guard, this)) {
+			return STP_hop_2_state(this, go->next);
+		}
+	}
+	return False;
+}
+
+#endif /* _STP_STMTAB_H__ */
@@ -183,7 +183,7 @@ static int cli_br_get_cfg(int argc, char **argv)
 	if (uid_state.root_port) {
 		printf("Root Port:       %04lx (",
 		       (unsigned long) uid_state.root_port);
-		CLI_out_port_id(uid_state.root_port & 0xfff, False);
+		CLI_out_port_id(UID_PORT_ID_NUMBER(uid_state.root_port), False);
 		printf("), Root Cost:     %-lu\n",
 		       (unsigned long)uid_state.root_path_cost);
 	} else {
@@ -256,7 +256,7 @@ static void show_rstp_port(BITMAP_T *ports_bitmap, int detail)
 			       uid_state.vlan_name);
 #endif
 			printf("Priority:          %-d\n",
-			       (int)(uid_port.port_id >> 8));
+			       (int)UID_PORT_ID_PRIO(uid_port.port_id));
 			printf("State:             %-16s",
 			       stp_state2str(uid_port.state, 1));
 			printf("       Uptime: %-9lu\n", uid_port.uptime);
@@ -534,7 +534,7 @@ static void set_rstp_port_cfg_value(int port_index, unsigned long value,
 				    unsigned long val_mask)
 {
 	UID_STP_PORT_CFG_T uid_cfg;
-	int rc, detail;
+	int rc, detail, port_no;
 	char *val_name;
 
 	if (port_index > 0) {
@@ -587,7 +587,15 @@ static void set_rstp_port_cfg_value(int port_index, unsigned long value,
 			return;
 	}
 
+#ifdef ORIG
 	rc = STP_IN_set_port_cfg(0, &uid_cfg);
+#else
+	/* one port at a time, the first error stops */
+	for (rc = 0, port_no = 1; !rc && port_no <= NUMBER_OF_PORTS; port_no++) {
+		if (BitmapGetBit(&uid_cfg.port_bmp, port_no - 1))
+			rc = STP_IN_set_port_cfg(0, port_no, &uid_cfg);
+	}
+#endif
 	if (0 != rc) {
 		printf("can't change rstp port[s] %s: %s\n", val_name,
 		       STP_IN_get_error_explanation(rc));
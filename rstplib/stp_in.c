@@ -23,7 +23,9 @@
 /* This file contains API from an operation system to the RSTP library */
 
 #include "base.h"
+#include "arena.h"
 #include "stpm.h"
+#include "portinfo.h" /* for STP_info_rx_repeated */
 #include "stp_in.h"
 #include "stp_to.h"
 
@@ -37,7 +39,7 @@ int nev = 0;
 void *stp_in_stpm_create(int vlan_id, char *name, BITMAP_T *port_bmp,
 			 int *err_code)
 {
-	int port_index;
+	int bit, port_index;
 	register STPM_T *this;
 
 	/* stp_trace ("stp_in_stpm_create(%s)", name); */
@@ -53,16 +55,18 @@ void *stp_in_stpm_create(int vlan_id, char *name, BITMAP_T *port_bmp,
 		return NULL;
 	}
 
-	for (port_index = 1; port_index <= max_port; port_index++) {
-		if (BitmapGetBit(port_bmp, (port_index - 1))) {
-			if (!STP_port_create (this, port_index)) {
-				/* can't add port :( */
-				stp_trace ("can't create port %d",
-				                (int) port_index);
-				STP_stpm_delete (this);
-				*err_code =STP_Cannot_Create_Instance_For_Port;
-				return NULL;
-			}
+	BitmapForEachBit(port_bmp, bit) {
+		port_index = bit + 1;
+		if (port_index > max_port) {
+			break;
+		}
+		if (!STP_port_create (this, port_index)) {
+			/* can't add port :( */
+			stp_trace ("can't create port %d",
+			                (int) port_index);
+			STP_stpm_delete (this);
+			*err_code =STP_Cannot_Create_Instance_For_Port;
+			return NULL;
 		}
 	}
 
@@ -152,6 +156,15 @@ static PORT_T *_stpapi_port_find (STPM_T *this, int port_index)
 	return NULL;
 }
 
+#if defined(ORIG) || defined(STP_DBG)
+/* is the port in the set of ports of a management call */
+static Bool _stpapi_port_in_set (BITMAP_T *ports, int port_index)
+{
+	return port_index <= max_port && port_index <= BITMAP_BITS &&
+	       BitmapGetBit(ports, port_index - 1);
+}
+#endif
+
 static void _conv_br_id_2_uid (IN BRIDGE_ID *f, OUT UID_BRIDGE_ID_T *t)
 {
 	memcpy (t, f, sizeof (UID_BRIDGE_ID_T));
@@ -212,6 +225,16 @@ static int _check_stpm_config (IN UID_STP_CFG_T *uid_cfg)
 		return STP_Hello_Time_And_Max_Age_Are_Inconsistent;
 	}
 
+	if (uid_cfg->flush_window < MIN_FLUSH_WINDOW) {
+		stp_trace ("%d flush_window small", (int) uid_cfg->flush_window);
+		return STP_Small_Flush_Window;
+	}
+
+	if (uid_cfg->flush_window > MAX_FLUSH_WINDOW) {
+		stp_trace ("%d flush_window large", (int) uid_cfg->flush_window);
+		return STP_Large_Flush_Window;
+	}
+
 	return 0;
 }
 
@@ -223,26 +246,29 @@ static void _stp_in_enable_port_on_stpm(STPM_T *stpm, int port_index,
 	port = _stpapi_port_find (stpm, port_index);
 	if (!port)
 		return;
-	if (port->portEnabled == enable) {/* nothing to do :) */
+	if (PORT_GET(port, portEnabled) == enable) {/* nothing to do :) */
 		return;
 	}
 
-	port->uptime = 0;
+	port->up_since = port->owner->seconds;
 	if (enable) { /* clear port statistics */
 		port->rx_cfg_bpdu_cnt =port->rx_rstp_bpdu_cnt
-		                =port->rx_tcn_bpdu_cnt = 0;
+		                =port->rx_tcn_bpdu_cnt
+		                =port->rx_fast_bpdu_cnt = 0;
 	}
 
-	port->adminEnable = enable;
+	PORT_PUT(port, adminEnable, enable);
 	STP_port_init (port, stpm, False);
 
-	port->reselect = True;
-	port->selected = False;
+	STP_rolesel_reselect(port);
+	STP_stpm_mark_port (port);
 }
 
 void STP_IN_init(int max_port_index)
 {
-	max_port = max_port_index;
+	/* not more than the 12 bits of the Port Identifier */
+	max_port = max_port_index < UID_PORT_ID_MAX_NUMBER ?
+		   max_port_index : UID_PORT_ID_MAX_NUMBER;
 	RSTP_INIT_CRITICAL_PATH_PROTECTIO;
 }
 
@@ -292,6 +318,16 @@ int STP_IN_stpm_get_cfg (IN int vlan_id, OUT UID_STP_CFG_T *uid_cfg)
 
 	uid_cfg->hold_time = TxHoldCount;
 
+	if (this->flush_window != DEF_FLUSH_WINDOW) {
+		uid_cfg->field_mask |= BR_CFG_FLUSH_WINDOW;
+	}
+	uid_cfg->flush_window = this->flush_window;
+
+	if (this->rx_fast != DEF_RX_FAST) {
+		uid_cfg->field_mask |= BR_CFG_RX_FAST;
+	}
+	uid_cfg->rx_fast = this->rx_fast;
+
 	RSTP_CRITICAL_PATH_END;
 	return 0;
 }
@@ -317,7 +353,7 @@ int STP_IN_port_get_cfg(int vlan_id, int port_index, UID_STP_PORT_CFG_T *uid_cfg
 
 	uid_cfg->field_mask = 0;
 
-	uid_cfg->port_priority = port->portId >> 8;
+	uid_cfg->port_priority = UID_PORT_ID_PRIO(port->portId);
 	if (uid_cfg->port_priority != DEF_PORT_PRIO)
 		uid_cfg->field_mask |= PT_CFG_PRIO;
 
@@ -329,7 +365,7 @@ int STP_IN_port_get_cfg(int vlan_id, int port_index, UID_STP_PORT_CFG_T *uid_cfg
 	if (uid_cfg->admin_point2point != DEF_P2P)
 		uid_cfg->field_mask |= PT_CFG_P2P;
 
-	uid_cfg->admin_edge = port->AdminEdgePort;
+	uid_cfg->admin_edge = PORT_GET(port, AdminEdgePort);
 	if (uid_cfg->admin_edge != DEF_ADMIN_EDGE)
 		uid_cfg->field_mask |= PT_CFG_EDGE;
 
@@ -341,6 +377,7 @@ int STP_IN_port_get_state (IN int vlan_id, INOUT UID_STP_PORT_STATE_T *entry)
 {
 	register STPM_T *this;
 	register PORT_T *port;
+	BRIDGE_ID br_id;
 
 	RSTP_CRITICAL_PATH_START;
 	this = stpapi_stpm_find (vlan_id);
@@ -359,20 +396,22 @@ int STP_IN_port_get_state (IN int vlan_id, INOUT UID_STP_PORT_STATE_T *entry)
 	entry->port_id = port->portId;
 	if (DisabledPort == port->role) {
 		entry->state = UID_PORT_DISABLED;
-	} else if (!port->forwarding && !port->learning) {
+	} else if (!PORT_GET(port, forwarding) && !PORT_GET(port, learning)) {
 		entry->state = UID_PORT_DISCARDING;
-	} else if (!port->forwarding && port->learning) {
+	} else if (!PORT_GET(port, forwarding) && PORT_GET(port, learning)) {
 		entry->state = UID_PORT_LEARNING;
 	} else {
 		entry->state = UID_PORT_FORWARDING;
 	}
 
-	entry->uptime = port->uptime;
+	entry->uptime = this->seconds - port->up_since;
 	entry->path_cost = port->operPCost;
-	_conv_br_id_2_uid (&port->portPriority.root_bridge, &entry->designated_root);
-	entry->designated_cost = port->portPriority.root_path_cost;
-	_conv_br_id_2_uid (&port->portPriority.design_bridge, &entry->designated_bridge);
-	entry->designated_port = port->portPriority.design_port;
+	STP_VECT_get_root_bridge (&port->portPriority, &br_id);
+	_conv_br_id_2_uid (&br_id, &entry->designated_root);
+	entry->designated_cost = STP_VECT_ROOT_PATH_COST (&port->portPriority);
+	STP_VECT_get_design_bridge (&port->portPriority, &br_id);
+	_conv_br_id_2_uid (&br_id, &entry->designated_bridge);
+	entry->designated_port = STP_VECT_DESIGN_PORT (&port->portPriority);
 
 	switch (port->role) {
 		case DisabledPort: entry->role = ' '; break;
@@ -393,31 +432,34 @@ int STP_IN_port_get_state (IN int vlan_id, INOUT UID_STP_PORT_STATE_T *entry)
 
 	if (DisabledPort == port->role) {
 		entry->oper_point2point = (P2P_FORCE_FALSE == port->adminPointToPointMac) ? 0 : 1;
-		entry->oper_edge = port->AdminEdgePort;
+		entry->oper_edge = PORT_GET(port, AdminEdgePort);
 		entry->oper_stp_neigb = 0;
 	} else {
-		entry->oper_point2point = port->operPointToPointMac ? 1 : 0;
-		entry->oper_edge = port->operEdge ? 1 : 0;
-		entry->oper_stp_neigb = port->sendRSTP ? 0 : 1;
+		entry->oper_point2point =
+			PORT_GET(port, operPointToPointMac) ? 1 : 0;
+		entry->oper_edge = PORT_GET(port, operEdge) ? 1 : 0;
+		entry->oper_stp_neigb = PORT_GET(port, sendRSTP) ? 0 : 1;
 	}
 	entry->oper_port_path_cost = port->operPCost;
 
 	entry->rx_cfg_bpdu_cnt = port->rx_cfg_bpdu_cnt;
 	entry->rx_rstp_bpdu_cnt = port->rx_rstp_bpdu_cnt;
 	entry->rx_tcn_bpdu_cnt = port->rx_tcn_bpdu_cnt;
-
-	entry->edgeDelayWhile = port->edgeDelayWhile;	/* 17.17.1 */
-	entry->fdWhile = port->fdWhile;			/* 17.17.2 */
-	entry->helloWhen = port->helloWhen;		/* 17.17.3 */
-	entry->mdelayWhile = port->mdelayWhile;		/* 17.17.4 */
-	entry->rbWhile = port->rbWhile;			/* 17.17.5 */
-	entry->rcvdInfoWhile = port->rcvdInfoWhile;	/* 17.17.6 */
-	entry->rrWhile = port->rrWhile;			/* 17.17.7 */
-	entry->tcWhile = port->tcWhile;			/* 17.17.8 */
-	entry->txCount = port->txCount;			/* 17.19.44 */
-
-	entry->rcvdInfoWhile = port->rcvdInfoWhile;
-	entry->top_change_ack = port->tcAck;
+	entry->rx_fast_bpdu_cnt = port->rx_fast_bpdu_cnt;
+
+	entry->edgeDelayWhile = PORT_TIMER(port, edgeDelayWhile);	/* 17.17.1 */
+	entry->fdWhile = PORT_TIMER(port, fdWhile);		/* 17.17.2 */
+	entry->helloWhen = PORT_TIMER(port, helloWhen);		/* 17.17.3 */
+	entry->mdelayWhile = PORT_TIMER(port, mdelayWhile);	/* 17.17.4 */
+	entry->rbWhile = PORT_TIMER(port, rbWhile);		/* 17.17.5 */
+	entry->rcvdInfoWhile = PORT_TIMER(port, rcvdInfoWhile);	/* 17.17.6 */
+	entry->rrWhile = PORT_TIMER(port, rrWhile);		/* 17.17.7 */
+	entry->tcWhile = PORT_TIMER(port, tcWhile);		/* 17.17.8 */
+	entry->txCount = PORT_TIMER(port, txCount);		/* 17.19.44 */
+
+	entry->rcvdInfoWhile = PORT_TIMER(port, rcvdInfoWhile);
+	entry->top_change_ack = PORT_GET(port, tcAck);
+	entry->mem_bytes = STP_port_mem_bytes (port);
 
 	RSTP_CRITICAL_PATH_END;
 	return 0;
@@ -426,6 +468,7 @@ int STP_IN_port_get_state (IN int vlan_id, INOUT UID_STP_PORT_STATE_T *entry)
 int STP_IN_stpm_get_state (IN int vlan_id, OUT UID_STP_STATE_T *entry)
 {
 	register STPM_T *this;
+	BRIDGE_ID br_id;
 
 	RSTP_CRITICAL_PATH_START;
 	this = stpapi_stpm_find (vlan_id);
@@ -437,8 +480,9 @@ int STP_IN_stpm_get_state (IN int vlan_id, OUT UID_STP_STATE_T *entry)
 
 	strncpy (entry->vlan_name, this->name, NAME_LEN);
 	entry->vlan_id = this->vlan_id;
-	_conv_br_id_2_uid (&this->rootPriority.root_bridge, &entry->designated_root);
-	entry->root_path_cost = this->rootPriority.root_path_cost;
+	STP_VECT_get_root_bridge (&this->rootPriority, &br_id);
+	_conv_br_id_2_uid (&br_id, &entry->designated_root);
+	entry->root_path_cost = STP_VECT_ROOT_PATH_COST (&this->rootPriority);
 	entry->root_port = this->rootPortId;
 	entry->max_age = this->rootTimes.MaxAge;
 	entry->forward_delay = this->rootTimes.ForwardDelay;
@@ -452,6 +496,16 @@ int STP_IN_stpm_get_state (IN int vlan_id, OUT UID_STP_STATE_T *entry)
 	entry->Topology_Change_Count = this->Topology_Change_Count;
 	entry->Topology_Change = this->Topology_Change;
 
+	entry->guard_evals = this->guard_evals;
+	entry->last_guard_evals = this->last_guard_evals;
+	entry->mem_bytes = STP_stpm_mem_bytes (this);
+
+	entry->flush_requests = this->flush_requests;
+	entry->flushed_ports = this->flushed_ports;
+	entry->flush_calls = this->flush_calls;
+
+	entry->rx_fast_bpdus = this->rx_fast_bpdus;
+
 	RSTP_CRITICAL_PATH_END;
 	return 0;
 }
@@ -480,15 +534,23 @@ int STP_IN_stpm_get_name_by_vlan_id(int vlan_id, char *name, size_t buffsize)
 int STP_IN_enable_port(int port_index, Bool enable)
 {
 	register STPM_T* stpm;
+	register PORT_T* port;
 
 	RSTP_CRITICAL_PATH_START;
 	tev = enable ? RSTP_PORT_EN_T : RSTP_PORT_DIS_T;
 	INCR100(nev);
 	if (!enable) {
-#ifdef STP_DBG
-		stp_trace("%s (p%02d, all, %s, '%s')",
-				"clearFDB", (int) port_index, "this port", "disable port");
-#endif
+		/* traced by the Topology Change machine, it owns the flushes */
+		for (stpm = STP_stpm_get_the_list (); STP_TRACE_ON && stpm;
+		     stpm = stpm->next) {
+			port = _stpapi_port_find (stpm, port_index);
+			if (port && STP_TRACING(port->topoch)) {
+				stp_trace("%s (p%02d, all, %s, '%s')",
+					  "clearFDB", (int) port_index,
+					  "this port", "disable port");
+				break;
+			}
+		}
 		STP_OUT_flush_lt (port_index, 0, LT_FLASH_ONLY_THE_PORT,
 		                "disable port");
 	}
@@ -522,14 +584,12 @@ int STP_IN_changed_port_speed(int port_index, long speed)
 		if (!port)
 			continue;
 		port->operSpeed = speed;
-#ifdef STP_DBG
-		if (port->pcost->debug) {
+		if (STP_TRACING(port->pcost)) {
 			stp_trace ("changed operSpeed=%lu", port->operSpeed);
 		}
-#endif
 
-		port->reselect = True;
-		port->selected = False;
+		STP_rolesel_reselect(port);
+		STP_stpm_mark_port (port);
 	}
 	RSTP_CRITICAL_PATH_END;
 	return 0;
@@ -550,14 +610,44 @@ int STP_IN_changed_port_duplex(int port_index) {
 		port = _stpapi_port_find (stpm, port_index);
 		if (!port)
 			continue;
-#ifdef STP_DBG
-		if (port->p2p->debug) {
+		if (STP_TRACING(port->p2p)) {
 			stp_trace ("STP_IN_changed_port_duplex(%s)", port->port_name);
 		}
-#endif
-		port->p2p_recompute = True;
-		port->reselect = True;
-		port->selected = False;
+		PORT_SET(port, p2p_recompute);
+		STP_rolesel_reselect(port);
+		STP_stpm_mark_port (port);
+	}
+	RSTP_CRITICAL_PATH_END;
+	return 0;
+}
+
+/* call it, when port MAC address has been changed  */
+int STP_IN_changed_port_mac(int port_index) {
+	register STPM_T *stpm;
+	register PORT_T *port;
+	unsigned char old[6];
+
+	RSTP_CRITICAL_PATH_START;
+	for (stpm = STP_stpm_get_the_list (); stpm; stpm = stpm->next) {
+		port = _stpapi_port_find (stpm, port_index);
+		if (!port)
+			continue;
+
+		memcpy(old, port->mac, sizeof(old));
+		STP_OUT_get_port_mac (port_index, port->mac);
+		if (!memcmp(old, port->mac, sizeof(old)))
+			continue;
+
+		if (!STP_stpm_port_mac_changed(stpm, old, port->mac))
+			continue;
+		if (STP_TRACING(stpm->rolesel)) {
+			stp_trace ("%s: bridge address changed by port %s",
+				   stpm->name, port->port_name);
+		}
+		if (STP_ENABLED == stpm->admin_state) {
+			STP_stpm_update_after_bridge_management (stpm);
+			STP_stpm_update (stpm);
+		}
 	}
 	RSTP_CRITICAL_PATH_END;
 	return 0;
@@ -652,14 +742,20 @@ int STP_IN_rx_bpdu(int vlan_id, int port_index, BPDU_T *bpdu, size_t len)
 	}
 #endif
 
-	if (!port->portEnabled) {/* port link change indication will come later :( */
+	if (!PORT_GET(port, portEnabled)) {/* port link change indication will come later :( */
 		_stp_in_enable_port_on_stpm (this, port->port_index, True);
 	}
 
-	port->operEdge = False;
-	port->wasInitBpdu = True;
+	if (STP_info_rx_repeated (port, bpdu)) {
+		RSTP_CRITICAL_PATH_END;
+		return 0;
+	}
+
+	PORT_CLR(port, operEdge);
+	PORT_SET(port, wasInitBpdu);
 
 	iret = STP_port_rx_bpdu (port, bpdu, len);
+	STP_stpm_mark_port (port);
 	STP_stpm_update (this);
 	RSTP_CRITICAL_PATH_END;
 
@@ -692,12 +788,14 @@ int STP_IN_stpm_set_cfg(IN int vlan_id,
 			IN UID_STP_CFG_T *uid_cfg)
 {
 	int rc = 0, prev_prio, err_code;
-	Bool created_here, enabled_here;
+	Bool created_here, enabled_here, new_info, new_version;
 	register STPM_T *this;
 	UID_STP_CFG_T old;
 
 	/* stp_trace ("STP_IN_stpm_set_cfg"); */
 	if (0 != STP_IN_stpm_get_cfg (vlan_id, &old)) {
+		old.flush_window = DEF_FLUSH_WINDOW;
+		old.rx_fast = DEF_RX_FAST;
 		STP_OUT_get_init_stpm_cfg (vlan_id, &old);
 	}
 
@@ -723,6 +821,14 @@ int STP_IN_stpm_set_cfg(IN int vlan_id,
 		old.force_version = uid_cfg->force_version;
 	}
 
+	if (BR_CFG_FLUSH_WINDOW & uid_cfg->field_mask) {
+		old.flush_window = uid_cfg->flush_window;
+	}
+
+	if (BR_CFG_RX_FAST & uid_cfg->field_mask) {
+		old.rx_fast = uid_cfg->rx_fast;
+	}
+
 	rc = _check_stpm_config (&old);
 	if (0 != rc) {
 		stp_trace ("_check_stpm_config failed %d", (int) rc);
@@ -768,10 +874,21 @@ int STP_IN_stpm_set_cfg(IN int vlan_id,
 		}
 	}
 
+	new_version = this->ForceVersion != old.force_version;
+	new_info = new_version ||
+		   prev_prio != this->BridgeIdentifier.prio ||
+		   this->BridgeTimes.MaxAge != old.max_age ||
+		   this->BridgeTimes.HelloTime != old.hello_time ||
+		   this->BridgeTimes.ForwardDelay != old.forward_delay;
+
 	this->BridgeTimes.MaxAge = old.max_age;
 	this->BridgeTimes.HelloTime = old.hello_time;
 	this->BridgeTimes.ForwardDelay = old.forward_delay;
 	this->ForceVersion = (PROTOCOL_VERSION_T) old.force_version;
+	this->rstpVersion = this->ForceVersion >= NORMAL_RSTP;
+	this->stpVersion = ! this->rstpVersion;
+	this->flush_window = old.flush_window;
+	this->rx_fast = old.rx_fast ? True : False;
 
 	if ((BR_CFG_STATE & uid_cfg->field_mask) &&
 			STP_DISABLED != uid_cfg->stp_enabled &&
@@ -788,8 +905,8 @@ int STP_IN_stpm_set_cfg(IN int vlan_id,
 		enabled_here = True;
 	}
 
-	if (! enabled_here && STP_DISABLED != this->admin_state) {
-		STP_stpm_update_after_bridge_management (this);
+	if (! enabled_here && STP_DISABLED != this->admin_state && new_info) {
+		STP_stpm_update_after_bridge_cfg (this, new_version);
 	}
 	RSTP_CRITICAL_PATH_END;
 	return 0;
@@ -815,24 +932,22 @@ int STP_IN_set_port_cfg (IN int vlan_id, IN int port_index, IN UID_STP_PORT_CFG_
 	}
 
 #ifdef ORIG
-	for (port_no = 1; port_no <= max_port; port_no++) {
-		if (! BitmapGetBit(&uid_cfg->port_bmp, port_no - 1)) continue;
+	/* the ports of the stpm, that are in the set */
+	for (port = this->ports; port; port = port->next) {
+		port_no = port->port_index;
+		if (! _stpapi_port_in_set (&uid_cfg->port_bmp, port_no)) continue;
 #else
 	port_no = port_index;
 	{
-#endif
 		port = _stpapi_port_find (this, port_no);
 		if (! port) {/* port is absent in the stpm :( */
-#ifdef ORIG
-			continue;
-#else
 			return STP_Port_Is_Absent_In_The_Vlan;
-#endif
 		}
+#endif
 
 		if (PT_CFG_MCHECK & uid_cfg->field_mask) {
 			if (this->ForceVersion >= NORMAL_RSTP)
-			port->mcheck = True;
+			PORT_SET(port, mcheck);
 		}
 
 		if (PT_CFG_COST & uid_cfg->field_mask) {
@@ -852,28 +967,28 @@ int STP_IN_set_port_cfg (IN int vlan_id, IN int port_index, IN UID_STP_PORT_CFG_
 			if (uid_cfg->port_priority & ~MASK_PORT_PRIO) {
 				return STP_Port_Priority_Not_A_Multiple_Of_16;
 			}
-			port->portId = (uid_cfg->port_priority << 8) + port_no;
+			port->portId = UID_PORT_ID(uid_cfg->port_priority, port_no);
 		}
 
 		if (PT_CFG_P2P & uid_cfg->field_mask) {
 			port->adminPointToPointMac = uid_cfg->admin_point2point;
-			port->p2p_recompute = True;
+			PORT_SET(port, p2p_recompute);
 		}
 
 		if (PT_CFG_EDGE & uid_cfg->field_mask) {
-			port->AdminEdgePort = uid_cfg->admin_edge;
-			port->operEdge = port->AdminEdgePort;
+			PORT_PUT(port, AdminEdgePort, uid_cfg->admin_edge);
+			PORT_PUT(port, operEdge, PORT_GET(port, AdminEdgePort));
 		}
 
 		if (PT_CFG_NON_STP & uid_cfg->field_mask) {
-#ifdef STP_DBG
-			if (port->roletrns->debug && port->admin_non_stp != uid_cfg->admin_non_stp) {
+			if (STP_TRACING(port->roletrns) &&
+			    PORT_GET(port, admin_non_stp) !=
+			    uid_cfg->admin_non_stp) {
 				stp_trace ("port %s is adminNonStp=%c in STP_IN_set_port_cfg",
 				port->port_name,
 				uid_cfg->admin_non_stp ? 'Y' : 'n');
 			}
-#endif
-			port->admin_non_stp = uid_cfg->admin_non_stp;
+			PORT_PUT(port, admin_non_stp, uid_cfg->admin_non_stp);
 		}
 
 #ifdef STP_DBG
@@ -887,8 +1002,10 @@ int STP_IN_set_port_cfg (IN int vlan_id, IN int port_index, IN UID_STP_PORT_CFG_
 
 #endif
 
-		port->reselect = True;
-		port->selected = False;
+		/* the portId may be in the last BPDU's information */
+		port->rx_last_valid = False;
+		STP_rolesel_reselect(port);
+		STP_stpm_mark_port (port);
 	}
 
 	STP_stpm_update (this);
@@ -917,13 +1034,10 @@ int STP_IN_dbg_set_port_trace(char *mach_name, int enadis,
 		return STP_Vlan_Had_Not_Yet_Been_Created;
 	}
 
-	for (port_no = 1; port_no <= max_port; port_no++) {
-		if (! BitmapGetBit(ports, port_no - 1)) continue;
+	for (port = this->ports; port; port = port->next) {
+		port_no = port->port_index;
+		if (! _stpapi_port_in_set (ports, port_no)) continue;
 
-		port = _stpapi_port_find (this, port_no);
-		if (! port) {/* port is absent in the stpm :( */
-			continue;
-		}
 		STP_port_trace_state_machine (port, mach_name, enadis, vlan_id);
 	}
 
@@ -934,6 +1048,46 @@ int STP_IN_dbg_set_port_trace(char *mach_name, int enadis,
 
 #endif
 
+/*! \function int STP_IN_set_trace(int vlan_id, int port_index, char *mach_name, int enadis)
+ *  \brief Switches the tracepoints of the state machine mach_name ("all" for
+ *   every one) of the port; port_index 0 means the bridge machine and all
+ *   the ports. Takes effect at once, no rebuild with STP_DBG is needed.
+ */
+int STP_IN_set_trace(int vlan_id, int port_index, char *mach_name, int enadis)
+{
+	register STPM_T *this;
+	register PORT_T *port;
+	int found = 0;
+
+	RSTP_CRITICAL_PATH_START;
+	this = stpapi_stpm_find (vlan_id);
+	if (! this) { /* it had not yet been created :( */
+		RSTP_CRITICAL_PATH_END;
+		return STP_Vlan_Had_Not_Yet_Been_Created;
+	}
+
+	if (port_index) {
+		port = _stpapi_port_find (this, port_index);
+		if (! port) {
+			RSTP_CRITICAL_PATH_END;
+			return STP_Port_Is_Absent_In_The_Vlan;
+		}
+		found = STP_port_trace_state_machine (port, mach_name, enadis, vlan_id);
+	} else {
+		if (! strcmp(mach_name, "all") ||
+		    ! strcmp(mach_name, STP_state_mach_name(this->rolesel))) {
+			STP_state_mach_set_debug(this->rolesel, enadis);
+			found++;
+		}
+		for (port = this->ports; port; port = port->next) {
+			found += STP_port_trace_state_machine (port, mach_name, enadis, vlan_id);
+		}
+	}
+
+	RSTP_CRITICAL_PATH_END;
+	return found ? STP_OK : STP_No_Such_State_Machine;
+}
+
 const char *STP_IN_get_error_explanation(int rstp_err_no)
 {
 #define CHOOSE(a) #a
@@ -969,8 +1123,75 @@ int STP_IN_port_create(int vlan_id, int port_index)
 	}
 	STP_port_init(port, this, True);
 
-	STP_compute_bridge_id(this);
-	STP_stpm_update_after_bridge_management (this);
+	if (STP_stpm_port_mac_changed(this, NULL, port->mac)) {
+		/* new bridge Id: every port has to learn it */
+		if (STP_ENABLED == this->admin_state) {
+			STP_stpm_update_after_bridge_management (this);
+		}
+	} else if (STP_ENABLED == this->admin_state) {
+		STP_stpm_port_added (this, port);
+	}
+	return 0;
+}
+
+/* Creates all the ports of the set at once: the bridge Id is computed
+ * and the machines are started once for all of them. Either all the
+ * ports are created or none. */
+int STP_IN_ports_create_bulk(int vlan_id, BITMAP_T *port_bmp)
+{
+	register STPM_T* this;
+	register PORT_T *port;
+	PORT_T *next;
+	BITMAP_T created;
+	Bool new_id = False;
+	int bit, rc = 0;
+
+	this = stpapi_stpm_find (vlan_id);
+
+	if (! this) { /* can't create stpm :( */
+		return STP_Vlan_Had_Not_Yet_Been_Created;
+	}
+
+	BitmapClear(&created);
+	BitmapForEachBit(port_bmp, bit) {
+		if (bit + 1 > max_port || !STP_port_create (this, bit + 1)) {
+			/* can't add port :( */
+			stp_trace ("can't create port %d", bit + 1);
+			rc = STP_Cannot_Create_Instance_For_Port;
+			break;
+		}
+		BitmapSetBit(&created, bit);
+	}
+
+	for (port = this->ports; port; port = next) {
+		next = port->next;
+		if (!BitmapGetBit(&created, port->port_index - 1)) {
+			continue;
+		}
+		if (rc) {
+			STP_port_delete (port);
+			continue;
+		}
+		STP_port_init(port, this, True);
+		if (STP_stpm_port_mac_changed(this, NULL, port->mac)) {
+			new_id = True;
+		}
+	}
+	if (rc || STP_ENABLED != this->admin_state) {
+		return rc;
+	}
+
+	if (new_id) {
+		/* new bridge Id: every port has to learn it */
+		STP_stpm_update_after_bridge_management (this);
+		return 0;
+	}
+	for (port = this->ports; port; port = port->next) {
+		if (BitmapGetBit(&created, port->port_index - 1)) {
+			STP_stpm_port_begin (port);
+		}
+	}
+	this->dirty = True;
 	STP_stpm_update (this);
 	return 0;
 }
@@ -979,6 +1200,7 @@ int STP_IN_port_delete(int vlan_id, int port_index)
 {
 	register STPM_T* this;
 	PORT_T *port;
+	unsigned char mac[6];
 
 	this = stpapi_stpm_find (vlan_id);
 
@@ -991,11 +1213,16 @@ int STP_IN_port_delete(int vlan_id, int port_index)
 		return STP_Port_Is_Absent_In_The_Vlan;
 	}
 
+	memcpy(mac, port->mac, sizeof(mac));
 	STP_port_delete (port);
 
-	STP_compute_bridge_id(this);
-	STP_stpm_update_after_bridge_management (this);
-	STP_stpm_update (this);
+	if (STP_stpm_port_mac_changed(this, mac, NULL)) {
+		if (STP_ENABLED == this->admin_state) {
+			STP_stpm_update_after_bridge_management (this);
+		}
+	} else if (STP_ENABLED == this->admin_state) {
+		STP_stpm_port_removed (this);
+	}
 	return 0;
 }
 
@@ -1007,8 +1234,10 @@ struct stp_instance {
 	int dbg_rstp_deny;
 #endif
 	int max_port; /* Remove this */
+	int traced;
 	int nev;
 	RSTP_EVENT_T tev;
+	STP_ARENA_T arena;
 };
 
 struct stp_instance *STP_IN_instance_create(void) {
@@ -1022,8 +1251,10 @@ struct stp_instance *STP_IN_instance_create(void) {
 	p->dbg_rstp_deny = 0;
 #endif
 	p->max_port = 1024;
+	p->traced = 0;
 	p->tev = RSTP_EVENT_LAST_DUMMY;
 	p->nev = 0;
+	memset(&p->arena, 0, sizeof(p->arena));
 	return p;
 }
 
@@ -1034,8 +1265,10 @@ void STP_IN_instance_begin(struct stp_instance *p)
 	dbg_rstp_deny = p->dbg_rstp_deny;
 #endif
 	max_port = p->max_port;
+	stp_traced = p->traced;
 	tev = p->tev;
 	nev = p->nev;
+	stp_arena = &p->arena;
 }
 
 void STP_IN_instance_end(struct stp_instance *p)
@@ -1045,8 +1278,10 @@ void STP_IN_instance_end(struct stp_instance *p)
 	p->dbg_rstp_deny = dbg_rstp_deny;
 #endif
 	p->max_port = max_port;
+	p->traced = stp_traced;
 	p->tev = tev;
 	p->nev = nev;
+	stp_arena = &stp_default_arena;
 }
 
 void STP_IN_instance_delete(struct stp_instance *p)
@@ -72,6 +72,12 @@
 
 #define DEF_FORCE_VERS	2 /* NORMAL_RSTP */
 
+#define DEF_FLUSH_WINDOW	0 /* flush at the end of each update */
+#define MIN_FLUSH_WINDOW	0
+#define MAX_FLUSH_WINDOW	10
+
+#define DEF_RX_FAST	1 /* repeated BPDUs skip the machines */
+
 /* port configuration */
 
 #define DEF_PORT_PRIO	128
@@ -107,6 +113,8 @@ int STP_IN_port_create(int vlan_id, int port_index);
 
 int STP_IN_port_delete(int vlan_id, int port_index);
 
+int STP_IN_ports_create_bulk(int vlan_id, BITMAP_T *port_bmp);
+
 /* Section 2. "Get" management */
 
 Bool STP_IN_get_is_stpm_enabled(int vlan_id);
@@ -145,6 +153,9 @@ int STP_IN_dbg_set_port_trace(char *mach_name, int enadis,
 			      int is_print_err);
 #endif
 
+/* port_index 0: the bridge and all its ports; mach_name may be "all" */
+int STP_IN_set_trace(int vlan_id, int port_index, char *mach_name, int enadis);
+
 /* Section 4. RSTP functionality events */
 
 int STP_IN_one_second(void);
@@ -158,6 +169,9 @@ int STP_IN_changed_port_speed(int port_index, long speed);
 /* call it, when current port duplex mode has been changed  */
 int STP_IN_changed_port_duplex(int port_index);
 
+/* call it, when port MAC address has been changed  */
+int STP_IN_changed_port_mac(int port_index);
+
 #ifdef _STP_BPDU_H__
 int STP_IN_check_bpdu_header(BPDU_T *bpdu, size_t len);
 
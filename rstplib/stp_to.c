@@ -38,43 +38,27 @@
 
 extern BITMAP_T enabled_ports;
 
-/*************
- void stp_trace(const char *format, ...)
- {
- #define MAX_MSG_LEN  128
- char     msg[MAX_MSG_LEN];
- va_list  args;
-
- va_start(args, format);
- vsnprintf (msg, MAX_MSG_LEN-1, format, args);
- printf ("%s\n", msg);
- va_end(args);
- 
- }
- ***********/
+#ifndef ORIG
+void stp_trace(const char *format, ...)
+{
+	va_list args;
+
+	va_start(args, format);
+	vprintf(format, args);
+	printf("\n");
+	va_end(args);
+}
+#endif
 
+/* The simulated bridge has no port states to program */
 int STP_OUT_set_learning(int port_index, int vlan_id, int enable)
 {
-#ifdef ORIG
 	return STP_OK;
-#else
-	if (enable) {
-		return STP_OUT_set_port_state(port->port_index, port->owner->vlan_id, UID_PORT_LEARNING);
-	}
-	return STP_OUT_set_port_state(port->port_index, port->owner->vlan_id, UID_PORT_DISCARDING);
-#endif
 }
 
 int STP_OUT_set_forwarding(int port_index, int vlan_id, int enable)
 {
-#ifdef ORIG
 	return STP_OK;
-#else
-	if (enable) {
-		return STP_OUT_set_port_state (port->port_index, port->owner->vlan_id, UID_PORT_FORWARDING);
-	}
-	return STP_OUT_set_port_state(port->port_index, port->owner->vlan_id, UID_PORT_DISCARDING);
-#endif
 }
 
 void STP_OUT_get_port_mac(int port_index, unsigned char *mac)
@@ -113,6 +97,11 @@ int STP_OUT_flush_lt(IN int port_index, IN int vlan_id,
 	return STP_OK;
 }
 
+int STP_OUT_flush_ports(int vlan_id, BITMAP_T *ports, char *reason)
+{
+	return STP_OK;
+}
+
 int STP_OUT_set_hardware_mode(int vlan_id, UID_STP_MODE_T mode)
 {
 	return STP_OK;
@@ -164,6 +153,8 @@ int STP_OUT_get_init_stpm_cfg(IN int vlan_id,
 	cfg->hello_time = DEF_BR_HELLOT;
 	cfg->forward_delay = DEF_BR_FWDELAY;
 	cfg->force_version = NORMAL_RSTP;
+	cfg->flush_window = DEF_FLUSH_WINDOW;
+	cfg->rx_fast = DEF_RX_FAST;
 
 	return STP_OK;
 }
@@ -38,6 +38,11 @@ typedef enum {
 int STP_OUT_flush_lt(IN int port_index, IN int vlan_id,
 		     IN LT_FLASH_TYPE_T type, IN char *reason);
 
+/* Clean the Learning entries of all the ports of the set (bit
+ port_index - 1) at once; it is never empty */
+int STP_OUT_flush_ports(IN int vlan_id, IN BITMAP_T *ports,
+			IN char *reason);
+
 /* for bridge id calculation */
 void STP_OUT_get_port_mac(IN int port_index, OUT unsigned char *mac);
 
@@ -23,19 +23,23 @@
 /* STP machine instance : bridge per VLAN: 17.17 */
 
 #include "base.h"
+#include "arena.h"
 #include "stpm.h"
-#include "stp_to.h" /* for STP_OUT_flush_lt */
+#include "stp_to.h" /* for STP_OUT_flush_ports */
+#include "roletrns.h" /* for STP_roletrns_restart_timers */
 
-/*static*/ STPM_T *bridges = NULL;
+#if defined(__AVX2__)
+#  include <immintrin.h>
+#elif defined(__SSE2__)
+#  include <emmintrin.h>
+#endif
 
-/* We can flush learned fdb by port, so set this in stpm.c and topoch.c  */
-/* This doesn't seem to solve the topology change problems. Don't use it yet */
-//#define STRONGLY_SPEC_802_1W
+/*static*/ STPM_T *bridges = NULL;
 
 static int _stp_stpm_init_machine(STATE_MACH_T *this)
 {
 	this->State = BEGIN;
-	(*(this->concreteEnterState))(this);
+	STP_enter_state(this);
 	return 0;
 }
 
@@ -72,6 +76,186 @@ static int _stp_stpm_iterate_machines(STPM_T *this,
 	return mret;
 }
 
+/* Run the machines of one list to their fixpoint, returns number of loops */
+static int _stp_stpm_run_machines(STATE_MACH_T *machines)
+{
+	register STATE_MACH_T *stater;
+	register int number_of_loops = 0;
+	Bool need_state_change;
+
+	for (;;) {
+		need_state_change = False;
+		for (stater = machines; stater; stater = stater->next) {
+			if (STP_check_condition(stater)) {
+				need_state_change = True;
+				break;
+			}
+		}
+		if (!need_state_change) {
+			return number_of_loops;
+		}
+
+		number_of_loops++;
+		for (stater = machines; stater; stater = stater->next) {
+			number_of_loops += STP_change_state(stater);
+		}
+	}
+}
+
+/* Queue the port machines for STP_stpm_update. The bridge machines
+ * are checked too: the port may have reselect now, the role selection
+ * sees it in reselect_ports. */
+void STP_stpm_mark_port(PORT_T *port)
+{
+	port->owner->dirty = True;
+	if (port->dirty) {
+		return;
+	}
+	port->dirty = True;
+	port->next_dirty = port->owner->dirty_ports;
+	port->owner->dirty_ports = port;
+}
+
+/* For tree-wide changes */
+void STP_stpm_mark_ports(STPM_T *this)
+{
+	register PORT_T *port;
+
+	for (port = this->ports; port; port = port->next) {
+		STP_stpm_mark_port(port);
+	}
+}
+
+/* Take a port, that is going away, off the worklists and the counts */
+void STP_stpm_unmark_port(PORT_T *port)
+{
+	register PORT_T **pp;
+
+	if (port->counted_synced) {
+		port->owner->synced_ports--;
+	}
+	if (port->counted_rerooting) {
+		port->owner->rerooting_ports--;
+	}
+
+	if (port->dirty) {
+		for (pp = &port->owner->dirty_ports; *pp; pp = &(*pp)->next_dirty) {
+			if (*pp == port) {
+				*pp = port->next_dirty;
+				break;
+			}
+		}
+		port->dirty = False;
+	}
+
+	if (port->sel_queued) {
+		for (pp = &port->owner->sel_changed; *pp; pp = &(*pp)->sel_next) {
+			if (*pp == port) {
+				*pp = port->sel_next;
+				break;
+			}
+		}
+		port->sel_queued = False;
+	}
+	if (PORT_GET(port, reselect)) {
+		port->owner->reselect_ports--;
+		PORT_CLR(port, reselect);
+	}
+
+	if (PORT_GET(port, fbdFlush)) {
+		for (pp = &port->owner->flush_ports; *pp; pp = &(*pp)->next_flush) {
+			if (*pp == port) {
+				*pp = port->next_flush;
+				break;
+			}
+		}
+		PORT_CLR(port, fbdFlush);
+	}
+}
+
+/* setSyncTree and setReRootTree, that were done since the port was
+ * checked last, set its sync and reRoot now */
+void STP_stpm_port_catch_up(PORT_T *port)
+{
+	register STPM_T *this = port->owner;
+
+	if (port->sync_seen != this->sync_epoch) {
+		port->sync_seen = this->sync_epoch;
+		PORT_SET(port, sync);
+	}
+	if (port->reroot_seen != this->reroot_epoch) {
+		port->reroot_seen = this->reroot_epoch;
+		PORT_SET(port, reRoot);
+	}
+}
+
+/* Brings synced_ports and rerooting_ports up to date with the port.
+ * Returns True, if allSynced or reRooted of another port may have
+ * changed: allSynced only while (nearly) all ports are synced, reRooted
+ * only while at most one port has rrWhile running. */
+static Bool _stp_stpm_count_port(PORT_T *port)
+{
+	register STPM_T *this = port->owner;
+	Bool synced = PORT_GET(port, synced);
+	Bool rerooting = PORT_TIMER(port, rrWhile) ? True : False;
+	Bool changed = False;
+
+	if (synced != port->counted_synced) {
+		port->counted_synced = synced;
+		this->synced_ports += synced ? 1 : -1;
+		changed |= this->synced_ports + (synced ? 0 : 1) >=
+			   this->port_count - 1;
+	}
+	if (rerooting != port->counted_rerooting) {
+		port->counted_rerooting = rerooting;
+		this->rerooting_ports += rerooting ? 1 : -1;
+		changed |= this->rerooting_ports - (rerooting ? 1 : 0) <= 1;
+	}
+	return changed;
+}
+
+/* fdbFlush (17.19.7) of the port is set: its learned entries have to
+ * be removed. The ports of the bridge are gathered (once each) and
+ * flushed together, when flush_window seconds have passed since the
+ * first of them; 0 is at the end of this update. */
+void STP_stpm_flush_port(PORT_T *port)
+{
+	register STPM_T *this = port->owner;
+
+	this->flush_requests++;
+	if (PORT_GET(port, fbdFlush)) {
+		return; /* it is gathered already */
+	}
+	PORT_SET(port, fbdFlush);
+	if (!this->flush_ports) {
+		this->flush_due = this->seconds + this->flush_window;
+	}
+	port->next_flush = this->flush_ports;
+	this->flush_ports = port;
+}
+
+/* One STP_OUT call for all the gathered ports. Resets their fdbFlush,
+ * so their Topology Change machines have to be checked again. */
+static void _stp_stpm_flush(STPM_T *this, char *reason)
+{
+	register PORT_T *port;
+	BITMAP_T ports;
+
+	BitmapClear(&ports);
+	while ((port = this->flush_ports)) {
+		this->flush_ports = port->next_flush;
+		if (port->port_index <= BITMAP_BITS) {
+			BitmapSetBit(&ports, port->port_index - 1);
+		}
+		PORT_CLR(port, fbdFlush);
+		STP_stpm_mark_port(port);
+		this->flushed_ports++;
+	}
+
+	this->flush_calls++;
+	STP_OUT_flush_ports(this->vlan_id, &ports, reason);
+}
+
 void _stp_stpm_init_data(STPM_T *this)
 {
 	STP_VECT_create(&this->rootPriority,
@@ -85,12 +269,148 @@ void _stp_stpm_init_data(STPM_T *this)
 	STP_copy_times(&this->rootTimes, &this->BridgeTimes);
 }
 
+/* The timers, that a machine keeps at a full value while it stays in a
+ * state, re-entering the state when they are not (Root, Alternate,
+ * Backup and Disabled Port roles; Port Receive and Port Protocol
+ * Migration of a disabled port): every tick, that changes them, has
+ * to be followed. The other timers are only tested for zero (and
+ * txCount for TxHoldCount). */
+#define TICK_HELD_TIMERS	((1 << PT_edgeDelayWhile) |		\
+				 (1 << PT_fdWhile) |			\
+				 (1 << PT_mdelayWhile) |		\
+				 (1 << PT_rbWhile) |			\
+				 (1 << PT_rrWhile))
+
+/* Decrements the timers of the slots [slot, slot + TICK_LANES) of
+ * a block, not below zero. Returns two bits per slot, set for the
+ * slots, that have to be checked: a timer expired or txCount went
+ * down (transmit waits for txCount < TxHoldCount). Sets the same bits
+ * in *held for the slots with a held timer, that is still running.
+ * An expired rrWhile is counted (reRooted of the other ports) by
+ * STP_stpm_update. */
+#if defined(__AVX2__)
+unsigned int STP_stpm_tick_lanes(PORT_TIMER_T *row, int size,
+				 unsigned int *held)
+{
+	__m256i one = _mm256_set1_epi16(1);
+	__m256i ones = _mm256_set1_epi16(-1);
+	__m256i zero = _mm256_setzero_si256();
+	__m256i mark = zero, hold = zero, v, expired;
+	register int ttt;
+
+	for (ttt = 0; ttt < TIMERS_NUMBER; ttt++, row += size) {
+		v = _mm256_loadu_si256((__m256i *)row);
+		if (ttt == PT_txCount) {
+			expired = _mm256_xor_si256(_mm256_cmpeq_epi16(v, zero),
+						   ones);
+		} else {
+			expired = _mm256_cmpeq_epi16(v, one);
+		}
+		mark = _mm256_or_si256(mark, expired);
+		v = _mm256_subs_epu16(v, one);
+		if (TICK_HELD_TIMERS & (1 << ttt)) {
+			hold = _mm256_or_si256(hold,
+				_mm256_xor_si256(_mm256_cmpeq_epi16(v, zero),
+						 ones));
+		}
+		_mm256_storeu_si256((__m256i *)row, v);
+	}
+	*held = (unsigned int)_mm256_movemask_epi8(hold);
+	return (unsigned int)_mm256_movemask_epi8(mark);
+}
+
+static Bool _stp_stpm_row_any(PORT_TIMER_T *row, int size)
+{
+	__m256i acc = _mm256_setzero_si256();
+	register int iii;
+
+	for (iii = 0; iii < size; iii += TICK_LANES) {
+		acc = _mm256_or_si256(acc,
+				      _mm256_loadu_si256((__m256i *)(row + iii)));
+	}
+	return !_mm256_testz_si256(acc, acc);
+}
+#elif defined(__SSE2__)
+unsigned int STP_stpm_tick_lanes(PORT_TIMER_T *row, int size,
+				 unsigned int *held)
+{
+	__m128i one = _mm_set1_epi16(1);
+	__m128i ones = _mm_set1_epi16(-1);
+	__m128i zero = _mm_setzero_si128();
+	__m128i mark = zero, hold = zero, v, expired;
+	register int ttt;
+
+	for (ttt = 0; ttt < TIMERS_NUMBER; ttt++, row += size) {
+		v = _mm_loadu_si128((__m128i *)row);
+		if (ttt == PT_txCount) {
+			expired = _mm_xor_si128(_mm_cmpeq_epi16(v, zero), ones);
+		} else {
+			expired = _mm_cmpeq_epi16(v, one);
+		}
+		mark = _mm_or_si128(mark, expired);
+		v = _mm_subs_epu16(v, one);
+		if (TICK_HELD_TIMERS & (1 << ttt)) {
+			hold = _mm_or_si128(hold,
+				_mm_xor_si128(_mm_cmpeq_epi16(v, zero), ones));
+		}
+		_mm_storeu_si128((__m128i *)row, v);
+	}
+	*held = (unsigned int)_mm_movemask_epi8(hold);
+	return (unsigned int)_mm_movemask_epi8(mark);
+}
+
+static Bool _stp_stpm_row_any(PORT_TIMER_T *row, int size)
+{
+	__m128i acc = _mm_setzero_si128();
+	register int iii;
+
+	for (iii = 0; iii < size; iii += TICK_LANES) {
+		acc = _mm_or_si128(acc, _mm_loadu_si128((__m128i *)(row + iii)));
+	}
+	return _mm_movemask_epi8(_mm_cmpeq_epi16(acc, _mm_setzero_si128()))
+		!= 0xffff;
+}
+#else
+unsigned int STP_stpm_tick_lanes(PORT_TIMER_T *row, int size,
+				 unsigned int *held)
+{
+	unsigned int mark = 0;
+	register int ttt;
+
+	*held = 0;
+	for (ttt = 0; ttt < TIMERS_NUMBER; ttt++, row += size) {
+		if (!*row) {
+			continue;
+		}
+		if (!--*row || ttt == PT_txCount) {
+			mark = 3;
+		}
+		if (*row && (TICK_HELD_TIMERS & (1 << ttt))) {
+			*held = 3;
+		}
+	}
+	return mark;
+}
+
+static Bool _stp_stpm_row_any(PORT_TIMER_T *row, int size)
+{
+	PORT_TIMER_T acc = 0;
+	register int iii;
+
+	for (iii = 0; iii < size; iii++) {
+		acc |= row[iii];
+	}
+	return acc ? True : False;
+}
+#endif
+
 static unsigned char _check_topoch(STPM_T *this)
 {
-	register PORT_T *port;
+	register PORT_BLOCK_T *block;
 
-	for (port = this->ports; port; port = port->next) {
-		if (port->tcWhile) {
+	for (block = this->port_blocks; block; block = block->next) {
+		if (_stp_stpm_row_any(block->timers + PT_tcWhile * block->size,
+				      block->size)) {
 			return 1;
 		}
 	}
@@ -99,20 +419,39 @@ static unsigned char _check_topoch(STPM_T *this)
 
 void STP_stpm_one_second(STPM_T *param) {
 	STPM_T *this = (STPM_T *)param;
+	register PORT_BLOCK_T *block;
 	register PORT_T *port;
-	register int iii;
+	register unsigned int mark;
+	unsigned int held;
+	register int slot, lane;
 
 	if (STP_ENABLED != this->admin_state)
 		return;
 
-	for (port = this->ports; port; port = port->next) {
-		for (iii = 0; iii < TIMERS_NUMBER; iii++) {
-			if (*(port->timers[iii]) > 0) {
-				(*port->timers[iii])--;
+	for (block = this->port_blocks; block; block = block->next) {
+		for (slot = 0; slot < block->size; slot += TICK_LANES) {
+			mark = STP_stpm_tick_lanes(block->timers + slot,
+						   block->size, &held);
+			held &= ~mark;
+			while (mark) {
+				lane = __builtin_ctz(mark) / 2;
+				mark &= ~(3U << (2 * lane));
+				STP_stpm_mark_port(&block->ports[slot + lane]);
+			}
+			/* a settled Root or Alternate port only re-enters its
+			 * state: the timers are restarted, the port is not
+			 * checked */
+			while (held) {
+				lane = __builtin_ctz(held) / 2;
+				held &= ~(3U << (2 * lane));
+				port = &block->ports[slot + lane];
+				if (!STP_roletrns_restart_timers(port)) {
+					STP_stpm_mark_port(port);
+				}
 			}
 		}
-		port->uptime++;
 	}
+	this->seconds++;
 
 	STP_stpm_update (this);
 	this->Topology_Change = _check_topoch (this);
@@ -128,24 +467,26 @@ void STP_stpm_one_second(STPM_T *param) {
 STPM_T *STP_stpm_create(int vlan_id, char *name) {
 	STPM_T *this;
 
-	STP_NEW_IN_LIST(this, STPM_T, bridges, "stp instance");
+	STP_ARENA_NEW(this, STPM_T, 0, "stp instance");
+	this->next = bridges;
+	bridges = this;
 
 	this->admin_state = STP_DISABLED;
 
 	this->vlan_id = vlan_id;
 	if (name) {
-		STP_STRDUP(this->name, name, "stp bridge name");
+		this->name = STP_arena_strdup(name);
+		if (!this->name) {
+			STP_FATAL("strdup", "stp bridge name", -7);
+		}
 	}
 
 	this->machines = NULL;
 	this->ports = NULL;
+	STP_compute_bridge_id(this);
 
 	STP_STATE_MACH_IN_LIST(rolesel);
 
-#ifdef STP_DBG
-	/* this->rolesel->debug = 2;  */
-#endif
-
 	return this;
 }
 
@@ -201,9 +542,13 @@ void STP_stpm_delete(STPM_T *this)
 			}
 
 			if (this->name) {
-				STP_FREE(this->name, "stp bridge name");
+				STP_arena_free_str(this->name);
+			}
+			if (this->sel_tree) {
+				STP_arena_free(this->sel_tree, 2 * this->sel_leaves *
+							       sizeof(PORT_T *));
 			}
-			STP_FREE(this, "stp instance");
+			STP_ARENA_DEL(this, STPM_T, 0);
 			break;
 		}
 		prev = tmp;
@@ -238,6 +583,8 @@ STP_stpm_start(STPM_T *this)
 	}
 
 	_stp_stpm_iterate_machines(this, _stp_stpm_init_machine, False);
+	this->dirty = True;
+	STP_stpm_mark_ports(this);
 	STP_stpm_update(this);
 
 	return 0;
@@ -245,45 +592,222 @@ STP_stpm_start(STPM_T *this)
 
 void STP_stpm_stop(STPM_T *this)
 {
+	/* the window would not end: flush the gathered ports now */
+	if (this->flush_ports) {
+		_stp_stpm_flush(this, "stp stopped");
+	}
 }
 
+/* Only the machines of marked ports (and of the bridge) are checked.
+ * A port is marked when an event touches it: BPDU, expired timer,
+ * management, or a state change of another machine, that writes its
+ * variables (role selection, the *Tree procedures) or that changes what
+ * allSynced and reRooted see. */
 int STP_stpm_update(STPM_T *this) /* returns number of loops */
 {
-	register Bool need_state_change;
+	register PORT_T *port;
 	register int number_of_loops = 0;
-
-	need_state_change = False;
+	unsigned long guard_evals = STP_guard_evals;
+	int iret;
+	Bool counts_changed = False;
+
+	/* what happened to the ports between the updates (expired
+	 * rrWhile, management), before any allSynced or reRooted is
+	 * computed */
+	for (port = this->dirty_ports; port; port = port->next_dirty) {
+		counts_changed |= _stp_stpm_count_port(port);
+	}
+	if (counts_changed) {
+		STP_stpm_mark_ports(this);
+	}
 
 	for (;;) {/* loop until not need changes */
-		need_state_change = _stp_stpm_iterate_machines(this,
-							       STP_check_condition,
-							       True);
-		if (!need_state_change) {
-			return number_of_loops;
+		if (this->dirty) {
+			this->dirty = False;
+			iret = _stp_stpm_run_machines(this->machines);
+			if (iret) {
+				/* role selection has marked the ports, it has
+				 * updated (setSelectedTree) */
+				number_of_loops += iret;
+				this->dirty = False; /* it is at fixpoint */
+			}
 		}
 
-		number_of_loops++;
-		/* here we know, that at least one stater must be
-		 updated (it has changed state) */
-		number_of_loops += _stp_stpm_iterate_machines(this,
-							      STP_change_state,
-							      False);
+		port = this->dirty_ports;
+		if (!port) {
+			if (this->dirty) {
+				continue;
+			}
+			if (this->tree_mark) {
+				/* once for all the *Tree procedures */
+				this->tree_mark = False;
+				STP_stpm_mark_ports(this);
+				continue;
+			}
+			if (this->flush_ports && this->seconds >= this->flush_due) {
+				_stp_stpm_flush(this, "topology change");
+				continue;
+			}
+			break;
+		}
+		this->dirty_ports = port->next_dirty;
+		port->dirty = False;
 
+		STP_stpm_port_catch_up(port);
+		iret = _stp_stpm_run_machines(port->machines);
+		if (!iret) {
+			continue;
+		}
+
+		number_of_loops += iret;
+		this->dirty = True; /* may be reselect */
+		if (_stp_stpm_count_port(port)) {
+			/* other ports' allSynced or reRooted */
+			STP_stpm_mark_ports(this);
+		}
 	}
 
+	this->last_guard_evals = STP_guard_evals - guard_evals;
+	this->guard_evals += this->last_guard_evals;
 	return number_of_loops;
 }
 
+/* Take a free slot, the first block with one, or a new block, and
+ * link the port into the list of ports. The list is kept in the order
+ * of the slots, so a pass over the ports walks the memory forward. */
+PORT_T *STP_stpm_port_alloc(STPM_T *this)
+{
+	PORT_BLOCK_T *block;
+	register PORT_BLOCK_T **last;
+	register PORT_BLOCK_T *tmp;
+	register PORT_T *port, *prev = NULL;
+	register int iii, jjj, size = PORT_BLOCK_SIZE;
+
+	last = &this->port_blocks;
+	for (block = this->port_blocks; block; block = block->next) {
+		if (block->used < block->size) {
+			break;
+		}
+		size = 2 * block->size;
+		last = &block->next;
+	}
+
+	if (!block) {
+		STP_ARENA_NEW(block, PORT_BLOCK_T,
+			      (size - 1) * sizeof(PORT_T), "port block");
+		block->timers = (PORT_TIMER_T *)
+			STP_arena_alloc(TIMERS_NUMBER * size *
+					sizeof(PORT_TIMER_T));
+		if (!block->timers) {
+			STP_FATAL("malloc", "port timers", -6);
+		}
+		block->size = size;
+		*last = block;
+	}
+
+	for (iii = 0; block->ports[iii].in_use; iii++)
+		;
+	block->used++;
+	this->port_count++;
+	port = &block->ports[iii];
+	port->in_use = True;
+	port->timer = block->timers + iii;
+	port->timer_stride = block->size;
+	this->sel_valid = False; /* leaves of the role selection */
+
+	for (tmp = this->port_blocks; tmp != block; tmp = tmp->next) {
+		for (jjj = 0; jjj < tmp->size; jjj++) {
+			if (tmp->ports[jjj].in_use) {
+				prev = &tmp->ports[jjj];
+			}
+		}
+	}
+	for (jjj = 0; jjj < iii; jjj++) {
+		if (block->ports[jjj].in_use) {
+			prev = &block->ports[jjj];
+		}
+	}
+
+	if (prev) {
+		port->next = prev->next;
+		prev->next = port;
+	} else {
+		port->next = this->ports;
+		this->ports = port;
+	}
+	return port;
+}
+
+void STP_stpm_port_free(STPM_T *this, PORT_T *port)
+{
+	register PORT_BLOCK_T *block;
+	register PORT_BLOCK_T **prev;
+	register int iii;
+
+	for (prev = &this->port_blocks; (block = *prev); prev = &block->next) {
+		if (port >= block->ports && port < block->ports + block->size) {
+			break;
+		}
+	}
+	if (!block) {
+		STP_FATAL("free", "port block", -66);
+	}
+
+	for (iii = 0; iii < TIMERS_NUMBER; iii++) {
+		port->timer[iii * block->size] = 0;
+	}
+	memset(port, 0, sizeof(PORT_T));
+	this->sel_valid = False;
+	this->port_count--;
+	if (!--block->used) {
+		*prev = block->next;
+		STP_arena_free(block->timers, TIMERS_NUMBER * block->size *
+					      sizeof(PORT_TIMER_T));
+		STP_ARENA_DEL(block, PORT_BLOCK_T,
+			      (block->size - 1) * sizeof(PORT_T));
+	}
+}
+
+/* Bytes of the arena, that the bridge takes, with its ports */
+unsigned long STP_stpm_mem_bytes(STPM_T *this)
+{
+	register PORT_BLOCK_T *block;
+	register PORT_T *port;
+	register STATE_MACH_T *stater;
+	unsigned long bytes;
+
+	bytes = STP_ARENA_SIZE(sizeof(STPM_T));
+	if (this->name) {
+		bytes += STP_ARENA_SIZE(strlen(this->name) + 1);
+	}
+	for (stater = this->machines; stater; stater = stater->next) {
+		bytes += STP_ARENA_SIZE(sizeof(STATE_MACH_T));
+	}
+	for (block = this->port_blocks; block; block = block->next) {
+		bytes += STP_ARENA_SIZE(sizeof(PORT_BLOCK_T) +
+					(block->size - 1) * sizeof(PORT_T));
+		bytes += STP_ARENA_SIZE(TIMERS_NUMBER * block->size *
+					sizeof(PORT_TIMER_T));
+	}
+	for (port = this->ports; port; port = port->next) {
+		bytes += STP_ARENA_SIZE(strlen(port->port_name) + 1);
+	}
+	if (this->sel_tree) {
+		bytes += STP_ARENA_SIZE(2 * this->sel_leaves * sizeof(PORT_T *));
+	}
+
+	return bytes;
+}
+
 BRIDGE_ID *STP_compute_bridge_id(STPM_T *this)
 {
 	register PORT_T *port;
-	unsigned char old[6], new[6];
+	unsigned char old[6];
 	memset(&old, 0xff, sizeof(old));
 
 	for (port = this->ports; port; port = port->next) {
-		STP_OUT_get_port_mac (port->port_index, new);
-		if (memcmp(new, old, sizeof(old)) < 0) {
-			memcpy(old, new, sizeof(old));
+		if (memcmp(port->mac, old, sizeof(old)) < 0) {
+			memcpy(old, port->mac, sizeof(old));
 		}
 	}
 
@@ -292,6 +816,27 @@ BRIDGE_ID *STP_compute_bridge_id(STPM_T *this)
 	return &this->BridgeIdentifier;
 }
 
+/* Keep the bridge address the lowest port MAC when a port MAC
+ * comes (old == NULL), goes (new == NULL) or changes, without
+ * looking at the other ports unless the lowest one went away.
+ * Returns True, if the bridge address has changed. */
+Bool STP_stpm_port_mac_changed(STPM_T *this,
+			       const unsigned char *old,
+			       const unsigned char *new)
+{
+	unsigned char prev[6];
+
+	memcpy(prev, this->BridgeIdentifier.addr, sizeof(prev));
+	if (new && memcmp(new, prev, sizeof(prev)) < 0) {
+		memcpy(this->BridgeIdentifier.addr, new, sizeof(prev));
+	} else if (old && !memcmp(old, prev, sizeof(prev))) {
+		STP_compute_bridge_id(this);
+	}
+
+	return memcmp(prev, this->BridgeIdentifier.addr, sizeof(prev)) ?
+		True : False;
+}
+
 STPM_T *STP_stpm_get_the_list(void) {
 	return bridges;
 }
@@ -310,6 +855,61 @@ void STP_stpm_update_after_bridge_management(STPM_T *this)
 	}
 
 	_stp_stpm_iterate_machines(this, _stp_stpm_init_machine, False);
+	this->dirty = True;
+	STP_stpm_mark_ports(this);
+	STP_stpm_update(this);
+}
+
+/* The bridge priority, times or Force Protocol Version have changed
+ * (17.13): the role selection picks them up on all the ports, updtInfo
+ * passes them on, a new version makes the ports migrate again (mcheck) */
+void STP_stpm_update_after_bridge_cfg(STPM_T *this, Bool new_version)
+{
+	register PORT_T *port;
+
+	for (port = this->ports; port; port = port->next) {
+		STP_rolesel_reselect(port);
+		if (new_version) {
+			PORT_SET(port, mcheck);
+		}
+		STP_stpm_mark_port(port);
+	}
+	this->dirty = True;
+	STP_stpm_update(this);
+}
+
+/* A port has joined the running bridge and the bridge Id stays: only its
+ * own machines begin, the role selection sees it through its leaf */
+void STP_stpm_port_added(STPM_T *this, PORT_T *port)
+{
+	STP_stpm_port_begin(port);
+	this->dirty = True;
+	STP_stpm_update(this);
+}
+
+/* Puts the machines of the port to BEGIN, the caller runs the update */
+void STP_stpm_port_begin(PORT_T *port)
+{
+	register STATE_MACH_T *stater;
+
+	for (stater = port->machines; stater; stater = stater->next) {
+		_stp_stpm_init_machine(stater);
+	}
+	STP_stpm_mark_port(port);
+}
+
+/* A port has left the running bridge and the bridge Id stays: the roles
+ * are selected again (it may have been the Root Port) and the other ports
+ * are checked (allSynced, reRooted), their machines are not restarted */
+void STP_stpm_port_removed(STPM_T *this)
+{
+	register PORT_T *port;
+
+	for (port = this->ports; port; port = port->next) {
+		STP_rolesel_reselect(port);
+		STP_stpm_mark_port(port);
+	}
+	this->dirty = True;
 	STP_stpm_update(this);
 }
 
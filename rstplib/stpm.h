@@ -49,15 +49,89 @@ typedef enum {/* 17.12, 17.16.1 */
 	NORMAL_RSTP = 2
 } PROTOCOL_VERSION_T;
 
+#define PORT_BLOCK_SIZE	16 /* slots in the first block, a multiple of 16 */
+
+/* STP_stpm_one_second() decrements TICK_LANES slots of a timer row
+ * at once */
+#if defined(__AVX2__)
+#  define TICK_LANES	16
+#elif defined(__SSE2__)
+#  define TICK_LANES	8
+#else
+#  define TICK_LANES	1
+#endif
+
+/* Ports of a bridge are kept in blocks of contiguous slots. Each new
+ * block is twice as large as the one before it, so that most ports
+ * of a large bridge share one array. The timers of the ports are
+ * kept apart, TIMERS_NUMBER rows of size: timers[timer * size + slot] */
+typedef struct port_block_t {
+	struct port_block_t *next;
+	int size;
+	int used;
+	PORT_TIMER_T *timers;
+	PORT_T ports[1]; /* size of them */
+} PORT_BLOCK_T;
+
 typedef struct stpm_t {
 	struct stpm_t *next;
 
 	struct port_t *ports;
+	PORT_BLOCK_T *port_blocks;
 
 	/* The only "per bridge" state machine */
 	STATE_MACH_T *rolesel; /* the Port Role Selection State machione: 17.28 */
 	STATE_MACH_T *machines;
 
+	/* what STP_stpm_update has to check */
+	Bool dirty; /* the bridge machines */
+	struct port_t *dirty_ports; /* worklist of ports, see next_dirty */
+
+	/* fdb flushes, that the Topology Change machines ask (fdbFlush):
+	 * gathered for flush_window seconds, then flushed as one set */
+	struct port_t *flush_ports; /* ports with fbdFlush, see next_flush */
+	int flush_window;
+	unsigned long flush_due; /* seconds, when flush_ports are flushed */
+	unsigned long flush_requests; /* by the machines */
+	unsigned long flushed_ports; /* in the flushed sets */
+	unsigned long flush_calls; /* of STP_OUT_flush_ports */
+
+	/* tcProp (17.19.44) of all the ports at once: setTcPropTree counts
+	 * tc_prop_epoch up, a port has tcProp while its tc_prop_seen is
+	 * behind it (see topoch.c) */
+	unsigned long tc_prop_epoch;
+
+	/* sync and reRoot of all the ports at once (setSyncTree and
+	 * setReRootTree): a port takes them, when its epoch is behind,
+	 * just before its machines are checked (STP_stpm_port_catch_up) */
+	unsigned long sync_epoch;
+	unsigned long reroot_epoch;
+
+	Bool tree_mark; /* all ports to be checked by STP_stpm_update */
+
+	/* allSynced and reRooted (17.20.3, 17.20.10) without a loop over
+	 * the ports: the ports with synced and with rrWhile != 0, as they
+	 * were counted last (see counted_synced in PORT_T) */
+	int port_count;
+	int synced_ports;
+	int rerooting_ports;
+
+	Bool rx_fast; /* repeated BPDUs skip the machines */
+	unsigned long rx_fast_bpdus; /* that did */
+
+	/* what the Port Role Selection keeps between selections, see
+	 * rolesel.c: a tournament tree over the root path priority vectors
+	 * of the ports and the bridge values, the roles were computed from */
+	struct port_t **sel_tree; /* winners, leaves from sel_leaves on */
+	int sel_leaves;
+	Bool sel_valid; /* the tree and all the selected roles */
+	struct port_t *sel_changed; /* worklist of ports, see sel_next */
+	int reselect_ports; /* with reselect, all are in sel_changed */
+	PRIO_VECTOR_T sel_rootPriority;
+	TIMEVALUES_T sel_rootTimes;
+	BRIDGE_ID sel_bridge;
+	TIMEVALUES_T sel_bridgeTimes;
+
 	/* variables */
 	PROTOCOL_VERSION_T	ForceVersion;		/* 17.13.4 */
 	BRIDGE_ID		BridgeIdentifier;	/* 17.18.2 */
@@ -73,6 +147,11 @@ typedef struct stpm_t {
 	char *name; /* name of the VLAN, maily for debugging */
 	UID_STP_MODE_T admin_state; /* STP_DISABLED or STP_ENABLED; type see in UiD */
 
+	unsigned long guard_evals; /* all, by STP_stpm_update */
+	unsigned long last_guard_evals; /* by the last STP_stpm_update */
+
+	unsigned long seconds; /* ticks while enabled, for the port uptime */
+
 	unsigned long Time_Since_Topology_Change; /* 14.8.1.1.3.b */
 	unsigned long Topology_Change_Count; /* 14.8.1.1.3.c */
 	unsigned char Topology_Change; /* 14.8.1.1.3.d */
@@ -94,14 +173,45 @@ void STP_stpm_stop(STPM_T *this);
 
 int STP_stpm_update(STPM_T *this);
 
+void STP_stpm_mark_port(PORT_T *port);
+
+void STP_stpm_mark_ports(STPM_T *this);
+
+void STP_stpm_unmark_port(PORT_T *port);
+
+void STP_stpm_flush_port(PORT_T *port);
+
+void STP_stpm_port_catch_up(PORT_T *port);
+
+unsigned int STP_stpm_tick_lanes(PORT_TIMER_T *row, int size,
+				 unsigned int *held);
+
+PORT_T *STP_stpm_port_alloc(STPM_T *this);
+
+void STP_stpm_port_free(STPM_T *this, PORT_T *port);
+
+unsigned long STP_stpm_mem_bytes(STPM_T *this);
+
 BRIDGE_ID *STP_compute_bridge_id(STPM_T *this);
 
+Bool STP_stpm_port_mac_changed(STPM_T *this,
+			       const unsigned char *old,
+			       const unsigned char *new);
+
 STPM_T *STP_stpm_get_the_list(void);
 
 extern STPM_T *bridges;
  
 void STP_stpm_update_after_bridge_management(STPM_T *this);
 
+void STP_stpm_update_after_bridge_cfg(STPM_T *this, Bool new_version);
+
+void STP_stpm_port_added(STPM_T *this, PORT_T *port);
+
+void STP_stpm_port_begin(PORT_T *port);
+
+void STP_stpm_port_removed(STPM_T *this);
+
 int STP_stpm_check_bridge_priority(STPM_T *this);
 
 const char *STP_stpm_get_port_name_by_id(STPM_T *this, PORT_ID port_id);
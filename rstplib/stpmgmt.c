@@ -23,6 +23,7 @@
 /* This file contains API from an operation system to the RSTP library */
 
 #include "base.h"
+#include "arena.h"
 #include "stpm.h"
 #include "stp_in.h" /* for bridge defaults */
 #include "stp_to.h"
@@ -36,6 +37,8 @@ int STP_IN_stpm_create(int vlan_id, char *name, BITMAP_T *port_bmp)
 	stp_trace ("STP_IN_stpm_create(%s)", name);
 
 	init_cfg.field_mask = BR_CFG_ALL;
+	init_cfg.flush_window = DEF_FLUSH_WINDOW; /* if STP_OUT leaves it */
+	init_cfg.rx_fast = DEF_RX_FAST;
 	STP_OUT_get_init_stpm_cfg (vlan_id, &init_cfg);
 	init_cfg.field_mask = 0;
 
@@ -48,6 +51,8 @@ int STP_IN_stpm_create(int vlan_id, char *name, BITMAP_T *port_bmp)
 		this->BridgeTimes.ForwardDelay = init_cfg.forward_delay;
 		this->ForceVersion
 		                = (PROTOCOL_VERSION_T) init_cfg.force_version;
+		this->flush_window = init_cfg.flush_window;
+		this->rx_fast = init_cfg.rx_fast ? True : False;
 		if (this->ForceVersion >= 2) {
 			this->rstpVersion = True;
 			this->stpVersion = False;
@@ -157,9 +162,13 @@ int STP_IN_delete_all(void)
 	for (stpm = STP_stpm_get_the_list (); stpm; stpm = next) {
 		next = stpm->next;
 		STP_stpm_enable (stpm, STP_DISABLED);
-		STP_stpm_delete (stpm);
 	}
 
+	/* everything of the bridges is in the arena: free it at once */
+	bridges = NULL;
+	STP_arena_release (stp_arena);
+	stp_traced = 0;
+
 	RSTP_CRITICAL_PATH_END;
 	return 0;
 }
@@ -71,17 +71,17 @@ void STP_sttrans_enter_state(STATE_MACH_T *this)
 		case BEGIN:
 		case DISCARDING:
 			disableLearning (this);
-			port->learning = False;
+			PORT_CLR(port, learning);
 			disableForwarding (this);
-			port->forwarding = False;
+			PORT_CLR(port, forwarding);
 			break;
 		case LEARNING:
 			enableLearning (this);
-			port->learning = True;
+			PORT_SET(port, learning);
 			break;
 		case FORWARDING:
 			enableForwarding (this);
-			port->forwarding = True;
+			PORT_SET(port, forwarding);
 			break;
 	}
 
@@ -97,20 +97,20 @@ Bool STP_sttrans_check_conditions(STATE_MACH_T *this)
 
 	switch (this->State) {
 		case DISCARDING:
-			if (port->learn) {
+			if (PORT_GET(port, learn)) {
 				return STP_hop_2_state (this, LEARNING);
 			}
 			break;
 		case LEARNING:
-			if (port->forward) {
+			if (PORT_GET(port, forward)) {
 				return STP_hop_2_state (this, FORWARDING);
 			}
-			if (!port->learn) {
+			if (!PORT_GET(port, learn)) {
 				return STP_hop_2_state (this, DISCARDING);
 			}
 			break;
 		case FORWARDING:
-			if (!port->forward) {
+			if (!PORT_GET(port, forward)) {
 				return STP_hop_2_state (this, DISCARDING);
 			}
 			break;
@@ -0,0 +1,127 @@
+/************************************************************************
+ * RSTP library - Rapid Spanning Tree (802.1D-2004)
+ *
+ * This file is part of RSTP library.
+ *
+ * RSTP library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; version 2.1
+ *
+ * RSTP library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with RSTP library; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **********************************************************************/
+
+/* The fdb flushes of a bridge (STP_stpm_flush_port): all the requests
+ * inside one flush window give one STP_OUT_flush_ports call. */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "test_to.h"
+
+#define PORTS		32
+#define WINDOW		5
+
+static void test_set_window(int br, int window)
+{
+	UID_STP_CFG_T cfg;
+
+	memset(&cfg, 0, sizeof(cfg));
+	cfg.field_mask = BR_CFG_FLUSH_WINDOW;
+	cfg.flush_window = window;
+	TEST_begin(br);
+	TEST_CHECK(STP_IN_stpm_set_cfg(0, NULL, &cfg) == STP_OK);
+	TEST_end();
+}
+
+/* the requests of the machines, each port twice */
+static void test_requests(void)
+{
+	register STPM_T *stpm;
+	register int iii, sec;
+	unsigned long calls = TEST_flush_calls;
+	unsigned long flushed = TEST_flushed_ports;
+
+	TEST_begin(0);
+	stpm = STP_stpm_get_the_list();
+	stpm->flush_requests = stpm->flush_calls = stpm->flushed_ports = 0;
+	for (iii = 1; iii <= 2 * PORTS; iii++)
+		STP_stpm_flush_port(TEST_port((iii - 1) % PORTS + 1));
+	TEST_end();
+
+	for (sec = 1; sec < WINDOW; sec++) {
+		TEST_run(1);
+		TEST_CHECK(TEST_flush_calls == calls);
+	}
+	TEST_run(1);
+	TEST_CHECK(TEST_flush_calls == calls + 1);
+	TEST_CHECK(TEST_flushed_ports == flushed + PORTS);
+	TEST_CHECK(stpm->flush_requests == 2 * PORTS);
+	TEST_CHECK(stpm->flush_calls == 1);
+	TEST_CHECK(stpm->flushed_ports == PORTS);
+
+	TEST_run(2 * WINDOW);
+	TEST_CHECK(TEST_flush_calls == calls + 1);
+}
+
+/* The Root Port of bridge 2 goes down, its Alternate Port 3 takes
+ * over: the topology change comes to bridge 1 on its port 3 and
+ * flushes its other ports, once for each TC BPDU, that bridge 2 sends
+ * while its tcWhile runs; all of them inside one window */
+static void test_topology_change(void)
+{
+	register STPM_T *stpm;
+	register int sec;
+	unsigned long calls, requests, flushed;
+
+	TEST_begin(1);
+	stpm = STP_stpm_get_the_list();
+	calls = stpm->flush_calls;
+	requests = stpm->flush_requests;
+	flushed = stpm->flushed_ports;
+	TEST_end();
+
+	TEST_unlink(1, 2);
+	for (sec = 0; sec < 30 && stpm->flush_requests == requests; sec++)
+		TEST_run(1);
+	TEST_CHECK(stpm->flush_requests > requests);
+
+	/* the window started in the last second */
+	for (sec = 1; sec < WINDOW; sec++) {
+		TEST_run(1);
+		TEST_CHECK(stpm->flush_calls == calls);
+	}
+	TEST_run(1);
+	TEST_CHECK(stpm->flush_requests >= requests + 2 * (PORTS - 1));
+	TEST_CHECK(stpm->flush_calls == calls + 1);
+	TEST_CHECK(stpm->flushed_ports == flushed + PORTS - 1);
+
+	TEST_run(30);
+	TEST_CHECK(stpm->flush_calls == calls + 1);
+}
+
+int main(int argc, char **argv)
+{
+	register int iii;
+
+	TEST_bridge_create(0, PORTS, 4096);
+	TEST_bridge_create(1, PORTS, 8192);
+	TEST_bridge_create(2, PORTS, 32768);
+	TEST_link(0, 1, 1, 1);
+	for (iii = 2; iii <= PORTS; iii++)
+		TEST_link(1, iii, 2, iii);
+	TEST_run(60);
+
+	test_set_window(0, WINDOW);
+	test_set_window(1, WINDOW);
+	test_requests();
+	test_topology_change();
+	return TEST_result("test_flush");
+}
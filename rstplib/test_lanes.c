@@ -0,0 +1,116 @@
+/************************************************************************
+ * RSTP library - Rapid Spanning Tree (802.1D-2004)
+ *
+ * This file is part of RSTP library.
+ *
+ * RSTP library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; version 2.1
+ *
+ * RSTP library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with RSTP library; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **********************************************************************/
+
+/* STP_stpm_tick_lanes against a plain model of one tick, slot by slot.
+ * The Makefile builds it with each variant of stpm.c (scalar, SSE2,
+ * AVX2), so that all of them give the same timers and masks. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "test_to.h"
+
+#define ROW_SIZE	(4 * PORT_BLOCK_SIZE)
+
+/* the timers, that the machines hold at a full value */
+static const int held_timers[] = {
+	PT_edgeDelayWhile, PT_fdWhile, PT_mdelayWhile, PT_rbWhile, PT_rrWhile
+};
+
+static const PORT_TIMER_T edges[] = {
+	0, 1, 2, 3, 15, 0x7fff, 0x8000, 0x8001, 0xfffe, 0xffff
+};
+
+/* one tick of one slot: the new timers, the check and held masks */
+static void test_model(PORT_TIMER_T *row, int size,
+		       unsigned int *mark, unsigned int *held)
+{
+	register int ttt, iii;
+
+	*mark = *held = 0;
+	for (ttt = 0; ttt < TIMERS_NUMBER; ttt++, row += size) {
+		if (ttt == PT_txCount ? *row != 0 : *row == 1)
+			*mark = 3;
+		if (*row)
+			--*row;
+		for (iii = 0; iii < sizeof(held_timers) / sizeof(int); iii++) {
+			if (held_timers[iii] == ttt && *row)
+				*held = 3;
+		}
+	}
+}
+
+static void test_rows(PORT_TIMER_T *timers)
+{
+	static PORT_TIMER_T expect[TIMERS_NUMBER * ROW_SIZE];
+	unsigned int mark, held, lane_mark, lane_held;
+	unsigned int expect_mark, expect_held;
+	register int slot, lane;
+
+	memcpy(expect, timers, sizeof(expect));
+	for (slot = 0; slot < ROW_SIZE; slot += TICK_LANES) {
+		mark = STP_stpm_tick_lanes(timers + slot, ROW_SIZE, &held);
+		expect_mark = expect_held = 0;
+		for (lane = 0; lane < TICK_LANES; lane++) {
+			test_model(expect + slot + lane, ROW_SIZE,
+				   &lane_mark, &lane_held);
+			expect_mark |= lane_mark << (2 * lane);
+			expect_held |= lane_held << (2 * lane);
+		}
+		TEST_CHECK(mark == expect_mark);
+		TEST_CHECK(held == expect_held);
+	}
+	TEST_CHECK(!memcmp(timers, expect, sizeof(expect)));
+}
+
+int main(int argc, char **argv)
+{
+	static PORT_TIMER_T timers[TIMERS_NUMBER * ROW_SIZE];
+	register int iii, round;
+	int nedges = sizeof(edges) / sizeof(edges[0]);
+
+#if defined(__AVX2__)
+	if (!__builtin_cpu_supports("avx2")) {
+		printf("test_lanes: skipped, no AVX2\n");
+		return 0;
+	}
+#endif
+
+	/* every edge value in every timer row and slot */
+	for (round = 0; round < nedges; round++) {
+		for (iii = 0; iii < TIMERS_NUMBER * ROW_SIZE; iii++)
+			timers[iii] = edges[(iii + round) % nedges];
+		test_rows(timers);
+	}
+
+	/* mixed slots, most of the timers stopped as on a real bridge */
+	srand(1);
+	for (round = 0; round < 10000; round++) {
+		for (iii = 0; iii < TIMERS_NUMBER * ROW_SIZE; iii++) {
+			timers[iii] = rand() % 4 ? 0 :
+				      edges[rand() % nedges];
+		}
+		test_rows(timers);
+	}
+
+	printf("test_lanes: %d lanes\n", TICK_LANES);
+	return TEST_result("test_lanes");
+}
@@ -0,0 +1,192 @@
+/************************************************************************
+ * RSTP library - Rapid Spanning Tree (802.1D-2004)
+ *
+ * This file is part of RSTP library.
+ *
+ * RSTP library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; version 2.1
+ *
+ * RSTP library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with RSTP library; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **********************************************************************/
+
+/* The table driven Port Protocol Migration machine (migrate.c, made by
+ * stmtab.h) against the hand-written switch, that it replaced: in every
+ * state, for every value of what the guards and the actions read, both
+ * go to the same state and leave the port the same. */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "test_to.h"
+#include "migrate.h"
+
+/* the states of the hand-written machine, in its order */
+enum { CHECKING_RSTP, SELECTING_STP, SENSING, TEST_STATES };
+
+/* the hand-written machine, as it was in migrate.c */
+static void ref_enter_state(STATE_MACH_T *this)
+{
+	register PORT_T *port = this->owner.port;
+	register STPM_T *stpm = port->owner;
+
+	switch (this->State) {
+		case BEGIN:
+		case CHECKING_RSTP:
+			PORT_CLR(port, mcheck);
+			PORT_PUT(port, sendRSTP, stpm->rstpVersion);
+			PORT_TIMER(port, mdelayWhile) = MigrateTime;
+			break;
+		case SELECTING_STP:
+			PORT_CLR(port, sendRSTP);
+			PORT_TIMER(port, mdelayWhile) = MigrateTime;
+			break;
+		case SENSING:
+			PORT_CLR_FLAGS(port, PORT_FLAG(rcvdRSTP) |
+					     PORT_FLAG(rcvdSTP));
+			break;
+	}
+}
+
+static Bool ref_check_conditions(STATE_MACH_T *this)
+{
+	register PORT_T *port = this->owner.port;
+	register STPM_T *stpm = port->owner;
+
+	if (BEGIN == this->State)
+		return STP_hop_2_state (this, CHECKING_RSTP);
+
+	switch (this->State) {
+		case CHECKING_RSTP:
+			if (PORT_TIMER(port, mdelayWhile) == 0) {
+				return STP_hop_2_state(this, SENSING);
+			}
+			if (PORT_TIMER(port, mdelayWhile) != MigrateTime &&
+			    !PORT_GET(port, portEnabled)) {
+				return STP_hop_2_state(this, CHECKING_RSTP);
+			}
+			break;
+		case SELECTING_STP:
+			if (PORT_TIMER(port, mdelayWhile) == 0 ||
+			    !PORT_GET(port, portEnabled) ||
+			    PORT_GET(port, mcheck)) {
+				return STP_hop_2_state(this, SENSING);
+			}
+			break;
+		case SENSING:
+			if (!PORT_GET(port, portEnabled) ||
+			    PORT_GET(port, mcheck) ||
+			    (stpm->rstpVersion && !PORT_GET(port, sendRSTP) &&
+			     PORT_GET(port, rcvdRSTP))) {
+				return STP_hop_2_state(this, CHECKING_RSTP);
+			}
+			if (PORT_ALL_FLAGS(port, PORT_FLAG(sendRSTP) |
+						 PORT_FLAG(rcvdSTP))) {
+				return STP_hop_2_state(this, SELECTING_STP);
+			}
+	}
+	return False;
+}
+
+/* what the machine reads */
+static const PORT_FLAGS_T test_flags[] = {
+	PORT_FLAG(portEnabled), PORT_FLAG(mcheck), PORT_FLAG(sendRSTP),
+	PORT_FLAG(rcvdRSTP), PORT_FLAG(rcvdSTP)
+};
+#define TEST_FLAGS	(sizeof(test_flags) / sizeof(test_flags[0]))
+
+static const PORT_TIMER_T test_mdelay[] = { 0, 1, MigrateTime };
+#define TEST_MDELAYS	(sizeof(test_mdelay) / sizeof(test_mdelay[0]))
+
+static void test_set(PORT_T *port, int input)
+{
+	register int iii;
+
+	PORT_TIMER(port, mdelayWhile) = test_mdelay[input % TEST_MDELAYS];
+	input /= TEST_MDELAYS;
+	port->owner->rstpVersion = input & 1;
+	input >>= 1;
+	for (iii = 0; iii < TEST_FLAGS; iii++, input >>= 1) {
+		if (input & 1) {
+			port->flags |= test_flags[iii];
+		} else {
+			port->flags &= ~test_flags[iii];
+		}
+	}
+}
+
+/* one state, one input: the transition and the entered state */
+static void test_one(PORT_T *port, unsigned int state, int input)
+{
+	STATE_MACH_T ref, gen;
+	PORT_FLAGS_T ref_flags;
+	PORT_TIMER_T ref_mdelay;
+	Bool ref_ret, gen_ret;
+
+	memcpy(&ref, port->migrate, sizeof(ref));
+	memcpy(&gen, port->migrate, sizeof(gen));
+	ref.State = gen.State = state;
+
+	test_set(port, input);
+	ref_ret = ref_check_conditions(&ref);
+	test_set(port, input);
+	gen_ret = STP_migrate_check_conditions(&gen);
+	if (ref_ret != gen_ret || ref.State != gen.State) {
+		printf("state %s, input %d: %s %d, table %s %d\n",
+		       STP_migrate_get_state_name(state), input,
+		       STP_migrate_get_state_name(ref.State), ref_ret,
+		       STP_migrate_get_state_name(gen.State), gen_ret);
+		TEST_failed++;
+		return;
+	}
+
+	test_set(port, input);
+	ref_enter_state(&ref);
+	ref_flags = port->flags;
+	ref_mdelay = PORT_TIMER(port, mdelayWhile);
+	test_set(port, input);
+	STP_migrate_enter_state(&gen);
+	TEST_CHECK(port->flags == ref_flags);
+	TEST_CHECK(PORT_TIMER(port, mdelayWhile) == ref_mdelay);
+}
+
+int main(int argc, char **argv)
+{
+	register PORT_T *port;
+	register int input, inputs;
+	register unsigned int state;
+	PORT_FLAGS_T flags;
+	PORT_TIMER_T mdelay;
+	Bool rstp_version;
+
+	TEST_bridge_create(0, 1, 32768);
+	TEST_begin(0);
+	port = TEST_port(1);
+	flags = port->flags;
+	mdelay = PORT_TIMER(port, mdelayWhile);
+	rstp_version = port->owner->rstpVersion;
+
+	inputs = TEST_MDELAYS * 2 << TEST_FLAGS;
+	for (input = 0; input < inputs; input++) {
+		test_one(port, BEGIN, input);
+		for (state = 0; state < TEST_STATES; state++) {
+			test_one(port, state, input);
+		}
+	}
+
+	port->flags = flags;
+	PORT_TIMER(port, mdelayWhile) = mdelay;
+	port->owner->rstpVersion = rstp_version;
+	TEST_end();
+
+	printf("test_migrate: %d states, %d inputs\n", TEST_STATES + 1, inputs);
+	return TEST_result("test_migrate");
+}
@@ -0,0 +1,247 @@
+/************************************************************************
+ * RSTP library - Rapid Spanning Tree (802.1D-2004)
+ *
+ * This file is part of RSTP library.
+ *
+ * RSTP library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; version 2.1
+ *
+ * RSTP library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with RSTP library; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **********************************************************************/
+
+/* Ports of a running bridge: adding or removing one (STP_IN_port_create,
+ * STP_IN_port_delete) does not change the other ports of a converged
+ * bridge, nor leaves it in the worklist of the role selection. The Port
+ * Identifier keeps the priority and the port number
+ * of any port up to UID_PORT_ID_MAX_NUMBER. */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "test_to.h"
+
+#define PORTS		200
+
+typedef struct {
+	PORT_ROLE_T role;
+	Bool learning;
+	Bool forwarding;
+} TEST_PORT_STATE_T;
+
+static TEST_PORT_STATE_T test_state[2][PORTS + 2];
+
+static void test_snap(int br, TEST_PORT_STATE_T *state)
+{
+	register PORT_T *port;
+
+	TEST_begin(br);
+	for (port = STP_stpm_get_the_list()->ports; port; port = port->next) {
+		state[port->port_index].role = port->role;
+		state[port->port_index].learning = PORT_GET(port, learning);
+		state[port->port_index].forwarding = PORT_GET(port, forwarding);
+	}
+	TEST_end();
+}
+
+/* reselect_ports counts the ports with reselect, they are all queued
+ * in sel_changed, that holds ports of the bridge only */
+static void test_worklist(int br)
+{
+	register STPM_T *stpm;
+	register PORT_T *port, *oth;
+	register int reselect = 0;
+
+	TEST_begin(br);
+	stpm = STP_stpm_get_the_list();
+	for (port = stpm->ports; port; port = port->next) {
+		if (PORT_GET(port, reselect)) {
+			reselect++;
+			TEST_CHECK(port->sel_queued);
+		}
+	}
+	TEST_CHECK(stpm->reselect_ports == reselect);
+	for (port = stpm->sel_changed; port; port = port->sel_next) {
+		for (oth = stpm->ports; oth && oth != port; oth = oth->next)
+			;
+		TEST_CHECK(oth && port->sel_queued);
+	}
+	TEST_end();
+}
+
+/* the ports [1, last] of both bridges are as in test_state, through
+ * 'seconds' seconds */
+static void test_unchanged(int last, int seconds)
+{
+	static TEST_PORT_STATE_T now[PORTS + 2];
+	register int br, iii, changed;
+
+	while (seconds-- > 0) {
+		TEST_run(1);
+		for (br = 0; br < 2; br++) {
+			test_snap(br, now);
+			for (changed = 0, iii = 1; iii <= last; iii++) {
+				if (now[iii].role != test_state[br][iii].role ||
+				    now[iii].learning !=
+				    test_state[br][iii].learning ||
+				    now[iii].forwarding !=
+				    test_state[br][iii].forwarding)
+					changed++;
+			}
+			TEST_CHECK(!changed);
+			test_worklist(br);
+		}
+	}
+}
+
+static void test_add_remove(void)
+{
+	UID_STP_STATE_T before, after;
+	UID_STP_PORT_CFG_T cfg;
+	register int iii, br;
+
+	TEST_bridge_create(0, PORTS, 4096);
+	TEST_bridge_create(1, PORTS, 32768);
+	for (iii = 1; iii <= PORTS; iii++)
+		TEST_link(0, iii, 1, iii);
+	TEST_run(60);
+	test_snap(0, test_state[0]);
+	test_snap(1, test_state[1]);
+
+	/* bridge 1 has 1 Root and 199 Alternate Ports, all settled */
+	TEST_CHECK(test_state[1][1].role == RootPort);
+	TEST_CHECK(test_state[1][1].forwarding);
+	TEST_CHECK(test_state[1][PORTS].role == AlternatePort);
+
+	/* a new link: the port is added on both bridges, their bridge
+	 * identifiers stay */
+	for (br = 0; br < 2; br++) {
+		TEST_begin(br);
+		STP_IN_stpm_get_state(0, &before);
+		TEST_CHECK(STP_IN_port_create(0, PORTS + 1) == STP_OK);
+		STP_IN_stpm_get_state(0, &after);
+		TEST_CHECK(!memcmp(&before.bridge_id, &after.bridge_id,
+				   sizeof(before.bridge_id)));
+		TEST_end();
+	}
+	TEST_link(0, PORTS + 1, 1, PORTS + 1);
+	test_unchanged(PORTS, 60);
+	TEST_begin(1);
+	TEST_CHECK(TEST_port(PORTS + 1)->role == AlternatePort);
+	TEST_end();
+
+	/* on bridge 1 it goes as a non STP port, that every selection
+	 * queues again */
+	TEST_unlink(0, PORTS + 1);
+	TEST_begin(1);
+	memset(&cfg, 0, sizeof(cfg));
+	cfg.field_mask = PT_CFG_NON_STP;
+	cfg.admin_non_stp = 1;
+	TEST_CHECK(STP_IN_set_port_cfg(0, PORTS + 1, &cfg) == STP_OK);
+	TEST_CHECK(TEST_port(PORTS + 1)->sel_queued);
+	TEST_end();
+	for (br = 0; br < 2; br++) {
+		TEST_begin(br);
+		TEST_CHECK(STP_IN_port_delete(0, PORTS + 1) == STP_OK);
+		TEST_end();
+		test_worklist(br);
+	}
+	test_unchanged(PORTS, 60);
+
+	/* an Alternate Port goes */
+	TEST_unlink(1, PORTS);
+	TEST_begin(1);
+	TEST_CHECK(STP_IN_port_delete(0, PORTS) == STP_OK);
+	TEST_end();
+	test_unchanged(PORTS - 1, 60);
+}
+
+/* the port numbers, that need more than 8 bits of the Port Identifier */
+static const int test_port_ids[] = { 256, 769, 1000, UID_PORT_ID_MAX_NUMBER };
+
+static void test_read_back(int port_index, int priority)
+{
+	UID_STP_PORT_CFG_T cfg;
+	UID_STP_PORT_STATE_T state;
+
+	TEST_CHECK(STP_IN_port_get_cfg(0, port_index, &cfg) == STP_OK);
+	TEST_CHECK(cfg.port_priority == priority);
+
+	memset(&state, 0, sizeof(state));
+	state.port_no = port_index;
+	TEST_CHECK(STP_IN_port_get_state(0, &state) == STP_OK);
+	TEST_CHECK(UID_PORT_ID_PRIO(state.port_id) == priority);
+	TEST_CHECK(UID_PORT_ID_NUMBER(state.port_id) == port_index);
+}
+
+static void test_ids(void)
+{
+	UID_STP_PORT_CFG_T cfg;
+	register int iii, port_index;
+
+	TEST_bridge_create(2, 0, 32768);
+	TEST_begin(2);
+	for (iii = 0; iii < sizeof(test_port_ids) / sizeof(int); iii++) {
+		port_index = test_port_ids[iii];
+		TEST_CHECK(STP_IN_port_create(0, port_index) == STP_OK);
+		test_read_back(port_index, DEF_PORT_PRIO);
+
+		memset(&cfg, 0, sizeof(cfg));
+		cfg.field_mask = PT_CFG_PRIO;
+		cfg.port_priority = 16 * (iii + 1);
+		TEST_CHECK(STP_IN_set_port_cfg(0, port_index, &cfg) == STP_OK);
+		test_read_back(port_index, 16 * (iii + 1));
+	}
+
+	/* the highest priority and number: all the bits of the identifier */
+	cfg.port_priority = MAX_PORT_PRIO;
+	TEST_CHECK(STP_IN_set_port_cfg(0, UID_PORT_ID_MAX_NUMBER, &cfg) == STP_OK);
+	test_read_back(UID_PORT_ID_MAX_NUMBER, MAX_PORT_PRIO);
+
+	/* the port number does not fit in 12 bits */
+	TEST_CHECK(STP_IN_port_create(0, UID_PORT_ID_MAX_NUMBER + 1) != STP_OK);
+	TEST_CHECK(STP_IN_port_get_cfg(0, UID_PORT_ID_MAX_NUMBER + 1, &cfg) ==
+		   STP_Port_Is_Absent_In_The_Vlan);
+	TEST_CHECK(STP_IN_port_create(0, 0) != STP_OK);
+	TEST_end();
+}
+
+/* A non STP port stays queued for the role selection; deleted from a
+ * disabled bridge, that selects nothing after it, it has to leave the
+ * queue */
+static void test_disabled(void)
+{
+	UID_STP_CFG_T br_cfg;
+	UID_STP_PORT_CFG_T cfg;
+
+	TEST_bridge_create(3, 4, 32768);
+	TEST_begin(3);
+	memset(&br_cfg, 0, sizeof(br_cfg));
+	br_cfg.field_mask = BR_CFG_STATE;
+	br_cfg.stp_enabled = STP_DISABLED;
+	TEST_CHECK(STP_IN_stpm_set_cfg(0, NULL, &br_cfg) == STP_OK);
+	memset(&cfg, 0, sizeof(cfg));
+	cfg.field_mask = PT_CFG_NON_STP;
+	cfg.admin_non_stp = 1;
+	TEST_CHECK(STP_IN_set_port_cfg(0, 2, &cfg) == STP_OK);
+	TEST_CHECK(TEST_port(2)->sel_queued);
+	TEST_CHECK(STP_IN_port_delete(0, 2) == STP_OK);
+	TEST_end();
+	test_worklist(3);
+}
+
+int main(int argc, char **argv)
+{
+	test_add_remove();
+	test_ids();
+	test_disabled();
+	return TEST_result("test_port");
+}
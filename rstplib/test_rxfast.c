@@ -0,0 +1,261 @@
+/************************************************************************
+ * RSTP library - Rapid Spanning Tree (802.1D-2004)
+ *
+ * This file is part of RSTP library.
+ *
+ * RSTP library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; version 2.1
+ *
+ * RSTP library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with RSTP library; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **********************************************************************/
+
+/* The fast path for repeated BPDUs (STP_info_rx_repeated): two equal
+ * pairs of bridges, rx_fast on for the first, off for the second, get
+ * the same BPDUs on a Root, an Alternate and a Backup Port. The ports
+ * of both pairs must stay equal: roles, flags, timers and the states
+ * of their machines. BPDUs with TC, Proposal or a new priority vector
+ * take the full path. */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "test_to.h"
+
+#define PORTS		4
+#define ROUNDS		10
+
+/* bridge 1 of each pair: p1 Root, p2 Alternate, p3 Designated and
+ * p4 Backup on the loop p3 - p4 */
+#define ROOT_PORT	1
+#define ALT_PORT	2
+#define BACKUP_PORT	4
+
+static const int test_rx_fast[2] = { 1, 0 };
+
+typedef struct {
+	PORT_ROLE_T role;
+	PORT_ROLE_T selectedRole;
+	INFO_IS_T infoIs;
+	PORT_FLAGS_T flags;
+	PORT_TIMER_T timer[TIMERS_NUMBER];
+	unsigned int state[PORT_MACHINES_NUMBER];
+} TEST_SNAP_T;
+
+static void test_pair(int pair)
+{
+	UID_STP_CFG_T cfg;
+	int br = 2 * pair;
+
+	TEST_bridge_create(br, PORTS, 4096);
+	TEST_bridge_create(br + 1, PORTS, 32768);
+	memset(&cfg, 0, sizeof(cfg));
+	cfg.field_mask = BR_CFG_RX_FAST;
+	cfg.rx_fast = test_rx_fast[pair];
+	TEST_begin(br + 1);
+	TEST_CHECK(STP_IN_stpm_set_cfg(0, NULL, &cfg) == STP_OK);
+	TEST_end();
+
+	TEST_link(br, 1, br + 1, 1);
+	TEST_link(br, 2, br + 1, 2);
+	TEST_link(br + 1, 3, br + 1, 4);
+}
+
+static void test_snap(int pair, int port_index, TEST_SNAP_T *snap)
+{
+	register PORT_T *port;
+	register int iii;
+
+	memset(snap, 0, sizeof(*snap));
+	TEST_begin(2 * pair + 1);
+	port = TEST_port(port_index);
+	snap->role = port->role;
+	snap->selectedRole = port->selectedRole;
+	snap->infoIs = port->infoIs;
+	snap->flags = port->flags;
+	for (iii = 0; iii < TIMERS_NUMBER; iii++)
+		snap->timer[iii] = port->timer[iii * port->timer_stride];
+	for (iii = 0; iii < PORT_MACHINES_NUMBER; iii++)
+		snap->state[iii] = port->mach[iii].State;
+	TEST_end();
+}
+
+/* the ports of bridge 1 of both pairs are equal */
+static int test_equal(const char *what)
+{
+	TEST_SNAP_T fast, full;
+	register int port_index, diff = 0;
+
+	for (port_index = 1; port_index <= PORTS; port_index++) {
+		test_snap(0, port_index, &fast);
+		test_snap(1, port_index, &full);
+		if (memcmp(&fast, &full, sizeof(fast))) {
+			printf("%s: port %d differs: flags %llx %llx\n", what,
+			       port_index, fast.flags, full.flags);
+			diff++;
+		}
+	}
+	return !diff;
+}
+
+static unsigned long test_fast_cnt(int pair, int port_index)
+{
+	unsigned long cnt;
+
+	TEST_begin(2 * pair + 1);
+	cnt = TEST_port(port_index)->rx_fast_bpdu_cnt;
+	TEST_end();
+	return cnt;
+}
+
+/* the last BPDU, that gave the port designated information, with the
+ * flags 'set' set, 'clr' cleared and the root path cost 'cost_add'
+ * higher; fed to the port of both pairs */
+static void test_feed(int port_index, unsigned char set, unsigned char clr,
+		      int cost_add)
+{
+	BPDU_T bpdu;
+	register PORT_T *port;
+	register int pair;
+	unsigned long cost;
+
+	for (pair = 0; pair < 2; pair++) {
+		TEST_begin(2 * pair + 1);
+		port = TEST_port(port_index);
+		memset(&bpdu, 0, sizeof(bpdu));
+		memcpy(&bpdu.hdr, &port->rx_last_hdr, sizeof(bpdu.hdr));
+		memcpy(&bpdu.body, &port->rx_last_body, sizeof(bpdu.body));
+		bpdu.body.flags = (bpdu.body.flags | set) & ~clr;
+		if (cost_add) {
+			cost = ((unsigned long)bpdu.body.root_path_cost[0] << 24) |
+			       (bpdu.body.root_path_cost[1] << 16) |
+			       (bpdu.body.root_path_cost[2] << 8) |
+			       bpdu.body.root_path_cost[3];
+			cost += cost_add;
+			bpdu.body.root_path_cost[0] = cost >> 24;
+			bpdu.body.root_path_cost[1] = cost >> 16;
+			bpdu.body.root_path_cost[2] = cost >> 8;
+			bpdu.body.root_path_cost[3] = cost;
+		}
+		STP_IN_rx_bpdu(0, port_index, &bpdu, sizeof(bpdu));
+		TEST_end();
+	}
+}
+
+/* plain repeats: the fast path on the first pair, equal ports */
+static void test_repeats(int port_index)
+{
+	unsigned long before = test_fast_cnt(0, port_index);
+	register int round;
+
+	TEST_begin(1);
+	TEST_CHECK(TEST_port(port_index)->rx_last_valid);
+	TEST_end();
+	for (round = 0; round < ROUNDS; round++) {
+		test_feed(port_index, 0, 0, 0);
+		TEST_CHECK(test_equal("repeat"));
+		TEST_run(1);
+		TEST_CHECK(test_equal("repeat, tick"));
+	}
+	TEST_CHECK(test_fast_cnt(0, port_index) >= before + ROUNDS);
+	TEST_CHECK(test_fast_cnt(1, port_index) == 0);
+}
+
+/* a changed BPDU takes the full path; its repeat too, if it has TC or
+ * Proposal, or gave no designated information */
+static void test_changed(int port_index, unsigned char set, unsigned char clr,
+			 int cost_add)
+{
+	unsigned long before = test_fast_cnt(0, port_index);
+	Bool valid;
+
+	test_feed(port_index, set, clr, cost_add);
+	TEST_CHECK(test_fast_cnt(0, port_index) == before);
+	TEST_CHECK(test_equal("changed"));
+
+	TEST_begin(1);
+	valid = TEST_port(port_index)->rx_last_valid;
+	TEST_end();
+	test_feed(port_index, 0, 0, 0);
+	if (!valid || (set & (TOPOLOGY_CHANGE_BIT | PROPOSAL_BIT))) {
+		TEST_CHECK(test_fast_cnt(0, port_index) == before);
+	} else {
+		TEST_CHECK(test_fast_cnt(0, port_index) == before + 1);
+	}
+	TEST_CHECK(test_equal("changed, repeat"));
+	TEST_run(1);
+	TEST_CHECK(test_equal("changed, tick"));
+}
+
+/* The Root Port goes down, the Alternate Port takes over, when the
+ * information of the Root Port ages out: repeats on it each second,
+ * before and after its new role */
+static void test_unsettled(void)
+{
+	register int round, pair;
+
+	for (pair = 0; pair < 2; pair++)
+		TEST_unlink(2 * pair, ROOT_PORT);
+	for (round = 0; round < 2 * ROUNDS; round++) {
+		test_feed(ALT_PORT, 0, 0, 0);
+		TEST_CHECK(test_equal("unsettled"));
+		TEST_run(1);
+		TEST_CHECK(test_equal("unsettled, tick"));
+	}
+	TEST_begin(1);
+	TEST_CHECK(TEST_port(ALT_PORT)->role == RootPort);
+	TEST_end();
+}
+
+int main(int argc, char **argv)
+{
+	PORT_ROLE_T role;
+
+	test_pair(0);
+	test_pair(1);
+	TEST_run(60);
+
+	TEST_begin(1);
+	role = TEST_port(ROOT_PORT)->role;
+	TEST_CHECK(role == RootPort);
+	role = TEST_port(ALT_PORT)->role;
+	TEST_CHECK(role == AlternatePort);
+	role = TEST_port(BACKUP_PORT)->role;
+	TEST_CHECK(role == BackupPort);
+	TEST_end();
+	TEST_CHECK(test_equal("converged"));
+
+	/* the Designated Ports of the root send Agreement: it is in the
+	 * repeats, see STP_info_rx_repeated, why they take the fast path */
+	TEST_begin(1);
+	TEST_CHECK(TEST_port(ROOT_PORT)->rx_last_body.flags & AGREEMENT_BIT);
+	TEST_end();
+
+	test_repeats(ROOT_PORT);
+	test_repeats(ALT_PORT);
+	test_repeats(BACKUP_PORT);
+
+	/* without Agreement: the repeats of that are fast too */
+	test_changed(ROOT_PORT, 0, AGREEMENT_BIT, 0);
+	test_changed(ALT_PORT, 0, AGREEMENT_BIT, 0);
+	test_repeats(ROOT_PORT);
+
+	test_changed(ROOT_PORT, TOPOLOGY_CHANGE_BIT, 0, 0);
+	test_changed(ALT_PORT, PROPOSAL_BIT, 0, 0);
+	test_changed(BACKUP_PORT, TOPOLOGY_CHANGE_BIT, 0, 0);
+	test_changed(ALT_PORT, 0, 0, 1);	/* new priority vector */
+	TEST_run(30);
+	TEST_CHECK(test_equal("settled"));
+
+	test_unsettled();
+
+	return TEST_result("test_rxfast");
+}
@@ -0,0 +1,81 @@
+/************************************************************************
+ * RSTP library - Rapid Spanning Tree (802.1D-2004)
+ *
+ * This file is part of RSTP library.
+ *
+ * RSTP library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; version 2.1
+ *
+ * RSTP library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with RSTP library; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **********************************************************************/
+
+/* STP_stpm_one_second: the timers, that the Port Role Transitions
+ * machine holds at a full value in a state (rrWhile of a Root Port,
+ * fdWhile of an Alternate Port, rbWhile of a Backup Port), stay full
+ * across the ticks of a settled bridge. */
+
+#include <stdio.h>
+
+#include "test_to.h"
+
+/* bridge 1: port 1 is its Root Port, port 2 an Alternate one; its
+ * ports 3 and 4 are on one LAN, port 4 is the Backup Port */
+static void test_held_timers(void)
+{
+	register STPM_T *stpm;
+	register PORT_T *root, *alt, *backup;
+	register int sec;
+
+	TEST_bridge_create(0, 4, 4096);
+	TEST_bridge_create(1, 4, 32768);
+	TEST_link(0, 1, 1, 1);
+	TEST_link(0, 2, 1, 2);
+	TEST_link(1, 3, 1, 4);
+	TEST_run(60);
+
+	TEST_begin(1);
+	stpm = STP_stpm_get_the_list();
+	root = TEST_port(1);
+	alt = TEST_port(2);
+	backup = TEST_port(4);
+	TEST_CHECK(root->role == RootPort);
+	TEST_CHECK(alt->role == AlternatePort);
+	TEST_CHECK(backup->role == BackupPort);
+	TEST_end();
+
+	for (sec = 0; sec < 3 * stpm->rootTimes.ForwardDelay; sec++) {
+		/* checked right after the tick: the BPDUs of bridge 0
+		 * would restart them as well */
+		TEST_begin(1);
+		STP_IN_one_second();
+		TEST_CHECK(PORT_TIMER(root, rrWhile) ==
+			   stpm->rootTimes.ForwardDelay);
+		TEST_CHECK(PORT_TIMER(alt, fdWhile) ==
+			   stpm->rootTimes.ForwardDelay);
+		TEST_CHECK(PORT_TIMER(backup, fdWhile) ==
+			   stpm->rootTimes.ForwardDelay);
+		TEST_CHECK(PORT_TIMER(backup, rbWhile) ==
+			   2 * stpm->rootTimes.HelloTime);
+		TEST_end();
+
+		TEST_begin(0);
+		STP_IN_one_second();
+		TEST_end();
+		TEST_deliver();
+	}
+}
+
+int main(int argc, char **argv)
+{
+	test_held_timers();
+	return TEST_result("test_tick");
+}
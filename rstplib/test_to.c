@@ -0,0 +1,282 @@
+/************************************************************************
+ * RSTP library - Rapid Spanning Tree (802.1D-2004)
+ *
+ * This file is part of RSTP library.
+ *
+ * RSTP library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; version 2.1
+ *
+ * RSTP library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with RSTP library; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **********************************************************************/
+
+/* stp_to API for the tests (see test_to.h) */
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
+#include "test_to.h"
+
+#define TEST_QUEUE_SIZE	8192
+
+typedef struct {
+	int br;
+	int port;
+	size_t len;
+	unsigned char pkt[sizeof(MAC_HEADER_T) + sizeof(BPDU_T)];
+} TEST_FRAME_T;
+
+int TEST_failed = 0;
+unsigned long TEST_flush_calls = 0;
+unsigned long TEST_flushed_ports = 0;
+
+static struct stp_instance *test_instance[TEST_BRIDGES];
+static int test_cur = -1;
+/* peer (bridge, port) of a linked port, peer_br < 0 if not linked */
+static int test_peer_br[TEST_BRIDGES][TEST_PORTS + 1];
+static int test_peer_port[TEST_BRIDGES][TEST_PORTS + 1];
+static TEST_FRAME_T test_queue[TEST_QUEUE_SIZE];
+static int test_queued = 0;
+
+void stp_trace(const char *format, ...)
+{
+	va_list args;
+
+	va_start(args, format);
+	vprintf(format, args);
+	printf("\n");
+	va_end(args);
+}
+
+int STP_OUT_flush_lt(int port_index, int vlan_id,
+		     LT_FLASH_TYPE_T type, char *reason)
+{
+	return STP_OK;
+}
+
+int STP_OUT_flush_ports(int vlan_id, BITMAP_T *ports, char *reason)
+{
+	register int iii;
+
+	TEST_flush_calls++;
+	for (iii = 0; iii < BITMAP_BITS; iii++) {
+		if (BitmapGetBit(ports, iii))
+			TEST_flushed_ports++;
+	}
+	return STP_OK;
+}
+
+void STP_OUT_get_port_mac(int port_index, unsigned char *mac)
+{
+	mac[0] = 0x02;
+	mac[1] = 0;
+	mac[2] = 0;
+	mac[3] = test_cur;
+	mac[4] = port_index >> 8;
+	mac[5] = port_index & 0xff;
+}
+
+unsigned long STP_OUT_get_port_oper_speed(unsigned int port_index)
+{
+	return 1000L;
+}
+
+int STP_OUT_get_port_link_status(int port_index)
+{
+	return test_peer_br[test_cur][port_index] >= 0;
+}
+
+int STP_OUT_get_duplex(int port_index)
+{
+	return 1;
+}
+
+int STP_OUT_set_learning(int port_index, int vlan_id, int enable)
+{
+	return STP_OK;
+}
+
+int STP_OUT_set_forwarding(int port_index, int vlan_id, int enable)
+{
+	return STP_OK;
+}
+
+int STP_OUT_set_hardware_mode(int vlan_id, UID_STP_MODE_T mode)
+{
+	return STP_OK;
+}
+
+int STP_OUT_tx_bpdu(int port_index, int vlan_id,
+		    unsigned char *bpdu, size_t bpdu_len)
+{
+	register TEST_FRAME_T *frame;
+	size_t len = bpdu_len + sizeof(MAC_HEADER_T) + sizeof(ETH_HEADER_T);
+
+	if (test_peer_br[test_cur][port_index] < 0)
+		return STP_OK;
+	if (test_queued == TEST_QUEUE_SIZE || len > sizeof(frame->pkt)) {
+		TEST_failed++;
+		printf("BPDU of port %d lost\n", port_index);
+		return STP_OK;
+	}
+	frame = test_queue + test_queued++;
+	frame->br = test_peer_br[test_cur][port_index];
+	frame->port = test_peer_port[test_cur][port_index];
+	frame->len = len;
+	memcpy(frame->pkt, bpdu, len);
+	return STP_OK;
+}
+
+const char *STP_OUT_get_port_name(int port_index)
+{
+	static char name[16];
+
+	snprintf(name, sizeof(name), "p%d", port_index);
+	return name;
+}
+
+int STP_OUT_get_init_stpm_cfg(int vlan_id, UID_STP_CFG_T *cfg)
+{
+	cfg->bridge_priority = DEF_BR_PRIO;
+	cfg->max_age = DEF_BR_MAXAGE;
+	cfg->hello_time = DEF_BR_HELLOT;
+	cfg->forward_delay = DEF_BR_FWDELAY;
+	cfg->force_version = NORMAL_RSTP;
+	return STP_OK;
+}
+
+int STP_OUT_get_init_port_cfg(int vlan_id, int port_index,
+			      UID_STP_PORT_CFG_T *cfg)
+{
+	cfg->port_priority = DEF_PORT_PRIO;
+	cfg->admin_non_stp = DEF_ADMIN_NON_STP;
+	cfg->admin_edge = False;
+	cfg->admin_port_path_cost = ADMIN_PORT_PATH_COST_AUTO;
+	cfg->admin_point2point = DEF_P2P;
+	return STP_OK;
+}
+
+void TEST_begin(int br)
+{
+	test_cur = br;
+	STP_IN_instance_begin(test_instance[br]);
+}
+
+void TEST_end(void)
+{
+	STP_IN_instance_end(test_instance[test_cur]);
+	test_cur = -1;
+}
+
+void TEST_bridge_create(int br, int ports, int priority)
+{
+	UID_STP_CFG_T cfg;
+	BITMAP_T bmp;
+	register int iii;
+
+	for (iii = 0; iii <= TEST_PORTS; iii++)
+		test_peer_br[br][iii] = -1;
+
+	test_instance[br] = STP_IN_instance_create();
+	TEST_begin(br);
+	STP_IN_init(TEST_PORTS);
+	BitmapClear(&bmp);
+	for (iii = 0; iii < ports; iii++)
+		BitmapSetBit(&bmp, iii);
+	TEST_CHECK(STP_IN_stpm_create(0, "br", &bmp) == STP_OK);
+
+	memset(&cfg, 0, sizeof(cfg));
+	cfg.field_mask = BR_CFG_STATE | BR_CFG_PRIO;
+	cfg.stp_enabled = STP_ENABLED;
+	cfg.bridge_priority = priority;
+	TEST_CHECK(STP_IN_stpm_set_cfg(0, NULL, &cfg) == STP_OK);
+	TEST_end();
+}
+
+static void test_enable(int br, int port)
+{
+	TEST_begin(br);
+	STP_IN_enable_port(port, True);
+	TEST_end();
+}
+
+void TEST_link(int br, int port, int peer, int peer_port)
+{
+	test_peer_br[br][port] = peer;
+	test_peer_port[br][port] = peer_port;
+	test_peer_br[peer][peer_port] = br;
+	test_peer_port[peer][peer_port] = port;
+	test_enable(br, port);
+	test_enable(peer, peer_port);
+}
+
+void TEST_unlink(int br, int port)
+{
+	int peer = test_peer_br[br][port];
+	int peer_port = test_peer_port[br][port];
+
+	test_peer_br[br][port] = -1;
+	test_peer_br[peer][peer_port] = -1;
+}
+
+void TEST_deliver(void)
+{
+	static TEST_FRAME_T frames[TEST_QUEUE_SIZE];
+	register int iii, num;
+
+	while (test_queued) {
+		num = test_queued;
+		memcpy(frames, test_queue, num * sizeof(TEST_FRAME_T));
+		test_queued = 0;
+		for (iii = 0; iii < num; iii++) {
+			TEST_begin(frames[iii].br);
+			STP_IN_rx_bpdu(0, frames[iii].port,
+				       (BPDU_T *)(frames[iii].pkt +
+						  sizeof(MAC_HEADER_T)),
+				       frames[iii].len - sizeof(MAC_HEADER_T));
+			TEST_end();
+		}
+	}
+}
+
+void TEST_run(int seconds)
+{
+	register int br;
+
+	while (seconds-- > 0) {
+		for (br = 0; br < TEST_BRIDGES; br++) {
+			if (!test_instance[br])
+				continue;
+			TEST_begin(br);
+			STP_IN_one_second();
+			TEST_end();
+		}
+		TEST_deliver();
+	}
+}
+
+PORT_T *TEST_port(int port_index)
+{
+	register PORT_T *port;
+
+	for (port = STP_stpm_get_the_list()->ports; port; port = port->next) {
+		if (port->port_index == port_index)
+			return port;
+	}
+	return NULL;
+}
+
+int TEST_result(const char *name)
+{
+	printf("%s: %s\n", name, TEST_failed ? "FAILED" : "passed");
+	return TEST_failed ? 1 : 0;
+}
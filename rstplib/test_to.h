@@ -0,0 +1,80 @@
+/************************************************************************
+ * RSTP library - Rapid Spanning Tree (802.1D-2004)
+ *
+ * This file is part of RSTP library.
+ *
+ * RSTP library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; version 2.1
+ *
+ * RSTP library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with RSTP library; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **********************************************************************/
+
+/* The stp_to API for the tests of 'make check' (see stp_to.h): the
+ * bridges of a test live in one process, their BPDUs are queued and
+ * delivered by TEST_deliver, the fdb flushes are only counted. */
+
+#ifndef _TEST_TO_H__
+#define _TEST_TO_H__
+
+#include "base.h"
+#include "stpm.h"
+#include "stp_in.h"
+#include "stp_to.h"
+
+#define TEST_BRIDGES	4
+#define TEST_PORTS	UID_PORT_ID_MAX_NUMBER
+
+/* a failed check is reported and counted, the test goes on */
+#define TEST_CHECK(COND)						\
+	do {								\
+		if (!(COND)) {						\
+			TEST_failed++;					\
+			printf("%s:%d: FAILED: %s\n",			\
+			       __FILE__, __LINE__, #COND);		\
+		}							\
+	} while (0)
+
+extern int TEST_failed;
+
+/* STP_OUT_flush_ports calls and flushed ports, of all the bridges */
+extern unsigned long TEST_flush_calls;
+extern unsigned long TEST_flushed_ports;
+
+/* Creates the bridge 'br' with the ports [1, ports], not linked yet,
+ * and enables STP on it. The lower 'priority' wins the root. */
+void TEST_bridge_create(int br, int ports, int priority);
+
+/* The bridge, that the STP_IN calls go to */
+void TEST_begin(int br);
+void TEST_end(void);
+
+/* Links the port 'port' of 'br' to the port 'peer_port' of 'peer'
+ * (both go up), 'peer' may be 'br' itself */
+void TEST_link(int br, int port, int peer, int peer_port);
+
+/* Takes the link of the port 'port' of 'br' down: the BPDUs stop,
+ * the received information ages out */
+void TEST_unlink(int br, int port);
+
+/* Delivers the queued BPDUs, until there are no more */
+void TEST_deliver(void);
+
+/* 'seconds' times: one second of every bridge, then BPDUs delivered */
+void TEST_run(int seconds);
+
+/* The port of the current bridge */
+PORT_T *TEST_port(int port_index);
+
+/* 0 if all the checks passed, else 1 (for main) */
+int TEST_result(const char *name);
+
+#endif /* _TEST_TO_H__ */
@@ -0,0 +1,207 @@
+/************************************************************************
+ * RSTP library - Rapid Spanning Tree (802.1D-2004)
+ *
+ * This file is part of RSTP library.
+ *
+ * RSTP library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; version 2.1
+ *
+ * RSTP library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with RSTP library; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ **********************************************************************/
+
+/* The packed priority vectors (vector.c) against a field by field
+ * model of 17.6: STP_VECT_compare_vector and STP_VECT_compare_bridge_id
+ * give the sign of the model for every pair of vectors, built from the
+ * edge values of each field; the fields read back as they were given. */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "test_to.h"
+
+#define EDGES		5	/* values of each field */
+#define FIELDS		7
+
+typedef struct {
+	BRIDGE_ID root_bridge;
+	unsigned long root_path_cost;
+	BRIDGE_ID design_bridge;
+	PORT_ID design_port;
+	PORT_ID bridge_port;
+} TEST_VECTOR_T;
+
+static const unsigned short prio_edges[EDGES] = {
+	0, 1, 0x7fff, 0x8000, 0xffff
+};
+
+static const unsigned char addr_edges[EDGES][6] = {
+	{0x00, 0x00, 0x00, 0x00, 0x00, 0x00},
+	{0x00, 0x00, 0x00, 0x00, 0x00, 0x01},
+	{0x7f, 0xff, 0xff, 0xff, 0xff, 0xff},
+	{0x80, 0x00, 0x00, 0x00, 0x00, 0x00},
+	{0xff, 0xff, 0xff, 0xff, 0xff, 0xff}
+};
+
+static const unsigned long cost_edges[EDGES] = {
+	0, 1, 0x7fffffffUL, 0x80000000UL, 0xffffffffUL
+};
+
+static const PORT_ID port_edges[EDGES] = {
+	0, 1, 0x7fff, 0x8000, 0xffff
+};
+
+static int test_sign(long diff)
+{
+	return (diff > 0) - (diff < 0);
+}
+
+static int test_cmp_bridge(BRIDGE_ID *b1, BRIDGE_ID *b2)
+{
+	if (b1->prio != b2->prio)
+		return test_sign((long)b1->prio - (long)b2->prio);
+	return test_sign(memcmp(b1->addr, b2->addr, 6));
+}
+
+/* 17.6: the first field, that differs, decides */
+static int test_cmp_vector(TEST_VECTOR_T *v1, TEST_VECTOR_T *v2)
+{
+	int cmp;
+
+	if ((cmp = test_cmp_bridge(&v1->root_bridge, &v2->root_bridge)))
+		return cmp;
+	if (v1->root_path_cost != v2->root_path_cost)
+		return v1->root_path_cost < v2->root_path_cost ? -1 : 1;
+	if ((cmp = test_cmp_bridge(&v1->design_bridge, &v2->design_bridge)))
+		return cmp;
+	if (v1->design_port != v2->design_port)
+		return test_sign((long)v1->design_port - (long)v2->design_port);
+	return test_sign((long)v1->bridge_port - (long)v2->bridge_port);
+}
+
+/* the fields take the edge values digit[field] */
+static void test_fill(TEST_VECTOR_T *v, int *digit)
+{
+	v->root_bridge.prio = prio_edges[digit[0]];
+	memcpy(v->root_bridge.addr, addr_edges[digit[1]], 6);
+	v->root_path_cost = cost_edges[digit[2]];
+	v->design_bridge.prio = prio_edges[digit[3]];
+	memcpy(v->design_bridge.addr, addr_edges[digit[4]], 6);
+	v->design_port = port_edges[digit[5]];
+	v->bridge_port = port_edges[digit[6]];
+}
+
+static void test_pack(TEST_VECTOR_T *t, PRIO_VECTOR_T *v)
+{
+	STP_VECT_create(v, &t->root_bridge, t->root_path_cost,
+			&t->design_bridge, t->design_port, t->bridge_port);
+}
+
+static void test_read_back(TEST_VECTOR_T *t, PRIO_VECTOR_T *v)
+{
+	BRIDGE_ID br_id;
+	BPDU_BODY_T body;
+	PRIO_VECTOR_T back;
+
+	STP_VECT_get_root_bridge(v, &br_id);
+	TEST_CHECK(!test_cmp_bridge(&br_id, &t->root_bridge));
+	STP_VECT_get_design_bridge(v, &br_id);
+	TEST_CHECK(!test_cmp_bridge(&br_id, &t->design_bridge));
+	TEST_CHECK(STP_VECT_ROOT_PATH_COST(v) == t->root_path_cost);
+	TEST_CHECK(STP_VECT_DESIGN_PORT(v) == t->design_port);
+	TEST_CHECK(STP_VECT_BRIDGE_PORT(v) == t->bridge_port);
+
+	/* through a BPDU: the bridge port is not in it, it is kept */
+	STP_VECT_set_vector(v, &body);
+	back.key[2] = t->bridge_port;
+	STP_VECT_get_vector(&body, &back);
+	TEST_CHECK(!memcmp(&back, v, sizeof(back)));
+}
+
+/* All pairs of the vectors, whose fields take 'edges' of the edge
+ * values, starting at 'offset' */
+static void test_pairs(int edges, int offset)
+{
+	static TEST_VECTOR_T model[EDGES * EDGES * EDGES * EDGES *
+				   EDGES * EDGES * EDGES];
+	static PRIO_VECTOR_T packed[EDGES * EDGES * EDGES * EDGES *
+				    EDGES * EDGES * EDGES];
+	int digit[FIELDS];
+	register int iii, jjj, field, num = 1;
+	int cmp;
+
+	for (iii = 0; iii < FIELDS; iii++)
+		num *= edges;
+	for (iii = 0; iii < num; iii++) {
+		/* the digits of iii in base 'edges' */
+		for (field = 0, jjj = iii; field < FIELDS; field++, jjj /= edges)
+			digit[field] = jjj % edges + offset;
+		test_fill(model + iii, digit);
+		test_pack(model + iii, packed + iii);
+		test_read_back(model + iii, packed + iii);
+	}
+	for (iii = 0; iii < num; iii++) {
+		for (jjj = 0; jjj < num; jjj++) {
+			cmp = test_cmp_vector(model + iii, model + jjj);
+			if (test_sign(STP_VECT_compare_vector(packed + iii,
+							      packed + jjj))
+			    != cmp) {
+				TEST_failed++;
+				printf("vectors %d, %d: expected %d\n",
+				       iii, jjj, cmp);
+			}
+		}
+	}
+}
+
+/* every pair of edge values in each field, the other fields equal */
+static void test_fields(void)
+{
+	TEST_VECTOR_T m1, m2;
+	PRIO_VECTOR_T p1, p2;
+	int digit[FIELDS];
+	register int field, iii, jjj, base;
+	int cmp;
+
+	for (field = 0; field < FIELDS; field++) {
+		for (base = 0; base < EDGES; base++) {
+			for (iii = 0; iii < FIELDS; iii++)
+				digit[iii] = base;
+			for (iii = 0; iii < EDGES; iii++) {
+				for (jjj = 0; jjj < EDGES; jjj++) {
+					digit[field] = iii;
+					test_fill(&m1, digit);
+					digit[field] = jjj;
+					test_fill(&m2, digit);
+					test_pack(&m1, &p1);
+					test_pack(&m2, &p2);
+					cmp = STP_VECT_compare_vector(&p1, &p2);
+					TEST_CHECK(test_sign(cmp) ==
+						   test_cmp_vector(&m1, &m2));
+					cmp = STP_VECT_compare_bridge_id(
+						&m1.design_bridge,
+						&m2.design_bridge);
+					TEST_CHECK(test_sign(cmp) ==
+						   test_cmp_bridge(&m1.design_bridge,
+								   &m2.design_bridge));
+				}
+			}
+		}
+	}
+}
+
+int main(int argc, char **argv)
+{
+	test_fields();
+	test_pairs(3, 0);	/* 0, 1, 0x7fff... */
+	test_pairs(3, 2);	/* 0x7fff..., 0x8000..., 0xff... */
+	return TEST_result("test_vector");
+}
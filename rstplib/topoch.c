@@ -24,7 +24,6 @@
   
 #include "base.h"
 #include "stpm.h"
-#include "stp_to.h" /* for STP_OUT_flush_lt */
 
 #define STATES { \
 	CHOOSE(INACTIVE),	\
@@ -40,56 +39,39 @@
 #define GET_STATE_NAME STP_topoch_get_state_name
 #include "choose.h"
 
-/* We can flush learned fdb by port, so set this in stpm.c and topoch.c  */
-/* This doesn't seem to solve the topology change problems. Don't use it yet */
-//#define STRONGLY_SPEC_802_1W
+/* tcProp is not a flag of the port: the bridge counts setTcPropTree
+ * calls, the port has tcProp until it has seen the last of them */
+#define TC_PROP(port)	((port)->tc_prop_seen != (port)->owner->tc_prop_epoch)
+#define TC_PROP_CLR(port) ((port)->tc_prop_seen = (port)->owner->tc_prop_epoch)
 
-#ifndef STRONGLY_SPEC_802_1W
-/* 
- * In many kinds of hardware the function
- * STP_OUT_flush_lt is a) is very hard and b) cannot
- * delete learning emtries per port. The alternate
- * method may be used: we don't care operEdge flag here,
- * but clean learning table once for TopologyChange
- * for all ports, except the received port. I am ready to discuss :(
- * See below word STRONGLY_SPEC_802_1W
- */
-#else
-static Bool flush(STATE_MACH_T *this, char *reason) /* 17.19.9 */
-{
-	register PORT_T* port = this->owner.port;
-	Bool bret;
+/* rcvdTc || rcvdTcn || rcvdTcAck */
+#define TC_RECEIVED	(PORT_FLAG(rcvdTc) | PORT_FLAG(rcvdTcn) |	\
+			 PORT_FLAG(rcvdTcAck))
+/* ... || tcProp */
+#define TC_RECEIVED_ANY(port)	\
+	(PORT_ANY_FLAGS(port, TC_RECEIVED) || TC_PROP(port))
 
-	if (port->operEdge) {
-		return True;
-	}
-	if (this->debug) {
-		stp_trace("%s (%s, %s, %s, '%s')",
-			  "flush", port->port_name, port->owner->name,
-			  "this port",
-			  reason);
-	}
-
-	bret = STP_OUT_flush_lt(port->port_index, port->owner->vlan_id,
-				LT_FLASH_ONLY_THE_PORT, reason);
-	return bret;
-}
-#endif
+/* fdbFlush (17.19.7) is not flushed here port by port: see
+ * STP_stpm_flush_port, the bridge flushes its ports as one set */
 
 /*! \function static void setTcPropTree(STATE_MACH_T *this)
  *  \brief Implements 17.21.18
- *  Sets tcprop for all Ports except the Port that called the procedure.
+ *  Sets tcprop for all Ports except the Port that called the procedure:
+ *  a new epoch, that the calling Port has seen already, unless it had
+ *  tcProp before. The Ports are checked once, see STP_stpm_update.
  */
 static void setTcPropTree(STATE_MACH_T *this)
 {
 	register PORT_T* port = this->owner.port;
-	register PORT_T* tmp;
+	register STPM_T* stpm = port->owner;
+	Bool had_tc_prop = TC_PROP(port);
 
-	for (tmp = port->owner->ports; tmp; tmp = tmp->next) {
-		if (tmp->port_index != port->port_index) {
-			tmp->tcProp = True;
-		}
+	stpm->tc_prop_epoch++;
+	if (!had_tc_prop) {
+		port->tc_prop_seen = stpm->tc_prop_epoch;
 	}
+	stpm->tree_mark = True;
+	stpm->dirty = True;
 }
 
 /*! \function static unsigned int newTcWhile(STATE_MACH_T *this)
@@ -105,12 +87,12 @@ static void newTcWhile(STATE_MACH_T *this)
 {
 	register PORT_T* port = this->owner.port;
 
-	if (!port->tcWhile && port->sendRSTP) {
-		port->tcWhile = port->designatedTimes.HelloTime + 1;
-		port->newInfo = True;
+	if (!PORT_TIMER(port, tcWhile) && PORT_GET(port, sendRSTP)) {
+		PORT_TIMER(port, tcWhile) = port->designatedTimes.HelloTime + 1;
+		PORT_SET(port, newInfo);
 	}
-	if (!port->tcWhile && !port->sendRSTP) {
-		port->tcWhile = port->owner->rootTimes.MaxAge +
+	if (!PORT_TIMER(port, tcWhile) && !PORT_GET(port, sendRSTP)) {
+		PORT_TIMER(port, tcWhile) = port->owner->rootTimes.MaxAge +
 				port->owner->rootTimes.ForwardDelay;
 	}
 }
@@ -122,62 +104,55 @@ void STP_topoch_enter_state (STATE_MACH_T *this)
 	switch (this->State) {
 		case BEGIN:
 		case INACTIVE:
-			port->fbdFlush = True;
-			port->tcWhile = 0;
-			port->tcAck = False;
+			STP_stpm_flush_port(port);
+			PORT_TIMER(port, tcWhile) = 0;
+			PORT_CLR(port, tcAck);
 			break;
 		case LEARNING:
-			port->rcvdTc = port->rcvdTcn = port->rcvdTcAck = False;
-			port->tcProp = False;
+			PORT_CLR_FLAGS(port, TC_RECEIVED);
+			TC_PROP_CLR(port);
 			break;
 		case DETECTED:
 			newTcWhile(this);
-#ifdef STP_DBG
-			if (this->debug)
+			if (STP_TRACING(this))
 				stp_trace("DETECTED: tcWhile=%d on port %s",
-					  port->tcWhile, port->port_name);
-#endif
+					  PORT_TIMER(port, tcWhile), port->port_name);
 			setTcPropTree(this);
-			port->newInfo = True;
+			PORT_SET(port, newInfo);
 			break;
 		case ACTIVE:
 			break;
 		case ACKNOWLEDGED:
-			port->tcWhile = 0;
-#ifdef STP_DBG
-			if (this->debug) {
+			PORT_TIMER(port, tcWhile) = 0;
+			if (STP_TRACING(this)) {
 				stp_trace("ACKNOWLEDGED: tcWhile=%d on port %s",
-					  port->tcWhile, port->port_name);
+					  PORT_TIMER(port, tcWhile), port->port_name);
 			}
-#endif
-			port->rcvdTcAck = False;
+			PORT_CLR(port, rcvdTcAck);
 			break;
 		case PROPAGATING:
 			newTcWhile(this);
-			port->fbdFlush = True;
-#ifdef STP_DBG
-			if (this->debug) {
+			STP_stpm_flush_port(port);
+			if (STP_TRACING(this)) {
 				stp_trace("PROPAGATING: tcWhile=%d on port %s",
-					  port->tcWhile, port->port_name);
+					  PORT_TIMER(port, tcWhile), port->port_name);
 			}
-#endif
-			port->tcProp = False;
+			TC_PROP_CLR(port);
 			break;
 		case NOTIFIED_TC:
-			port->rcvdTcn = port->rcvdTc = False;
+			PORT_CLR_FLAGS(port, PORT_FLAG(rcvdTcn) |
+					     PORT_FLAG(rcvdTc));
 			if (port->role == DesignatedPort) {
-				port->tcAck = True;
+				PORT_SET(port, tcAck);
 			}
 			setTcPropTree(this);
 			break;
 		case NOTIFIED_TCN:
 			newTcWhile (this);
-#ifdef STP_DBG
-			if (this->debug) {
+			if (STP_TRACING(this)) {
 				stp_trace("NOTIFIED_TCN: tcWhile=%d on port %s",
-					  port->tcWhile, port->port_name);
+					  PORT_TIMER(port, tcWhile), port->port_name);
 			}
-#endif
 			break;
 	};
 }
@@ -192,39 +167,44 @@ Bool STP_topoch_check_conditions (STATE_MACH_T *this)
 
 	switch (this->State) {
 		case INACTIVE:
-			if (port->learn && !port->fbdFlush) {
+			if (PORT_GET(port, learn) &&
+			    !PORT_GET(port, fbdFlush)) {
 				return STP_hop_2_state(this, LEARNING);
 			}
 			break;
 		case LEARNING:
 			if (((port->role == RootPort) || (port->role == DesignatedPort)) &&
-			    port->forward && !port->operEdge) {
+			    PORT_GET(port, forward) &&
+			    !PORT_GET(port, operEdge)) {
 				return STP_hop_2_state(this, DETECTED);
 			}
 			if ((port->role != RootPort) && (port->role != DesignatedPort) &&
-			    !(port->learn || port->learning) &&
-			    !(port->rcvdTc || port->rcvdTcn || port->rcvdTcAck || port->tcProp)) {
+			    !PORT_ANY_FLAGS(port, PORT_FLAG(learn) |
+						  PORT_FLAG(learning) |
+						  TC_RECEIVED) &&
+			    !TC_PROP(port)) {
 				return STP_hop_2_state(this, INACTIVE);
 			}
-			if (port->rcvdTc || port->rcvdTcn || port->rcvdTcAck || port->tcProp) {
+			if (TC_RECEIVED_ANY(port)) {
 				return STP_hop_2_state(this, LEARNING);
 			}
 			break;
 		case ACTIVE:
 			if (((port->role != RootPort) && (port->role != DesignatedPort)) ||
-			    port->operEdge) {
+			    PORT_GET(port, operEdge)) {
 				return STP_hop_2_state(this, LEARNING);
 			}
-			if (port->rcvdTcn) {
+			if (PORT_GET(port, rcvdTcn)) {
 				return STP_hop_2_state(this, NOTIFIED_TCN);
 			}
-			if (port->rcvdTc) {
+			if (PORT_GET(port, rcvdTc)) {
 				return STP_hop_2_state(this, NOTIFIED_TC);
 			}
-			if (port->tcProp && !port->operEdge) {
+			if (TC_PROP(port) &&
+			    !PORT_GET(port, operEdge)) {
 				return STP_hop_2_state(this, PROPAGATING);
 			}
-			if (port->rcvdTcAck) {
+			if (PORT_GET(port, rcvdTcAck)) {
 				return STP_hop_2_state(this, ACKNOWLEDGED);
 			}
 			break;
@@ -232,6 +212,7 @@ Bool STP_topoch_check_conditions (STATE_MACH_T *this)
 		case ACKNOWLEDGED:
 		case PROPAGATING:
 		case NOTIFIED_TC:
+			return STP_hop_2_state (this, ACTIVE);
 		case NOTIFIED_TCN:
 			return STP_hop_2_state (this, NOTIFIED_TC);
 	};
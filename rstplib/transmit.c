@@ -131,7 +131,7 @@ static int txTcn(STATE_MACH_T *this)
 	}
 #endif
 
-	if (this->owner.port->admin_non_stp) {
+	if (PORT_GET(this->owner.port, admin_non_stp)) {
 		return 1;
 	}
 	port_index = this->owner.port->port_index;
@@ -140,11 +140,9 @@ static int txTcn(STATE_MACH_T *this)
 	pkt_len = build_bpdu_header(port_index, BPDU_TOPO_CHANGE_TYPE,
 				    sizeof (BPDU_HEADER_T));
 
-#ifdef STP_DBG
-	if (this->debug) {
+	if (STP_TRACING(this)) {
 		stp_trace ("port %s txTcn", this->owner.port->port_name);
 	}
-#endif
 	return STP_OUT_tx_bpdu(port_index, vlan_id,
 				(unsigned char *) &bpdu_packet,
 				pkt_len);
@@ -153,17 +151,15 @@ static int txTcn(STATE_MACH_T *this)
 static void build_config_bpdu(PORT_T* port, Bool set_topo_ack_flag)
 {
 	bpdu_packet.body.flags = 0;
-	if (port->tcWhile) {
-#ifdef STP_DBG
-		if (port->topoch->debug) {
+	if (PORT_TIMER(port, tcWhile)) {
+		if (STP_TRACING(port->topoch)) {
 			stp_trace("tcWhile=%d =>tx TOPOLOGY_CHANGE_BIT to port %s",
-				  (int) port->tcWhile, port->port_name);
+				  (int) PORT_TIMER(port, tcWhile), port->port_name);
 		}
-#endif
 		bpdu_packet.body.flags |= TOPOLOGY_CHANGE_BIT;
 	}
 
-	if (set_topo_ack_flag && port->tcAck) {
+	if (set_topo_ack_flag && PORT_GET(port, tcAck)) {
 		bpdu_packet.body.flags |= TOPOLOGY_CHANGE_ACK_BIT;
 	}
 
@@ -199,7 +195,7 @@ static int txConfig(STATE_MACH_T *this)
 #endif
 
 	port = this->owner.port;
-	if (port->admin_non_stp) {
+	if (PORT_GET(port, admin_non_stp)) {
 		return 1;
 	}
 	port_index = port->port_index;
@@ -210,13 +206,11 @@ static int txConfig(STATE_MACH_T *this)
 				    sizeof (BPDU_HEADER_T) + sizeof (BPDU_BODY_T));
 	build_config_bpdu(port, True);
 
-#ifdef STP_DBG
-	if (this->debug) {
+	if (STP_TRACING(this)) {
 		stp_trace("port %s txConfig flags=0X%lx",
 			  port->port_name,
 			  (unsigned long)bpdu_packet.body.flags);
 	}
-#endif
 	return STP_OUT_tx_bpdu(port_index, vlan_id,
 			       (unsigned char *) &bpdu_packet,
 			       pkt_len);
@@ -261,7 +255,7 @@ static int txRstp(STATE_MACH_T *this)
 #endif
 
 	port = this->owner.port;
-	if (port->admin_non_stp) {
+	if (PORT_GET(port, admin_non_stp)) {
 		return 1;
 	}
 	port_index = port->port_index;
@@ -293,14 +287,14 @@ static int txRstp(STATE_MACH_T *this)
 
 	bpdu_packet.body.flags |= (role << PORT_ROLE_OFFS);
 #ifndef ORIG
-	if (port->forwarding) {
+	if (PORT_GET(port, forwarding)) {
 		bpdu_packet.body.flags |= FORWARD_BIT;
 	}
-	if (port->learning) {
+	if (PORT_GET(port, learning)) {
 		bpdu_packet.body.flags |= LEARN_BIT;
 	}
 #endif
-	if (port->synced) {
+	if (PORT_GET(port, synced)) {
 #if 0 /* def STP_DBG */
 		if (port->roletrns->debug) {
 			stp_trace ("tx AGREEMENT_BIT to port %s", port->port_name);
@@ -309,7 +303,7 @@ static int txRstp(STATE_MACH_T *this)
 		bpdu_packet.body.flags |= AGREEMENT_BIT;
 	}
 
-	if (port->proposing) {
+	if (PORT_GET(port, proposing)) {
 #if 0 /* def STP_DBG */
 		if (port->roletrns->debug) {
 			stp_trace ("tx PROPOSAL_BIT to port %s", port->port_name);
@@ -318,13 +312,11 @@ static int txRstp(STATE_MACH_T *this)
 		bpdu_packet.body.flags |= PROPOSAL_BIT;
 	}
 
-#ifdef STP_DBG
-	if (this->debug) {
+	if (STP_TRACING(this)) {
 		stp_trace("port %s txRstp flags=0X%lx",
 			  port->port_name,
 			  (unsigned long) bpdu_packet.body.flags);
 	}
-#endif
 
 	return STP_OUT_tx_bpdu(port_index, vlan_id,
 			       (unsigned char *) &bpdu_packet,
@@ -338,33 +330,33 @@ void STP_transmit_enter_state(STATE_MACH_T *this)
 	switch (this->State) {
 		case BEGIN:
 		case TRANSMIT_INIT:
-			port->newInfo = True;
-			port->txCount = 0;
+			PORT_SET(port, newInfo);
+			PORT_TIMER(port, txCount) = 0;
 			break;
 		case TRANSMIT_PERIODIC:
-			port->newInfo = port->newInfo ||
+			PORT_PUT(port, newInfo, PORT_GET(port, newInfo) ||
 			((port->role == DesignatedPort) ||
-			((port->role == RootPort) && (port->tcWhile != 0)));
+			((port->role == RootPort) && (PORT_TIMER(port, tcWhile) != 0))));
 			break;
 		case IDLE:
-			port->helloWhen = port->owner->rootTimes.HelloTime;
+			PORT_TIMER(port, helloWhen) = port->owner->rootTimes.HelloTime;
 			break;
 		case TRANSMIT_RSTP:
-			port->newInfo = False;
+			PORT_CLR(port, newInfo);
 			txRstp(this);
-			port->txCount++;
-			port->tcAck = False;
+			PORT_TIMER(port, txCount)++;
+			PORT_CLR(port, tcAck);
 			break;
 		case TRANSMIT_TCN:
-			port->newInfo = False;
+			PORT_CLR(port, newInfo);
 			txTcn(this);
-			port->txCount++;
+			PORT_TIMER(port, txCount)++;
 			break;
 		case TRANSMIT_CONFIG:
-			port->newInfo = False;
+			PORT_CLR(port, newInfo);
 			txConfig(this);
-			port->txCount++;
-			port->tcAck = False;
+			PORT_TIMER(port, txCount)++;
+			PORT_CLR(port, tcAck);
 			break;
 	};
 }
@@ -383,25 +375,32 @@ Bool STP_transmit_check_conditions (STATE_MACH_T* this)
 		case TRANSMIT_CONFIG:
 			return STP_hop_2_state (this, IDLE);
 		case IDLE:
-			if (port->selected && !port->updtInfo) {
-				if (port->helloWhen == 0) {
+			if (PORT_FLAGS_ARE(port, PORT_FLAG(selected) |
+						 PORT_FLAG(updtInfo),
+					   PORT_FLAG(selected))) {
+				if (PORT_TIMER(port, helloWhen) == 0) {
 					return STP_hop_2_state (this, TRANSMIT_PERIODIC);
 				}
-				if (!port->sendRSTP && port->newInfo &&
-				    (port->txCount < TxHoldCount) &&
+				if (PORT_FLAGS_ARE(port, PORT_FLAG(sendRSTP) |
+							 PORT_FLAG(newInfo),
+						   PORT_FLAG(newInfo)) &&
+				    (PORT_TIMER(port, txCount) < TxHoldCount) &&
 				    (port->role == DesignatedPort) &&
-				    (port->helloWhen != 0)) {
+				    (PORT_TIMER(port, helloWhen) != 0)) {
 					return STP_hop_2_state (this, TRANSMIT_CONFIG);
 				}
-				if (!port->sendRSTP && port->newInfo &&
-				    (port->txCount < TxHoldCount) &&
+				if (PORT_FLAGS_ARE(port, PORT_FLAG(sendRSTP) |
+							 PORT_FLAG(newInfo),
+						   PORT_FLAG(newInfo)) &&
+				    (PORT_TIMER(port, txCount) < TxHoldCount) &&
 				    (port->role == RootPort) &&
-				    (port->helloWhen != 0)) {
+				    (PORT_TIMER(port, helloWhen) != 0)) {
 					return STP_hop_2_state (this, TRANSMIT_TCN);
 				}
-				if (port->sendRSTP && port->newInfo &&
-				    (port->txCount < TxHoldCount) &&
-				    (port->helloWhen != 0)) {
+				if (PORT_ALL_FLAGS(port, PORT_FLAG(sendRSTP) |
+							 PORT_FLAG(newInfo)) &&
+				    (PORT_TIMER(port, txCount) < TxHoldCount) &&
+				    (PORT_TIMER(port, helloWhen) != 0)) {
 					return STP_hop_2_state (this, TRANSMIT_RSTP);
 				}
 			}
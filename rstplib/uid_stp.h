@@ -51,6 +51,8 @@ typedef struct {
 #define BR_CFG_AGE_MODE     (1L << 6)
 #define BR_CFG_AGE_TIME     (1L << 7)
 #define BR_CFG_HOLD_TIME    (1L << 8)
+#define BR_CFG_FLUSH_WINDOW (1L << 9)
+#define BR_CFG_RX_FAST      (1L << 10)
 #define BR_CFG_ALL BR_CFG_STATE     | \
                    BR_CFG_PRIO      | \
                    BR_CFG_AGE       | \
@@ -59,7 +61,9 @@ typedef struct {
                    BR_CFG_FORCE_VER | \
                    BR_CFG_AGE_MODE  | \
                    BR_CFG_AGE_TIME  | \
-                   BR_CFG_HOLD_TIME
+                   BR_CFG_HOLD_TIME | \
+                   BR_CFG_FLUSH_WINDOW | \
+                   BR_CFG_RX_FAST
 
 typedef struct {
 	/* service data */
@@ -74,6 +78,8 @@ typedef struct {
 	int forward_delay;
 	int force_version;
 	int hold_time;
+	int flush_window; /* seconds to gather the fdb flushes */
+	int rx_fast; /* repeated BPDUs skip the state machines */
 } UID_STP_CFG_T;
 
 typedef struct {
@@ -95,6 +101,17 @@ typedef struct {
 	int hello_time;
 	int forward_delay;
 	UID_BRIDGE_ID_T bridge_id;
+
+	unsigned long guard_evals;	/* state machine conditions checked */
+	unsigned long last_guard_evals;	/* by the last event */
+
+	unsigned long mem_bytes;	/* of the bridge, with its ports */
+
+	unsigned long flush_requests;	/* fdb flushes, the machines asked */
+	unsigned long flushed_ports;	/* in the flushed sets */
+	unsigned long flush_calls;	/* sets flushed */
+
+	unsigned long rx_fast_bpdus;	/* repeated BPDUs, that skipped the machines */
 } UID_STP_STATE_T;
 
 typedef enum {
@@ -107,6 +124,14 @@ typedef enum {
 
 typedef unsigned short UID_PORT_ID;
 
+/* Port Identifier (802.1t, 9.2.7): the port priority (a multiple of 16)
+ * in the upper 4 bits, the port number (1..4095) in the lower 12 bits */
+#define UID_PORT_ID_MAX_NUMBER		4095
+#define UID_PORT_ID(prio, number)	\
+	((UID_PORT_ID)((((prio) & 0xf0) << 8) | ((number) & 0x0fff)))
+#define UID_PORT_ID_PRIO(id)		(((id) >> 8) & 0xf0)
+#define UID_PORT_ID_NUMBER(id)		((id) & 0x0fff)
+
 typedef enum {
 	P2P_FORCE_TRUE,
 	P2P_FORCE_FALSE,
@@ -180,6 +205,7 @@ typedef struct {
 	unsigned long rx_cfg_bpdu_cnt;
 	unsigned long rx_rstp_bpdu_cnt;
 	unsigned long rx_tcn_bpdu_cnt;
+	unsigned long rx_fast_bpdu_cnt;	/* of the above, repeats on the fast path */
 	int edgeDelayWhile;	/* 17.17.1 */
 	int fdWhile;		/* 17.17.2 */
 	int helloWhen;		/* 17.17.3 */
@@ -198,6 +224,8 @@ typedef struct {
 	unsigned char oper_stp_neigb;
 	unsigned char top_change_ack;
 	unsigned char tc;
+
+	unsigned long mem_bytes;
 } UID_STP_PORT_STATE_T;
 
 #endif
@@ -26,21 +26,63 @@
 #include "stp_bpdu.h"
 #include "vector.h"
 
-int STP_VECT_compare_bridge_id(BRIDGE_ID *b1, BRIDGE_ID *b2) {
-	if (b1->prio < b2->prio) {
-		return -1;
+#define LOW_32	0xffffffffULL
+
+/* the bridge id as a number: priority, then the address */
+static PRIO_KEY_T stp_vect_bridge_key(IN BRIDGE_ID *b)
+{
+	return ((PRIO_KEY_T)b->prio << 48) |
+	       ((PRIO_KEY_T)b->addr[0] << 40) |
+	       ((PRIO_KEY_T)b->addr[1] << 32) |
+	       ((PRIO_KEY_T)b->addr[2] << 24) |
+	       ((PRIO_KEY_T)b->addr[3] << 16) |
+	       ((PRIO_KEY_T)b->addr[4] << 8) |
+	       (PRIO_KEY_T)b->addr[5];
+}
+
+static void stp_vect_key_2_bridge(IN PRIO_KEY_T key, OUT BRIDGE_ID *b)
+{
+	register int iii;
+
+	b->prio = (unsigned short)(key >> 48);
+	for (iii = 5; iii >= 0; iii--, key >>= 8) {
+		b->addr[iii] = (unsigned char)key;
+	}
+}
+
+/* N bytes in network order */
+static PRIO_KEY_T stp_vect_get_bytes(IN unsigned char *f, IN int n)
+{
+	PRIO_KEY_T key = 0;
+
+	while (n--) {
+		key = (key << 8) | *f++;
 	}
+	return key;
+}
 
-	if (b1->prio > b2->prio) {
-		return 1;
+static void stp_vect_set_bytes(IN PRIO_KEY_T key, IN int n,
+			       OUT unsigned char *t)
+{
+	while (n--) {
+		t[n] = (unsigned char)key;
+		key >>= 8;
 	}
+}
+
+/* -1, 0 or 1, without branches */
+#define KEY_CMP(A, B)	(((A) > (B)) - ((A) < (B)))
+
+int STP_VECT_compare_bridge_id(BRIDGE_ID *b1, BRIDGE_ID *b2) {
+	register PRIO_KEY_T k1 = stp_vect_bridge_key(b1);
+	register PRIO_KEY_T k2 = stp_vect_bridge_key(b2);
 
-	return memcmp(b1->addr, b2->addr, 6);
+	return KEY_CMP(k1, k2);
 }
 
 void STP_VECT_copy(OUT PRIO_VECTOR_T *t, IN PRIO_VECTOR_T *f)
 {
-	memcpy(t, f, sizeof(PRIO_VECTOR_T));
+	*t = *f;
 }
 
 void STP_VECT_create(OUT PRIO_VECTOR_T *t,
@@ -50,100 +92,71 @@ void STP_VECT_create(OUT PRIO_VECTOR_T *t,
 		     IN PORT_ID design_port,
 		     IN PORT_ID bridge_port)
 {
-	memcpy(&t->root_bridge, root_br, sizeof(BRIDGE_ID));
-	t->root_path_cost = root_path_cost;
-	memcpy(&t->design_bridge, design_bridge, sizeof(BRIDGE_ID));
-	t->design_port = design_port;
-	t->bridge_port = bridge_port;
+	register PRIO_KEY_T design = stp_vect_bridge_key(design_bridge);
+
+	t->key[0] = stp_vect_bridge_key(root_br);
+	t->key[1] = ((root_path_cost & LOW_32) << 32) | (design >> 32);
+	t->key[2] = ((design & LOW_32) << 32) |
+		    ((PRIO_KEY_T)design_port << 16) | bridge_port;
 }
 
-int STP_VECT_compare_vector(PRIO_VECTOR_T *v1, PRIO_VECTOR_T *v2)
+void STP_VECT_get_root_bridge(IN PRIO_VECTOR_T *v, OUT BRIDGE_ID *br_id)
 {
-	int bridcmp;
-
-	bridcmp = STP_VECT_compare_bridge_id(&v1->root_bridge,
-					     &v2->root_bridge);
-	if (bridcmp < 0) {
-		return bridcmp;
-	}
-
-	if (!bridcmp) {
-		bridcmp = v1->root_path_cost - v2->root_path_cost;
-		if (bridcmp < 0)
-			return bridcmp;
-		if (!bridcmp) {
-			bridcmp = STP_VECT_compare_bridge_id(
-				  &v1->design_bridge, &v2->design_bridge);
-			if (bridcmp < 0) {
-				return bridcmp;
-			}
-			if (!bridcmp) {
-				bridcmp = v1->design_port - v2->design_port;
-				if (bridcmp < 0) {
-					return bridcmp;
-				}
-				if (!bridcmp) {
-					return v1->bridge_port
-						- v2->bridge_port;
-				}
-			}
-		}
-	}
+	stp_vect_key_2_bridge(v->key[0], br_id);
+}
 
-	return bridcmp;
+void STP_VECT_get_design_bridge(IN PRIO_VECTOR_T *v, OUT BRIDGE_ID *br_id)
+{
+	stp_vect_key_2_bridge((v->key[1] << 32) | (v->key[2] >> 32), br_id);
 }
 
-static unsigned short stp_vect_get_short(IN unsigned char *f)
+void STP_VECT_set_root_path_cost(INOUT PRIO_VECTOR_T *v,
+				 IN unsigned long root_path_cost)
 {
-	return ntohs(*(unsigned short *)f);
+	v->key[1] = ((root_path_cost & LOW_32) << 32) | (v->key[1] & LOW_32);
 }
 
-static void stp_vect_set_short(IN unsigned short f, OUT unsigned char *t)
+void STP_VECT_set_bridge_port(INOUT PRIO_VECTOR_T *v, IN PORT_ID bridge_port)
 {
-	*(unsigned short *)t = htons(f);
+	v->key[2] = (v->key[2] & ~(PRIO_KEY_T)0xffff) | bridge_port;
 }
 
-static void stp_vect_get_bridge_id(IN unsigned char *c_br,
-				   OUT BRIDGE_ID *bridge_id)
+/* Same designated bridge and designated port */
+Bool STP_VECT_same_designated(IN PRIO_VECTOR_T *v1, IN PRIO_VECTOR_T *v2)
 {
-	bridge_id->prio = stp_vect_get_short(c_br);
-	memcpy(bridge_id->addr, c_br + 2, 6);
+	return !(((v1->key[1] ^ v2->key[1]) & LOW_32) |
+		 ((v1->key[2] ^ v2->key[2]) >> 16));
 }
 
-static void stp_vect_set_bridge_id(IN BRIDGE_ID *bridge_id,
-				   OUT unsigned char *c_br)
+/* The sign tells, which vector is better (less); the first word, that
+ * differs, decides */
+int STP_VECT_compare_vector(PRIO_VECTOR_T *v1, PRIO_VECTOR_T *v2)
 {
-	stp_vect_set_short(bridge_id->prio, c_br);
-	memcpy(c_br + 2, bridge_id->addr, 6);
+	return 4 * KEY_CMP(v1->key[0], v2->key[0]) +
+	       2 * KEY_CMP(v1->key[1], v2->key[1]) +
+	       KEY_CMP(v1->key[2], v2->key[2]);
 }
 
 void STP_VECT_get_vector(IN BPDU_BODY_T *b, OUT PRIO_VECTOR_T *v)
 {
-	stp_vect_get_bridge_id(b->root_id, &v->root_bridge);
-
-	v->root_path_cost = ntohl(*((long*) b->root_path_cost));
-
-	stp_vect_get_bridge_id(b->bridge_id, &v->design_bridge);
-
-	v->design_port = stp_vect_get_short(b->port_id);
+	/* the bridge port is not in the BPDU, it is kept */
+	v->key[0] = stp_vect_get_bytes(b->root_id, 8);
+	v->key[1] = (stp_vect_get_bytes(b->root_path_cost, 4) << 32) |
+		    stp_vect_get_bytes(b->bridge_id, 4);
+	v->key[2] = (stp_vect_get_bytes(b->bridge_id + 4, 4) << 32) |
+		    (stp_vect_get_bytes(b->port_id, 2) << 16) |
+		    (v->key[2] & 0xffff);
 }
 
 void STP_VECT_set_vector(IN PRIO_VECTOR_T *v, OUT BPDU_BODY_T *b)
 {
-	unsigned long root_path_cost;
-
-	stp_vect_set_bridge_id(&v->root_bridge, b->root_id);
-
-	root_path_cost = htonl(v->root_path_cost);
-	memcpy(b->root_path_cost, &root_path_cost, 4);
-
-	stp_vect_set_bridge_id(&v->design_bridge, b->bridge_id);
-
-	stp_vect_set_short(v->design_port, b->port_id);
+	stp_vect_set_bytes(v->key[0], 8, b->root_id);
+	stp_vect_set_bytes(v->key[1] >> 32, 4, b->root_path_cost);
+	stp_vect_set_bytes(v->key[1], 4, b->bridge_id);
+	stp_vect_set_bytes(v->key[2] >> 32, 4, b->bridge_id + 4);
+	stp_vect_set_bytes(v->key[2] >> 16, 2, b->port_id);
 }
 
-#ifdef STP_DBG
-
 void STP_VECT_br_id_print(IN char *title, IN BRIDGE_ID *br_id,
 			  IN Bool cr)
 {
@@ -161,20 +174,23 @@ void STP_VECT_br_id_print(IN char *title, IN BRIDGE_ID *br_id,
 
 void STP_VECT_print(IN char *title, IN PRIO_VECTOR_T *v)
 {
+	BRIDGE_ID br_id;
+
 	Print("%s:", title);
-	STP_VECT_br_id_print("rootBr", &v->root_bridge, False);
+	STP_VECT_get_root_bridge(v, &br_id);
+	STP_VECT_br_id_print("rootBr", &br_id, False);
 
 	/****
-	 Print(" rpc=%ld ", (long) v->root_path_cost);
+	 Print(" rpc=%ld ", (long) STP_VECT_ROOT_PATH_COST(v));
 	 ****/
 
-	STP_VECT_br_id_print("designBr", &v->design_bridge, False);
+	STP_VECT_get_design_bridge(v, &br_id);
+	STP_VECT_br_id_print("designBr", &br_id, False);
 
 	/****/
 	Print(" dp=%lx bp=%lx ",
-	      (unsigned long) v->design_port,
-	      (unsigned long) v->bridge_port);
+	      (unsigned long) STP_VECT_DESIGN_PORT(v),
+	      (unsigned long) STP_VECT_BRIDGE_PORT(v));
 	/***********/
 	Print("\n");
 }
-#endif
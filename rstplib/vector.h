@@ -33,14 +33,24 @@ typedef struct bridge_id {
 
 typedef unsigned short PORT_ID;
 
+typedef unsigned long long PRIO_KEY_T;
+
+/* A priority vector is kept packed, as three words, most significant
+ * first, so that comparing the words as integers is comparing the
+ * vectors (17.6):
+ *   key[0]: root bridge id (priority, address)
+ *   key[1]: root path cost (32 bits), designated bridge priority,
+ *           designated bridge address bytes 0-1
+ *   key[2]: designated bridge address bytes 2-5, designated port id,
+ *           bridge port id */
 typedef struct prio_vector_t {
-	BRIDGE_ID root_bridge;
-	unsigned long root_path_cost;
-	BRIDGE_ID design_bridge;
-	PORT_ID design_port;
-	PORT_ID bridge_port;
+	PRIO_KEY_T key[3];
 } PRIO_VECTOR_T;
 
+#define STP_VECT_ROOT_PATH_COST(V)	((unsigned long)((V)->key[1] >> 32))
+#define STP_VECT_DESIGN_PORT(V)		((PORT_ID)((V)->key[2] >> 16))
+#define STP_VECT_BRIDGE_PORT(V)		((PORT_ID)(V)->key[2])
+
 void STP_VECT_create(OUT PRIO_VECTOR_T *t,
 		     IN BRIDGE_ID *root_br,
 		     IN unsigned long root_path_cost,
@@ -49,6 +59,17 @@ void STP_VECT_create(OUT PRIO_VECTOR_T *t,
 		     IN PORT_ID bridge_port);
 void STP_VECT_copy(OUT PRIO_VECTOR_T *t, IN PRIO_VECTOR_T *f);
 
+void STP_VECT_get_root_bridge(IN PRIO_VECTOR_T *v, OUT BRIDGE_ID *br_id);
+
+void STP_VECT_get_design_bridge(IN PRIO_VECTOR_T *v, OUT BRIDGE_ID *br_id);
+
+void STP_VECT_set_root_path_cost(INOUT PRIO_VECTOR_T *v,
+				 IN unsigned long root_path_cost);
+
+void STP_VECT_set_bridge_port(INOUT PRIO_VECTOR_T *v, IN PORT_ID bridge_port);
+
+Bool STP_VECT_same_designated(IN PRIO_VECTOR_T *v1, IN PRIO_VECTOR_T *v2);
+
 int STP_VECT_compare_bridge_id(IN BRIDGE_ID *b1, IN BRIDGE_ID *b2);
 
 int STP_VECT_compare_vector(IN PRIO_VECTOR_T *v1, IN PRIO_VECTOR_T *v2);
@@ -57,11 +78,8 @@ void STP_VECT_get_vector(IN BPDU_BODY_T *b, OUT PRIO_VECTOR_T *v);
 
 void STP_VECT_set_vector(IN PRIO_VECTOR_T *v, OUT BPDU_BODY_T *b);
 
-#ifdef STP_DBG
 void STP_VECT_print(IN char *title, IN PRIO_VECTOR_T *v);
 
 void STP_VECT_br_id_print(IN char *title, IN BRIDGE_ID *br_id, IN Bool cr);
 
-#endif
-
 #endif /* _PRIO_VECTOR_H__ */
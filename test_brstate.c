@@ -0,0 +1,220 @@
+/*****************************************************************************
+  This program is free software; you can redistribute it and/or modify it
+  under the terms of the GNU General Public License as published by the Free
+  Software Foundation; either version 2 of the License, or (at your option)
+  any later version.
+
+  This program is distributed in the hope that it will be useful, but WITHOUT
+  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+  more details.
+
+  You should have received a copy of the GNU General Public License along with
+  this program; if not, write to the Free Software Foundation, Inc., 59
+  Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+  The full GNU General Public License is included in this distribution in the
+  file called LICENSE.
+
+******************************************************************************/
+
+/* The port state writes of brstate.c (make check): linked with
+   --wrap=rtnl_send,--wrap=rtnl_listen, so that the state socket can
+   refuse requests and the kernel's replies come from here. A write the
+   socket refused must still reach the kernel, in the order it was
+   asked for. */
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <net/if.h>
+#include <linux/if_bridge.h>
+
+#include "libnetlink.h"
+
+#include "bridge_ctl.h"
+#include "epoll_loop.h"
+#include "log.h"
+
+#define MAX_SENT 1024
+
+#define TEST_CHECK(COND)						\
+	do {								\
+		if (!(COND)) {						\
+			test_failed++;					\
+			printf("%s:%d: FAILED: %s\n",			\
+			       __FILE__, __LINE__, #COND);		\
+		}							\
+	} while (0)
+
+extern void bridge_state_ev_handler(uint32_t events,
+				    struct epoll_event_handler *h);
+
+struct rtnl_handle rth_state;
+int log_level = LOG_LEVEL_NONE;
+
+static int test_failed;
+static int test_refuse;		/* rtnl_send fails with EAGAIN */
+
+/* The requests, that the socket took, the first test_answered of them
+   are answered */
+static struct {
+	__u32 seq;
+	int type;
+	int ifindex;
+	int state;
+} sent[MAX_SENT];
+static int test_sent, test_answered;
+
+void Dprintf(int level, const char *fmt, ...)
+{
+	va_list ap;
+
+	if (level > log_level)
+		return;
+	va_start(ap, fmt);
+	vprintf(fmt, ap);
+	printf("\n");
+	va_end(ap);
+}
+
+int __wrap_rtnl_send(struct rtnl_handle *rth, const char *buf, int len)
+{
+	struct nlmsghdr *n = (struct nlmsghdr *)buf;
+	struct ifinfomsg *ifi = NLMSG_DATA(n);
+	struct rtattr *tb[IFLA_MAX + 1];
+
+	if (test_refuse) {
+		errno = EAGAIN;
+		return -1;
+	}
+	parse_rtattr(tb, IFLA_MAX, IFLA_RTA(ifi),
+		     n->nlmsg_len - NLMSG_LENGTH(sizeof(*ifi)));
+	sent[test_sent].seq = n->nlmsg_seq;
+	sent[test_sent].type = n->nlmsg_type;
+	sent[test_sent].ifindex = ifi->ifi_index;
+	sent[test_sent].state = tb[IFLA_PROTINFO] ?
+		*(__u32 *) RTA_DATA(tb[IFLA_PROTINFO]) : -1;
+	test_sent++;
+	return len;
+}
+
+/* Acks every sent request, that is not answered yet */
+int __wrap_rtnl_listen(struct rtnl_handle *rth, rtnl_filter_t handler,
+		       void *jarg)
+{
+	struct {
+		struct nlmsghdr n;
+		struct nlmsgerr e;
+	} ack;
+
+	for (; test_answered < test_sent; test_answered++) {
+		memset(&ack, 0, sizeof(ack));
+		ack.n.nlmsg_len = NLMSG_LENGTH(sizeof(ack.e));
+		ack.n.nlmsg_type = NLMSG_ERROR;
+		ack.n.nlmsg_seq = sent[test_answered].seq;
+		handler(NULL, &ack.n, jarg);
+	}
+	return 0;
+}
+
+static void test_replies(void)
+{
+	bridge_state_ev_handler(0, NULL);
+}
+
+/* The writes, that the socket took, from the first one */
+static int test_sent_is(int first, int count, const int *ifindex,
+			const int *state)
+{
+	int i;
+
+	if (test_sent != first + count)
+		return 0;
+	for (i = 0; i < count; i++) {
+		if (sent[first + i].type != RTM_SETLINK ||
+		    sent[first + i].ifindex != ifindex[i] ||
+		    sent[first + i].state != state[i])
+			return 0;
+		if (first + i && sent[first + i].seq <= sent[first + i - 1].seq)
+			return 0;
+	}
+	return 1;
+}
+
+/* The socket refuses a write: it is kept and sent on the next retry */
+static void test_refused_write(void)
+{
+	static const int ifindex[] = { 5, 6 };
+	static const int state[] = { BR_STATE_BLOCKING, BR_STATE_FORWARDING };
+
+	test_refuse = 1;
+	bridge_set_state(5, BR_STATE_BLOCKING);
+	bridge_set_state(6, BR_STATE_FORWARDING);
+	TEST_CHECK(test_sent == 0);
+	TEST_CHECK(bridge_state_pending(5));
+	TEST_CHECK(bridge_state_pending(6));
+
+	bridge_state_retry();		/* still refused */
+	TEST_CHECK(test_sent == 0);
+
+	test_refuse = 0;
+	bridge_state_retry();
+	TEST_CHECK(test_sent_is(0, 2, ifindex, state));
+	test_replies();
+	TEST_CHECK(!bridge_state_pending(5));
+	TEST_CHECK(!bridge_state_pending(6));
+}
+
+/* A write is refused after others went: the later writes wait behind
+   it, the last state of a port is the last one sent for it */
+static void test_order(void)
+{
+	static const int ifindex[] = { 7, 8, 7 };
+	static const int state[] = {
+		BR_STATE_LEARNING, BR_STATE_BLOCKING, BR_STATE_FORWARDING
+	};
+	int first = test_sent;
+
+	bridge_set_state(7, BR_STATE_LEARNING);
+	test_refuse = 1;
+	bridge_set_state(8, BR_STATE_BLOCKING);
+	test_refuse = 0;
+	bridge_set_state(7, BR_STATE_FORWARDING);	/* waits behind 8 */
+	TEST_CHECK(test_sent == first + 3);
+	TEST_CHECK(test_sent_is(first, 3, ifindex, state));
+	test_replies();
+	TEST_CHECK(!bridge_state_pending(7));
+	TEST_CHECK(!bridge_state_pending(8));
+}
+
+/* The replies of the sent requests drain the unsent ones */
+static void test_drain(void)
+{
+	static const int ifindex[] = { 9, 10 };
+	static const int state[] = { BR_STATE_BLOCKING, BR_STATE_BLOCKING };
+	int first = test_sent;
+
+	bridge_set_state(9, BR_STATE_BLOCKING);
+	test_refuse = 1;
+	bridge_set_state(10, BR_STATE_BLOCKING);
+	test_refuse = 0;
+	TEST_CHECK(test_sent == first + 1);
+	test_replies();
+	TEST_CHECK(test_sent_is(first, 2, ifindex, state));
+	test_replies();
+	TEST_CHECK(!bridge_state_pending(10));
+}
+
+int main(int argc, char **argv)
+{
+	test_refused_write();
+	test_order();
+	test_drain();
+
+	printf("test_brstate: %s\n", test_failed ? "FAILED" : "passed");
+	return test_failed ? 1 : 0;
+}